@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string.h>
 #include "../shared/Utility.h"
+#include "../shared/WaveSampleTypes.h"
 
 using namespace std;
 
@@ -28,7 +29,7 @@ void ArgParser::printUsage(const char *name)
 	cout << "usually could need a bit of variation to get it 'right'.\n\n";
 	cout << "Usage:\t" << name << " <WAV file> [-o <output file] [-sine] [-extremums]\n";
 	cout << "\t [-a <#samples>] [-d <threshold>] [-p <distance>] [-m]\n"; 
-	cout << "\t [-sl <saturation level>] [-sh <saturation high>] [-v]\n";
+	cout << "\t [-sl <saturation level>] [-sh <saturation high>] [-ds <sample rate>] [-v]\n";
 	cout << "\n";
 	cout << "If no output file is specified, the output file name will default to the\n";
 	cout << "input file name (excluding extension) suffixed with '_out.wav'.\n\n";
@@ -54,6 +55,10 @@ void ArgParser::printUsage(const char *name)
 	cout << "\tDefault: 0.8\n";
 	cout << "\n";
 	cout << "-m:\n\tWill create a WAW file that includes both the original samples and the filtered ones.\n\n";
+	cout << "-ds <sample rate>:\n\tDecimate (anti-alias filter and downsample) a WAV file with a higher sample rate (e.g. 96 or 192 kHz)\n";
+	cout << "\tto about <sample rate> Hz before filtering it. The output file will then have the decimated sample rate.\n";
+	cout << "\tDefault: no decimation\n";
+	cout << "\n";
 	cout << "\n";
 }
 
@@ -142,6 +147,18 @@ ArgParser::ArgParser(int argc, const char* argv[])
 			else
 				ac++;
 		}
+		else if (strcmp(argv[ac], "-ds") == 0 && ac + 1 < argc) {
+			long freq = strtol(argv[ac + 1], NULL, 10);
+			if (freq < 4 * F2_FREQ) {
+				cout << "-ds without a valid sample rate (at least " << 4 * F2_FREQ << " Hz)\n";
+				printUsage(argv[0]);
+				return;
+			}
+			else {
+				decimationFreq = (int) freq;
+				ac++;
+			}
+		}
 		else {
 			cout << "Unknown option " << argv[ac] << "\n";
 			printUsage(argv[0]);
@@ -25,6 +25,7 @@ public:
 	double derivativeThreshold = 10;
 	bool outputMultipleChannels = false;
 	FilterType filterType = SCALE;
+	int decimationFreq = 0; // Sample rate to decimate high sample rate WAV files to before filtering (0 <=> no decimation)
 
 	Logging logging;
 
@@ -15,6 +15,7 @@ using namespace std::filesystem;
 
 #include "../shared/CommonTypes.h"
 #include "../shared/PcmFile.h"
+#include "../shared/Decimator.h"
 #include "ArgParser.h"
 #include "Filter.h"
 
@@ -62,6 +63,22 @@ int main(int argc, const char* argv[])
     if (arg_parser.logging.verbose)
         cout << "Elapsed time: " << dt.count() << " seconds...\n";
 
+    // Decimate high sample rate samples (the filtering and the output file will then use the decimated sample rate)
+    if (arg_parser.decimationFreq > 0 && sample_freq > arg_parser.decimationFreq) {
+        t_start = chrono::system_clock::now();
+        Decimator decimator(sample_freq, arg_parser.decimationFreq, arg_parser.logging);
+        Samples decimated_samples;
+        decimator.decimate(*original_samples_p, decimated_samples);
+        *original_samples_p = move(decimated_samples);
+        sample_freq = decimator.outputFreq();
+        if (arg_parser.logging.verbose)
+            cout << "Samples decimated to " << sample_freq << " Hz...\n";
+        t_end = chrono::system_clock::now();
+        dt = t_end - t_start;
+        if (arg_parser.logging.verbose)
+            cout << "Elapsed time: " << dt.count() << " seconds...\n";
+    }
+
     
 
     // Initialise sample filter
@@ -17,9 +17,16 @@ void ArgParser::printUsage(const char* name)
 	cout << "Scans a disc image file for program files and generates either a set of\n";
 	cout << "files of different formats per detected program or a new tape file\n";
 	cout << "with the content being the detected (and selected) programs.\n\n";
-	cout << "Usage:\t" << name << " <Disc file> [-v] [-bbm] [-n <program>]\n";
-	cout << " \t -g <dir> | -uef <file> | -wav <file> | -csw <file> | -tap <file> | -c\n\n";
-	cout << "<Disc file>:\n\tAcorn DFS disc file to decode.\n\n";
+	cout << "Usage:\t" << name << " <Disc file> [-d <disc>] [-v] [-bbm] [-n <program>]\n";
+	cout << " \t -g <dir> | -uef <file> | -wav <file> | -csw <file> | -tap <file> | -c\n";
+	cout << "\t" << name << " <Disc dir> | <MMB file> [-v] [-bbm] [-n <program>] [-j <threads>] [-g <dir> | -c]\n\n";
+	cout << "<Disc file>:\n\tAcorn DFS disc file (SSD/DSD or MMB) to decode.\n\n";
+	cout << "<Disc dir> | <MMB file>:\n\tAll SSD/DSD disc files of a directory tree or all discs of an MMB file\n";
+	cout << "\tare decoded in parallel (archive mode). The files of each disc are generated in a sub\n";
+	cout << "\tdirectory of their own and a summary is written to 'scan_summary.log'.\n\n";
+	cout << "-d <disc>:\n\tDisc (title or slot no) to decode when the disc file is an MMB file.\n";
+	cout << "\tThe disc is read directly from the MMB file without extracting it first.\n\n";
+	cout << "-j <threads>:\n\tNo of threads used in archive mode - default is one per hardware thread\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
 	cout << "-bbm:\n\tScan for BBC Micro (default is Acorn Atom)\n\n";
 	cout << "-n <program>:\n\tOnly search for (and extract) <program>.\n\n";
@@ -70,6 +77,19 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		else if (strcmp(argv[ac], "-c") == 0) {
 			cat = true;
 		}
+		else if (strcmp(argv[ac], "-d") == 0 && ac + 1 < argc) {
+			MMBDisc = argv[ac + 1];
+			ac++;
+		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				nThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-n") == 0) {
 			searchedProgram = argv[ac + 1];
 			ac++;
@@ -130,6 +150,19 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		return;
 	}
 
+	bool MMB_file = (Utility::getFileExt(srcFileName) == ".mmb");
+	archiveMode = filesystem::is_directory(fin_path) || (MMB_file && MMBDisc == "");
+	if (archiveMode && (int)genUEF + (int)genWAV + (int)genCSW + (int)genTAP > 0) {
+		cout << "Options -uef, -wav, -csw and -tap can't be used when scanning a directory or a complete MMB file!\n";
+		printUsage(argv[0]);
+		return;
+	}
+	if (!MMB_file && MMBDisc != "") {
+		cout << "Option -d can only be specified for an MMB file!\n";
+		printUsage(argv[0]);
+		return;
+	}
+
 	if (cat && argc < 3) {
 		printUsage(argv[0]);
 		return;
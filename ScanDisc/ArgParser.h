@@ -32,6 +32,12 @@ public:
 
 	string searchedProgram = "";
 
+	string MMBDisc = ""; // disc (title or slot no) to scan when the disc file is an MMB file
+
+	// Archive mode - all discs of a directory tree or of an MMB file scanned in parallel
+	bool archiveMode = false;
+	int nThreads = 0; // No of threads (0 <=> one per hardware thread)
+
 	TargetMachine targetMachine = ACORN_ATOM;
 
 private:
@@ -5,6 +5,9 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include <set>
+#include <atomic>
+#include <algorithm>
 
 #include <math.h>
 
@@ -20,13 +23,299 @@
 #include "../shared/CSWCodec.h"
 #include "../shared/WavEncoder.h"
 #include "../shared/DiscCodec.h"
+#include "../shared/MMBView.h"
 #include "../shared/BinCodec.h"
+#include "../shared/WorkerPool.h"
 
 using namespace std;
 using namespace std::filesystem;
 
+// A disc of an archive - either a disc image file or a disc slot of an MMB file
+class ArchiveDisc {
+public:
+    string name; // disc image file or MMB disc title
+    string discFile = "";
+    int slotNo = -1;
+    string outputDir;
+};
+
+// Outcome of scanning one disc (as reported in the archive mode summary)
+class DiscScanResult {
+public:
+    bool success = false;
+    int nFiles = 0;
+    int nFailedFiles = 0; // No of files for which not all output files could be generated
+};
+
+//
+// Decode the files of a disc into the internal Tape File format (only the searched
+// program if one is searched for)
+//
+void readDiscFiles(Disc& disc, ArgParser& arg_parser, vector<TapeFile>& tape_files)
+{
+    for (int side = 0; side < disc.side.size(); side++) {
+
+        for (int file_no = 0; file_no < disc.side[side].files.size(); file_no++) {
+
+            // Decode one disc file into the internal Tape File format
+            DiscFile& file = disc.side[side].files[file_no];
+            BinCodec BIN_Codec(arg_parser.logging);
+            TapeFile tape_file(arg_parser.targetMachine);
+            FileHeader file_header(file.dir + "." + file.name, file.loadAdr, file.execAdr, file.size, arg_parser.targetMachine, file.locked);
+            if (!BIN_Codec.decode(file_header, file.bytes(), file.nBytes(), tape_file)) {
+                cout << "Failed to decode disc file '" << file.name << "'\n";
+                //return false;
+            }
+            else {
+                // If the file was read with some content (even if there were some errors), then add it to the list of tape files
+                if (
+                    tape_file.blocks.size() > 0 &&
+                    (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram)
+                )
+                    tape_files.push_back(move(tape_file));
+            }
+            
+        }
+    }
+}
+
+//
+// Generate the different types of files (DATA, ABC/BBC, TAP, UEF, BIN & INF) for a decoded file
+//
+bool generateFiles(TapeFile& tape_file, ArgParser& arg_parser, string dstDir, UEFCodec& UEF_encoder)
+{
+    bool success = true;
+
+    // Creata DATA file
+    DataCodec DATA_codec = DataCodec(arg_parser.logging);
+    string DATA_file_name = Utility::crEncodedFileNamefromDir(dstDir, tape_file, "dat");
+    if (!DATA_codec.encode(tape_file, DATA_file_name)) {
+        cout << "Failed to write the DATA file!\n";
+        success = false;
+    }
+
+    // Creata ABC/BBC program file
+    AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
+    string ABC_file_name = Utility::crEncodedProgramFileNamefromDir(dstDir, arg_parser.targetMachine, tape_file);
+    if (!ABC_codec.detokenise(tape_file, ABC_file_name)) {
+        cout << "Failed to write the program file!\n";
+        success = false;
+    }
+
+    // Create TAP file
+    TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
+    string TAP_file_name = Utility::crEncodedFileNamefromDir(dstDir, tape_file, "tap");
+    if (!TAP_codec.encode(tape_file, TAP_file_name)) {
+        cout << "Failed to write the TAP file!\n";
+        success = false;
+    }
 
 
+    // Create UEF file
+    string UEF_file_name = Utility::crEncodedFileNamefromDir(dstDir, tape_file, "uef");
+    if (!UEF_encoder.encode(tape_file, UEF_file_name)) {
+        cout << "Failed to write the UEF file!\n";
+        success = false;
+    }
+
+    // Create BIN file
+    string BIN_file_name = Utility::crEncodedFileNamefromDir(dstDir, tape_file, "");
+    BinCodec BIN_codec(arg_parser.logging);
+    if (!BIN_codec.encode(tape_file, BIN_file_name)) {
+        cout << "can't create Binary file " << BIN_file_name << "\n";
+        success = false;
+    }
+
+    // Create INF file
+    if (!BinCodec::generateInfFile(dstDir, tape_file)) {
+        cout << "Failed to write the INF file!\n";
+        success = false;
+    }
+
+    return success;
+}
+
+//
+// Collect the discs of an archive - all SSD/DSD disc images of a directory tree (in path order) or
+// all formatted discs of an MMB file (in slot order) - and give each disc its own output sub directory
+//
+bool collectArchiveDiscs(ArgParser& argParser, MMBView& archiveMMB, vector<ArchiveDisc>& discs)
+{
+    if (is_directory(argParser.srcFileName)) {
+        for (auto const& dir_entry : recursive_directory_iterator(argParser.srcFileName)) {
+            string ext = Utility::getFileExt(dir_entry.path().string());
+            if (dir_entry.is_regular_file() && (ext == ".ssd" || ext == ".dsd")) {
+                ArchiveDisc disc;
+                disc.name = dir_entry.path().string();
+                disc.discFile = disc.name;
+                discs.push_back(disc);
+            }
+        }
+        // Directory iteration order is unspecified so sort to get a deterministic order
+        sort(discs.begin(), discs.end(), [](const ArchiveDisc& a, const ArchiveDisc& b) { return a.name < b.name; });
+    }
+    else {
+        if (!archiveMMB.open(argParser.srcFileName))
+            return false;
+        for (int s = 0; s < archiveMMB.nSlots(); s++) {
+            MMBSlot& slot = archiveMMB.slot(s);
+            if ((slot.status == MMB_RW || slot.status == MMB_LOCKED) && slot.complete()) {
+                ArchiveDisc disc;
+                disc.name = slot.uniqueTitle;
+                disc.slotNo = s;
+                discs.push_back(disc);
+            }
+        }
+    }
+
+    if (argParser.cat)
+        return true;
+
+    // Create one output sub directory per disc (named as the disc - and for a directory tree, in the same
+    // relative location - but unique)
+    set<string> dir_names;
+    for (int d = 0; d < discs.size(); d++) {
+        path dir_name;
+        if (discs[d].slotNo >= 0)
+            dir_name = Utility::crValidHostFileName(discs[d].name);
+        else {
+            path rel_path = relative(path(discs[d].discFile), path(argParser.srcFileName));
+            dir_name = rel_path.parent_path() / rel_path.stem();
+        }
+        path base_name = dir_name;
+        for (int k = 2; dir_names.count(dir_name.string()) > 0; k++)
+            dir_name = base_name.string() + "_" + to_string(k);
+        dir_names.insert(dir_name.string());
+        path out_dir = path(argParser.dstDir) / dir_name;
+        if (!exists(out_dir) && !create_directories(out_dir)) {
+            cout << "Failed to create output directory '" << out_dir.string() << "'!\n";
+            return false;
+        }
+        discs[d].outputDir = out_dir.string();
+    }
+
+    return true;
+}
+
+//
+// Scan all discs of an archive (a directory tree of disc images or an MMB file) in parallel (archive mode).
+//
+// Reading a disc (and decoding its files) is one job and generating the output files for one
+// decoded file is another job. Only as many discs as there are threads are in progress at
+// the same time - a disc job queues the output file jobs for its files before it queues the
+// job for the next disc. This bounds both the no of decoded files waiting for their output
+// files to be generated and the no of open files (a job has at most one disc image and one
+// output file open at the same time).
+//
+// The output files of each disc are put in their own sub directory and a summary of all scans is
+// written to 'scan_summary.log'.
+//
+int scanDiscs(ArgParser& argParser)
+{
+    MMBView MMB_view(argParser.logging); // must remain open as long as its discs are read
+    vector<ArchiveDisc> discs;
+    if (!collectArchiveDiscs(argParser, MMB_view, discs))
+        return -1;
+
+    int n_discs = (int) discs.size();
+    vector<DiscScanResult> results(n_discs);
+    vector<vector<TapeFile>> disc_files(n_discs);
+    vector<vector<char>> generated(n_discs);
+    vector<ostringstream> cat_outputs(n_discs);
+
+    {
+        WorkerPool pool(argParser.nThreads);
+        atomic<int> next_disc(0);
+
+        function<void()> scan_next_disc = [&]() {
+            int d = next_disc++;
+            if (d >= n_discs)
+                return;
+
+            // Read the disc and decode its files
+            DiscCodec DISC_codec = DiscCodec(argParser.logging);
+            Disc disc;
+            if (discs[d].slotNo >= 0) {
+                MMBSlot& slot = MMB_view.slot(discs[d].slotNo);
+                results[d].success = DISC_codec.read(slot.image, slot.imageSize, false, disc);
+            }
+            else
+                results[d].success = DISC_codec.read(discs[d].discFile, disc);
+            vector<TapeFile>& tape_files = disc_files[d];
+            readDiscFiles(disc, argParser, tape_files);
+            results[d].nFiles = (int) tape_files.size();
+
+            if (argParser.cat) {
+                for (int i = 0; i < tape_files.size(); i++) {
+                    cat_outputs[d] << (!tape_files[i].complete || tape_files[i].corrupted ? "***" : "   ");
+                    tape_files[i].logFileHdr(&cat_outputs[d]);
+                }
+                tape_files.clear();
+            }
+            else {
+                // Generate the output files for each decoded file
+                generated[d].resize(tape_files.size(), false);
+                for (int i = 0; i < tape_files.size(); i++) {
+                    pool.submit([&argParser, &discs, &disc_files, &generated, d, i] {
+                        UEFCodec UEF_encoder(false, argParser.logging, argParser.targetMachine);
+                        generated[d][i] = generateFiles(disc_files[d][i], argParser, discs[d].outputDir, UEF_encoder);
+                        disc_files[d][i] = TapeFile(argParser.targetMachine); // no longer needed
+                    });
+                }
+            }
+
+            pool.submit(scan_next_disc);
+        };
+
+        for (int i = 0; i < pool.size(); i++)
+            pool.submit(scan_next_disc);
+        pool.wait();
+    }
+
+    // Output catalogues in the order of the discs
+    if (argParser.cat) {
+        for (int d = 0; d < n_discs; d++)
+            cout << "\n" << discs[d].name << ":\n" << cat_outputs[d].str();
+    }
+
+    // Create summary log
+    ostream* sout_p = &cout;
+    ofstream summary_file;
+    if (!argParser.cat) {
+        path summary_path = path(argParser.dstDir) / "scan_summary.log";
+        summary_file.open(summary_path.string());
+        if (!summary_file) {
+            cout << "can't write to summary log file " << summary_path.string() << "\n";
+            return -1;
+        }
+        sout_p = &summary_file;
+    }
+
+    int n_failed = 0, n_files = 0;
+    *sout_p << "\n";
+    for (int d = 0; d < n_discs; d++) {
+        DiscScanResult& r = results[d];
+        r.nFailedFiles = (int) count(generated[d].begin(), generated[d].end(), false);
+        if (!r.success || r.nFailedFiles > 0)
+            n_failed++;
+        n_files += r.nFiles;
+        *sout_p << (r.success && r.nFailedFiles == 0 ? "OK     " : "FAILED ") << "'" << discs[d].name << "': " << dec << r.nFiles << " files";
+        if (r.nFailedFiles > 0)
+            *sout_p << " (" << r.nFailedFiles << " not completely converted)";
+        if (discs[d].outputDir != "")
+            *sout_p << " => '" << discs[d].outputDir << "'";
+        *sout_p << "\n";
+    }
+    *sout_p << "\n" << n_discs - n_failed << " of " << n_discs << " discs scanned successfully; " << n_files << " files found.\n";
+
+    if (!argParser.cat) {
+        summary_file.close();
+        cout << n_discs - n_failed << " of " << n_discs << " discs scanned successfully; " << n_files << " files found.\n";
+    }
+
+    return (n_failed == 0 ? 0 : -1);
+}
+
 /*
  *
  * Decode an Acorn DFS disc file
@@ -41,6 +330,9 @@ int main(int argc, const char* argv[])
     if (arg_parser.failed())
         return -1;
 
+    if (arg_parser.archiveMode)
+        return scanDiscs(arg_parser);
+
     // Create a log file
     ostream* fout_p = &cout;
     if (!arg_parser.cat) {
@@ -101,36 +393,27 @@ int main(int argc, const char* argv[])
 
     // Scan Disc for  files
     DiscCodec DISC_codec = DiscCodec(arg_parser.logging);
+    MMBView MMB_view(arg_parser.logging); // must remain open as long as the disc's files are used
     Disc disc;
-    DISC_codec.read(arg_parser.srcFileName, disc);
+    if (arg_parser.MMBDisc != "") {
+        // Read the disc directly from its slot in the MMB file
+        if (!MMB_view.open(arg_parser.srcFileName))
+            return -1;
+        int slot_no;
+        if (!MMB_view.findSlot(arg_parser.MMBDisc, slot_no)) {
+            cout << "No disc '" << arg_parser.MMBDisc << "' in MMB file '" << arg_parser.srcFileName << "'\n";
+            return -1;
+        }
+        MMBSlot& slot = MMB_view.slot(slot_no);
+        DISC_codec.read(slot.image, slot.imageSize, false, disc);
+    }
+    else
+        DISC_codec.read(arg_parser.srcFileName, disc);
 
     // Collect files from disc
     vector <TapeFile> tape_files;
     bool selected_file_found = false;
-    for (int side = 0; side < disc.side.size(); side++) {
-
-        for (int file_no = 0; file_no < disc.side[side].files.size(); file_no++) {
-
-            // Decode one disc file into the internal Tape File format
-            DiscFile& file = disc.side[side].files[file_no];
-            BinCodec BIN_Codec(arg_parser.logging);
-            TapeFile tape_file(arg_parser.targetMachine);
-            FileHeader file_header(file.dir + "." + file.name, file.loadAdr, file.execAdr, file.size, arg_parser.targetMachine, file.locked);
-            if (!BIN_Codec.decode(file_header, file.data, tape_file)) {
-                cout << "Failed to decode disc file '" << file.name << "'\n";
-                //return false;
-            }
-            else {
-                // If the file was read with some content (even if there were some errors), then add it to the list of tape files
-                if (
-                    tape_file.blocks.size() > 0 &&
-                    (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram)
-                )
-                    tape_files.push_back(tape_file);
-            }
-            
-        }
-    }
+    readDiscFiles(disc, arg_parser, tape_files);
 
 
     // Iterate over the collected files
@@ -141,53 +424,7 @@ int main(int argc, const char* argv[])
         if (!genTapeFile && !arg_parser.cat) {
 
             // Generate the different types of files (DATA, ABC/BBC, TAP, UEF, BIN) for the found file
-
-            // Creata DATA file
-            DataCodec DATA_codec = DataCodec(arg_parser.logging);
-            string DATA_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "dat");
-            if (!DATA_codec.encode(tape_file, DATA_file_name)) {
-                cout << "Failed to write the DATA file!\n";
-                //return -1;
-            }
-
-            // Creata ABC/BBC program file
-            AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
-            string ABC_file_name = Utility::crEncodedProgramFileNamefromDir(arg_parser.dstDir, arg_parser.targetMachine, tape_file);
-            if (!ABC_codec.detokenise(tape_file, ABC_file_name)) {
-                cout << "Failed to write the program file!\n";
-                //return -1;
-            }
-
-            // Create TAP file
-            TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
-            string TAP_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "tap");
-            if (!TAP_codec.encode(tape_file, TAP_file_name)) {
-                cout << "Failed to write the TAP file!\n";
-                //return -1;
-            }
-
-
-            // Create UEF file
-            string UEF_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "uef");
-            if (!UEF_encoder.encode(tape_file, UEF_file_name)) {
-                cout << "Failed to write the UEF file!\n";
-                //return -1;
-            }
-
-            // Create BIN file
-            string BIN_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "");
-            BinCodec BIN_codec(arg_parser.logging);
-            if (!BIN_codec.encode(tape_file, BIN_file_name)) {
-                cout << "can't create Binary file " << BIN_file_name << "\n";
-                //return -1;
-            }
-
-            // Create INF file
-            if (!BinCodec::generateInfFile(arg_parser.dstDir, tape_file)) {
-                cout << "Failed to write the INF file!\n";
-                //return -1;
-            }
-
+            (void) generateFiles(tape_file, arg_parser, arg_parser.dstDir, UEF_encoder);
         }
         
         else if (!genTapeFile && arg_parser.cat) {
@@ -17,12 +17,13 @@ void ArgParser::printUsage(const char* name)
 	cout << "Scans a TAP file ('Wouter Ras' format - see https://www.stairwaytohell.com/atom/wouterras/)\n";
 	cout << "for program files and generates either a set of files of different formats per detected\n";
 	cout << "program or a new tape or disc file with the content being the detected (and selected) programs.\n\n";
-	cout << "Usage:\t" << name << " <TAP file> [-v] [-bbm] [-n <program>]\n";
+	cout << "Usage:\t" << name << " <TAP file> [-v] [-bbm] [-n <program>] [-j <threads>]\n";
 	cout << " \t -g <dir> | -uef <file> | -wav <file> | -csw <file> | -ssd <file> | -c\n\n";
 	cout << "<TAP file>:\n\tTAP file to decode.\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
 	cout << "-bbm:\n\tScan for BBC Micro (default is Acorn Atom).\n\n";
 	cout << "-n <program>:\n\tOnly search for (and extract) <program>.\n\n";
+	cout << "-j <threads>:\n\tNo of threads used to generate the files - default is one per hardware thread\n\n";
 	cout << "-g <dir>:\n\tDirectory to put generated files in\n\t- default is work directory.\n\n";
 	cout << "-uef <file>:\n\tGenerate one UEF tape file with all successfully decoded programs.\n\n";
 	cout << "-csw <file>:\n\tGenerate one CSW tape file with all successfully decoded programs.\n\n";
@@ -73,6 +74,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		else if (strcmp(argv[ac], "-bbm") == 0) {
 			// Nothing to do as already handled above
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				nThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-n") == 0) {
 			searchedProgram = argv[ac + 1];
 			ac++;
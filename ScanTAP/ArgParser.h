@@ -32,6 +32,8 @@ public:
 
 	string searchedProgram = "";
 
+	int nThreads = 0; // No of threads (0 <=> one per hardware thread)
+
 	TargetMachine targetMachine = ACORN_ATOM;
 
 private:
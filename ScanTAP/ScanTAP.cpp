@@ -5,6 +5,7 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include <map>
 
 #include <math.h>
 
@@ -21,11 +22,123 @@
 #include "../shared/WavEncoder.h"
 #include "../shared/DiscCodec.h"
 #include "../shared/BinCodec.h"
+#include "../shared/WorkerPool.h"
 
 using namespace std;
 using namespace std::filesystem;
 
 
+//
+// Generate the different types of files (DATA, ABC/BBC, TAP, UEF, BIN & INF) for a file
+//
+bool generateFiles(TapeFile& tape_file, ArgParser& arg_parser, UEFCodec& UEF_encoder)
+{
+    bool success = true;
+
+    if (arg_parser.logging.verbose)
+        cout << "Tape File '" << tape_file.header.name <<
+        "' read. Base file name used for generated files is: '" << Utility::crValidHostFileName(tape_file.header.name) << "'.\n";
+
+    // Creata DATA file
+    DataCodec DATA_codec = DataCodec(arg_parser.logging);
+    string DATA_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "dat");
+    if (!DATA_codec.encode(tape_file, DATA_file_name)) {
+        cout << "Failed to write the DATA file!\n";
+        success = false;
+    }
+
+    // Creata ABC/BBC program file
+    AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
+    string ABC_file_name = Utility::crEncodedProgramFileNamefromDir(arg_parser.dstDir, arg_parser.targetMachine, tape_file);
+    if (!ABC_codec.detokenise(tape_file, ABC_file_name)) {
+        cout << "Failed to write the program file '" << ABC_file_name << "'!\n";
+        success = false;
+    }
+
+    // Create TAP file
+    TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
+    string TAP_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "tap");
+    if (!TAP_codec.encode(tape_file, TAP_file_name)) {
+        cout << "Failed to write the TAP file!\n";
+        success = false;
+    }
+
+
+    // Create UEF file
+    string UEF_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "uef");
+    if (!UEF_encoder.encode(tape_file, UEF_file_name)) {
+        cout << "Failed to write the UEF file!\n";
+        success = false;
+    }
+
+    // Create BIN file
+    string BIN_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "");
+    BinCodec BIN_codec(arg_parser.logging);
+    if (!BIN_codec.encode(tape_file, BIN_file_name)) {
+        cout << "can't create Binary file " << BIN_file_name << "\n";
+        success = false;
+    }
+
+    // Create INF file
+    if (!BinCodec::generateInfFile(arg_parser.dstDir, tape_file)) {
+        cout << "Failed to write the INF file!\n";
+        success = false;
+    }
+
+    return success;
+}
+
+//
+// Read and convert indexed files of the TAP file in parallel.
+//
+// Each job reads its file's data from the TAP file (so that only the files being converted are held in
+// memory) and generates the output files for it. Files with the same name would generate the same output
+// files so they are converted in the TAP file order by the same job (the last one's output files remain
+// as when converting the files one at a time).
+//
+void convertFiles(ArgParser& arg_parser, vector<TAPEntry*>& entries)
+{
+    // Group the files on their output file names
+    vector<vector<TAPEntry*>> jobs;
+    map<string, int> job_for_name;
+    for (int i = 0; i < entries.size(); i++) {
+        string host_file_name = Utility::crValidHostFileName(entries[i]->header.name);
+        if (job_for_name.find(host_file_name) == job_for_name.end()) {
+            job_for_name[host_file_name] = (int) jobs.size();
+            jobs.push_back(vector<TAPEntry*>());
+        }
+        jobs[job_for_name[host_file_name]].push_back(entries[i]);
+    }
+
+    int n_jobs = (int) jobs.size();
+    if (n_jobs == 0)
+        return;
+
+    // Convert one file at a time when logging so that the log isn't mixed up
+    int n_threads = arg_parser.nThreads;
+    if (n_threads <= 0)
+        n_threads = WorkerPool::defaultThreads();
+    if (arg_parser.logging.verbose)
+        n_threads = 1;
+
+    WorkerPool pool(min(n_threads, n_jobs));
+    for (int j = 0; j < n_jobs; j++) {
+        pool.submit([&arg_parser, &jobs, j] {
+            TAPCodec TAP_codec = TAPCodec(arg_parser.logging, arg_parser.targetMachine);
+            UEFCodec UEF_encoder(false, arg_parser.logging, arg_parser.targetMachine);
+            for (int i = 0; i < jobs[j].size(); i++) {
+                TapeFile tape_file(arg_parser.targetMachine);
+                if (!TAP_codec.decodeEntry(arg_parser.srcFileName, *jobs[j][i], tape_file))
+                    cout << "Failed to decode tape file '" << jobs[j][i]->header.name << "'!\n";
+                else
+                    (void) generateFiles(tape_file, arg_parser, UEF_encoder);
+            }
+        });
+    }
+    pool.wait();
+}
+
+
 
 /*
  *
@@ -80,92 +193,48 @@ int main(int argc, const char* argv[])
 
     TAPCodec TAP_codec = TAPCodec(arg_parser.logging, arg_parser.targetMachine);
 
-    // Scan TAP file for Atom/BBC Micro files
-    vector<TapeFile> tape_files;
-    TAP_codec.decodeMultipleFiles(arg_parser.srcFileName, tape_files);
+    // Index the TAP file for Atom/BBC Micro files (the program data is only read when needed)
+    vector<TAPEntry> index;
+    if (!TAP_codec.indexFile(arg_parser.srcFileName, index))
+        return -1;
     if (arg_parser.logging.verbose)
-        cout << "#TAP files = " << tape_files.size() << "\n";
+        cout << "#TAP files = " << index.size() << "\n";
 
-    // Iterate over the collected files
+    // Iterate over the indexed files
     bool selected_file_found = false;
     if (!arg_parser.genSSD) {
-        for (int i = 0; i < tape_files.size(); i++) {
-
-            TapeFile& tape_file = tape_files[i];
-
-            selected_file_found = selected_file_found || (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram);
-
-
-            if ((arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram)) {
-
-                string host_file_name = Utility::crValidHostFileName(tape_file.header.name);
-
-                if (tape_file.header.size > 0 && !genTapeFile && !arg_parser.cat) {
-
-                    // Generate the different types of files (DATA, ABC/BBC, TAP, UEF, BIN) for the found file
-
-                    if (arg_parser.logging.verbose)
-                        cout << "Tape File '" << tape_file.header.name <<
-                        "' read. Base file name used for generated files is: '" << host_file_name << "'.\n";
-
-                    // Creata DATA file
-                    DataCodec DATA_codec = DataCodec(arg_parser.logging);
-                    string DATA_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "dat");
-                    if (!DATA_codec.encode(tape_file, DATA_file_name)) {
-                        cout << "Failed to write the DATA file!\n";
-                        //return -1;
-                    }
+        vector<TAPEntry*> selected_entries;
+        for (int i = 0; i < index.size(); i++) {
 
-                    // Creata ABC/BBC program file
-                    AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
-                    string ABC_file_name = Utility::crEncodedProgramFileNamefromDir(arg_parser.dstDir, arg_parser.targetMachine, tape_file);
-                    if (!ABC_codec.detokenise(tape_file, ABC_file_name)) {
-                        cout << "Failed to write the program file!\n";
-                        //return -1;
-                    }
+            TAPEntry& entry = index[i];
 
-                    // Create TAP file
-                    TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
-                    string TAP_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "tap");
-                    if (!TAP_codec.encode(tape_file, TAP_file_name)) {
-                        cout << "Failed to write the TAP file!\n";
-                        //return -1;
-                    }
-                   
+            selected_file_found = selected_file_found || (arg_parser.searchedProgram == "" || entry.header.name == arg_parser.searchedProgram);
 
-                    // Create UEF file
-                    string UEF_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "uef");
-                    if (!UEF_encoder.encode(tape_file, UEF_file_name)) {
-                        cout << "Failed to write the UEF file!\n";
-                        //return -1;
-                    }
 
-                    // Create BIN file
-                    string BIN_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, tape_file, "");
-                    BinCodec BIN_codec(arg_parser.logging);
-                    if (!BIN_codec.encode(tape_file, BIN_file_name)) {
-                        cout << "can't create Binary file " << BIN_file_name << "\n";
-                        //return -1;
-                    }
+            if ((arg_parser.searchedProgram == "" || entry.header.name == arg_parser.searchedProgram)) {
 
-                    // Create INF file
-                    if (!BinCodec::generateInfFile(arg_parser.dstDir, tape_file)) {
-                        cout << "Failed to write the INF file!\n";
-                        //return -1;
-                    }
+                if (entry.header.size > 0 && !genTapeFile && !arg_parser.cat) {
 
+                    // Collect the file (the files are converted in parallel afterwards)
+                    selected_entries.push_back(&entry);
                 }
 
                 else if (!genTapeFile && arg_parser.cat) {
 
                     // Log found file
-                    tape_file.logFileHdr();
+                    TAP_codec.logEntry(entry);
                 }
 
-                else if (tape_file.header.size > 0 && genTapeFile) {
+                else if (entry.header.size > 0 && genTapeFile) {
 
                     // Add program to UEF/CSW/WAV tape file
 
+                    TapeFile tape_file(arg_parser.targetMachine);
+                    if (!TAP_codec.decodeEntry(arg_parser.srcFileName, entry, tape_file)) {
+                        cout << "Failed to decode tape file '" << entry.header.name << "'!\n";
+                        continue;
+                    }
+
                     if (arg_parser.genUEF) {
                         if (!UEF_encoder.encode(tape_file)) {
                             cout << "Failed to update the UEF file!\n";
@@ -193,30 +262,28 @@ int main(int argc, const char* argv[])
                 }
             }
         }
+
+        // Generate the different types of files for the collected files
+        convertFiles(arg_parser, selected_entries);
     }
     else {
         DiscCodec DISC_codec = DiscCodec(arg_parser.logging);
         filesystem::path file_path = arg_parser.srcFileName;
         string title = Utility::crReadableString(file_path.stem().string(), 12);
-        if (arg_parser.searchedProgram == "") {
-            if (!DISC_codec.write(title, arg_parser.dstFileName, tape_files)) {
-                cout << "Failed to create disc image!\n";
-                return -1;
+        vector <TapeFile> selected_tape_files;
+        for (int i = 0; i < index.size(); i++) {
+            TAPEntry& entry = index[i];
+            if (arg_parser.searchedProgram == "" || (entry.header.size > 0 && entry.header.name == arg_parser.searchedProgram)) {
+                TapeFile tape_file(arg_parser.targetMachine);
+                if (!TAP_codec.decodeEntry(arg_parser.srcFileName, entry, tape_file))
+                    break;
+                selected_tape_files.push_back(move(tape_file));
+                selected_file_found = entry.header.name == arg_parser.searchedProgram;
             }
         }
-        else {
-            vector <TapeFile> selected_tape_files;
-            for (int i = 0; i < tape_files.size(); i++) {
-                TapeFile &tape_file = tape_files[i];
-                if (tape_file.header.size > 0 && tape_file.header.name == arg_parser.searchedProgram) {
-                    selected_tape_files.push_back(tape_file);
-                    selected_file_found = tape_file.header.name == arg_parser.searchedProgram;
-                }
-            }
-            if (selected_file_found && !DISC_codec.write(title, arg_parser.dstFileName, selected_tape_files)) {
-                cout << "Failed to create disc image!\n";
-                return -1;
-            }
+        if ((arg_parser.searchedProgram == "" || selected_file_found) && !DISC_codec.write(title, arg_parser.dstFileName, selected_tape_files)) {
+            cout << "Failed to create disc image!\n";
+            return -1;
         }
     }
 
@@ -3,7 +3,9 @@
 #include <filesystem>
 #include <iostream>
 #include <string.h>
+#include <algorithm>
 #include "../shared/Utility.h"
+#include "../shared/WaveSampleTypes.h"
 
 using namespace std;
 
@@ -19,10 +21,24 @@ void ArgParser::printUsage(const char *name)
 	cout << "with the content being the detected (and selected) programs.\n\n";
 	cout << "If the audio file is of WAV type and is of poor quality, you should run \n";
 	cout << "FilterTape on it first before attempting to scan it for programs...\n\n";
-	cout << "Usage:\t" << name << " <WAV/CSW/UEF file> [-v] [-bbm] [-n <program>] [-b <baud rate>]  [-pot]\n";
+	cout << "Usage:\t" << name << " <WAV/CSW/UEF file | dir> [<WAV/CSW/UEF file | dir> ...] [-v] [-bbm] [-n <program>] [-b <baud rate>]  [-pot]\n";
 	cout << "\t-g <dir> | -uef <file> | -wav <file> | -csw <file> | -tap <file> | -ssd <file> | -c\n";
-	cout << "\t<advanced options>\n\n";
-	cout << "<WAV/CSW/UEF file>:\n\t16-bit PCM WAV/CSW/UEF file to decode.\n\n";
+	cout << "\t[-merge] [-j <threads>] [-m <MB>] <advanced options>\n\n";
+	cout << "<WAV/CSW/UEF file>:\n\tWAV/CSW/UEF file to decode. A WAV file can have 8, 16, 24 or 32-bit PCM or 32 or 64-bit float\n";
+	cout << "\tsamples and be a RIFF, RF64 or Wave64 file. Each channel of a multi-channel WAV file is decoded\n";
+	cout << "\tand each block is taken from a channel where it was read with a correct CRC.\n\n";
+	cout << "<dir>:\n\tDirectory with WAV/CSW/UEF files (*.wav, *.w64, *.csw and *.uef) to decode.\n\n";
+	cout << "If more than one file (or a directory) is specified, the files are scanned in parallel\n";
+	cout << "and the output of each file is put in a sub directory (named as the file) of the\n";
+	cout << "directory specified by option -g (or the work directory). A tape/disc file specified\n";
+	cout << "with option -uef/-wav/-csw/-tap/-ssd is generated in each sub directory. A summary of\n";
+	cout << "all scans is written to 'scan_summary.log'.\n\n";
+	cout << "-merge:\n\tThe files are captures (recordings) of the same tape that shall be merged. The captures are\n";
+	cout << "\tscanned in parallel and each block is taken from a capture with a correct CRC for it or, if there is\n";
+	cout << "\tno such capture, voted byte by byte from the captures. The output is generated as for one scanned tape\n";
+	cout << "\tfile and the capture(s) each block was taken from are logged in 'tape.log'.\n\n";
+	cout << "-j <threads>:\n\tNo of files to scan (or programs to detokenise) in parallel\n\t- default is one per hardware thread.\n\n";
+	cout << "-m <MB>:\n\tMax memory [MB] for the samples of the files being scanned in parallel\n\t- default is " << maxSampleMemory / (1024 * 1024) << " MB.\n\n";
 	cout << "-v:\n\tVerbose output.\n\n";
 	cout << "-bbm:\n\tScan for BBC Micro (default is Acorn Atom).\n\n";
 	cout << "-n <program>:\n\tOnly search for (and extract) <program>.\n\n";
@@ -45,6 +61,13 @@ void ArgParser::printUsage(const char *name)
 	cout << "-s <start time>:\n\tThe time to start detecting files from\n\t- default is 0.\n\n";
 	cout << "-f <freq tolerance>:\n\tTolerance of the 1200/2400 frequencies [0,1[\n\t- default is 0.25.\n\n";
 	cout << "-l <level tolerance>:\n\tSchmitt-trigger level tolerance [0,1[\n\t- default is 0.\n\n";
+	cout << "-fsk:\n\tDecode a WAV file by demodulating the 1200/2400 Hz tones (with Goertzel filters) instead of\n";
+	cout << "\tdetecting levels with a Schmitt-trigger. Decodes noisy or low-amplitude tapes without filtering them first.\n\n";
+	cout << "-pipe:\n\tDecode a WAV file in a pipeline where the levels are extracted from the samples on a thread of its own\n";
+	cout << "\t(in parallel with the decoding of 1/2 cycles, bytes and blocks). Speeds up the decoding of a single long tape\n";
+	cout << "\ton a multi-core computer. Not used with option -fsk.\n\n";
+	cout << "-ds <sample rate>:\n\tDecimate (anti-alias filter and downsample) a WAV file with a higher sample rate (e.g. 96 or 192 kHz)\n";
+	cout << "\tto about <sample rate> Hz before decoding it - default is no decimation.\n\n";
 	cout << "-lt <d>:\n\tThe duration of the first block's lead tone\n\t- default is " << tapeTiming.nomBlockTiming.firstBlockLeadToneDuration << " s.\n\n";
 	cout << "-slt <d>:\n\tThe duration of the subsequent block's lead tone\n\t- default is " << tapeTiming.nomBlockTiming.otherBlockLeadToneDuration << " s.\n\n";
 	cout << "-ml <d>:\n\tThe duration of a micro lead tone preceeding a data block\n\t- default is " << tapeTiming.nomBlockTiming.microLeadToneDuration << " s.\n\n";
@@ -56,6 +79,37 @@ void ArgParser::printUsage(const char *name)
 	cout << "\n";
 }
 
+bool ArgParser::addInput(string inputPath)
+{
+	filesystem::path fin_path = inputPath;
+
+	if (filesystem::is_directory(fin_path)) {
+		vector<string> files;
+		for (auto const& dir_entry : filesystem::directory_iterator(fin_path)) {
+			if (!dir_entry.is_regular_file())
+				continue;
+			string ext = dir_entry.path().extension().string();
+			transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			if (ext == ".wav" || ext == ".w64" || ext == ".csw" || ext == ".uef")
+				files.push_back(dir_entry.path().string());
+		}
+		// Directory iteration order is unspecified so sort to get a deterministic order
+		sort(files.begin(), files.end());
+		inputFiles.insert(inputFiles.end(), files.begin(), files.end());
+		batchMode = true;
+		return true;
+	}
+
+	if (!filesystem::exists(fin_path)) {
+		cout << "WAV file '" << inputPath << "' cannot be opened!\n";
+		return false;
+	}
+
+	inputFiles.push_back(inputPath);
+
+	return true;
+}
+
 ArgParser::ArgParser(int argc, const char* argv[])
 {
 
@@ -68,14 +122,21 @@ ArgParser::ArgParser(int argc, const char* argv[])
 
 	genDir = "";
 
-	filesystem::path fin_path = argv[1];
-	if (!filesystem::exists(fin_path)) {
-		cout << "WAV file '" << argv[1] << "' cannot be opened!\n";
+	// Get input files - all arguments preceeding the first option
+	int first_option = 1;
+	for (; first_option < argc && (first_option == 1 || argv[first_option][0] != '-'); first_option++) {
+		if (!addInput(argv[first_option]))
+			return;
+	}
+	if (first_option > 2)
+		batchMode = true;
+	if (inputFiles.size() == 0) {
+		cout << "No WAV/CSW/UEF files to scan!\n";
 		return;
 	}
-	wavFile = argv[1];
+	wavFile = inputFiles[0];
 
-	int ac = 2;
+	int ac = first_option;
 	// First search for option '-bbm' to select target machine and the
 	// related default timing properties
 	tapeTiming = atomTiming;
@@ -88,7 +149,7 @@ ArgParser::ArgParser(int argc, const char* argv[])
 	}
 
 	// Now look for remaining options
-	ac = 2;
+	ac = first_option;
 	bool genFiles = false;
 	while (ac < argc) {
 		if (strcmp(argv[ac], "-lbno") == 0) {
@@ -175,6 +236,21 @@ ArgParser::ArgParser(int argc, const char* argv[])
 				ac++;
 			}
 		}
+		else if (strcmp(argv[ac], "-fsk") == 0) {
+			fskDemodulation = true;
+		}
+		else if (strcmp(argv[ac], "-pipe") == 0) {
+			pipelined = true;
+		}
+		else if (strcmp(argv[ac], "-ds") == 0 && ac + 1 < argc) {
+			long freq = strtol(argv[ac + 1], NULL, 10);
+			if (freq < 4 * F2_FREQ)
+				cout << "-ds without a valid sample rate (at least " << 4 * F2_FREQ << " Hz)\n";
+			else {
+				decimationFreq = (int) freq;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-b") == 0) {
 			long baud_rate = strtol(argv[ac + 1], NULL, 10);
 			if (baud_rate != 300 && baud_rate != 1200)
@@ -221,6 +297,27 @@ ArgParser::ArgParser(int argc, const char* argv[])
 				ac++;
 			}
 		}
+		else if (strcmp(argv[ac], "-merge") == 0) {
+			mergeCaptures = true;
+		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				nThreads = (int) n;
+				ac++;
+			}
+		}
+		else if (strcmp(argv[ac], "-m") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n <= 0)
+				cout << "-m without a valid memory size\n";
+			else {
+				maxSampleMemory = (size_t) n * 1024 * 1024;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-t") == 0) {
 			logging.tracing = true;
 		}
@@ -244,7 +341,16 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		return;
 	}
 
-	if (cat && argc < 3) {
+	if (mergeCaptures) {
+		if (inputFiles.size() < 2) {
+			cout << "Option -merge requires at least two captures of the tape!\n";
+			printUsage(argv[0]);
+			return;
+		}
+		batchMode = false; // one scan of all captures
+	}
+
+	if (cat && argc < first_option + 1) {
 		printUsage(argv[0]);
 		return;
 	}
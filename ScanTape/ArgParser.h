@@ -20,8 +20,20 @@ public:
 	string genDir = "";
 	double freqThreshold = 0.25;
 	double levelThreshold = 0;
+	bool fskDemodulation = false; // Demodulate the FSK tones of a WAV file (instead of detecting levels with a Schmitt-trigger)
+	bool pipelined = false; // Extract the levels of a WAV file on a thread of its own (in parallel with the decoding of them)
+	int decimationFreq = 0; // Sample rate to decimate high sample rate WAV files to before decoding (0 <=> no decimation)
 	string wavFile;
 
+	// Batch mode - several input files (or directories of input files) scanned in parallel
+	bool batchMode = false;
+	vector<string> inputFiles;
+	int nThreads = 0; // No of tape files to scan in parallel (0 <=> one per hardware thread)
+	size_t maxSampleMemory = (size_t) 1024 * 1024 * 1024; // Max memory for the samples of the files being scanned
+
+	// Merge mode - several captures (recordings) of the same tape merged block by block
+	bool mergeCaptures = false;
+
 	bool cat = false;
 
 	bool genUEF = false;
@@ -44,6 +56,9 @@ private:
 
 	void printUsage(const char *);
 
+	// Add a tape file - or all tape files (*.wav, *.csw & *.uef) in a directory - to the input files
+	bool addInput(string inputPath);
+
 	bool mParseSuccess = false;
 
 public:
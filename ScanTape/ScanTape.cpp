@@ -5,20 +5,26 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include <set>
+#include <chrono>
+#include <algorithm>
 
 #include <math.h>
 
 #include "../shared/LevelDecoder.h"
 #include "../shared/WavCycleDecoder.h"
 #include "../shared/CSWCycleDecoder.h"
+#include "../shared/GoertzelCycleDecoder.h"
 #include "../shared/BlockDecoder.h"
 #include "../shared/FileDecoder.h"
+#include "../shared/DecoderChain.h"
 #include "../shared/WaveSampleTypes.h"
 #include "ArgParser.h"
 #include "../shared/UEFCodec.h"
 #include "../shared/AtomBasicCodec.h"
 #include "../shared/DataCodec.h"
 #include "../shared/PcmFile.h"
+#include "../shared/Decimator.h"
 #include "../shared/Utility.h"
 #include "../shared/CSWCodec.h"
 #include "../shared/UEFCodec.h"
@@ -29,44 +35,196 @@
 #include "../shared/WavEncoder.h"
 #include "../shared/DiscCodec.h"
 #include "../shared/BinCodec.h"
+#include "../shared/WorkerPool.h"
+#include "../shared/TapeFileMerger.h"
 
 using namespace std;
 using namespace std::filesystem;
 
+// Outcome of scanning one tape file (as reported in the batch mode summary)
+class ScanResult {
+public:
+    string inputFile;
+    string outputDir;
+    bool success = false;
+    int nFiles = 0;
+    int nCompleteFiles = 0;
+    int nCorruptedFiles = 0;
+    double scanTime = 0.0; // [s]
+};
+
+// Objects allocated when scanning a tape file
+class ScanResources {
+public:
+    TapeReader* tapeReader = NULL;
+    CycleDecoder* cycleDecoder = NULL;
+    ostream* logFile = NULL; // only deleted if it is an opened log file
+
+    ~ScanResources() { release(); }
+
+    void release() {
+        if (tapeReader != NULL)
+            delete tapeReader;
+        if (cycleDecoder != NULL)
+            delete cycleDecoder;
+        if (logFile != NULL && dynamic_cast<ofstream*>(logFile) != NULL) {
+            ((ofstream*)logFile)->close();
+            delete logFile;
+        }
+        tapeReader = NULL;
+        cycleDecoder = NULL;
+        logFile = NULL;
+    }
+};
 
 
 
 
 
-int main(int argc, const char* argv[])
+
+//
+// Read all tape files from a tape reader using a decoder chain composed at compile time
+// for the type of tape reader (see DecoderChain.h). Returns true if the searched program
+// (or any program if no program was searched for) was found.
+//
+template <class BD, class FD, class TR> bool readTapeFiles(
+    TR& tapeReader, ArgParser& arg_parser, ostream& logFile, vector<TapeFile>& tapeFiles
+)
 {
-    ArgParser arg_parser = ArgParser(argc, argv);
+    // Create A Block Decoder used to detect and read one block from a tape reader
+    BD block_decoder(tapeReader, arg_parser.logging, arg_parser.targetMachine, arg_parser.limitBlockNo);
 
-    if (arg_parser.failed())
-        return -1;
+    // Create a File Decoder used to detect and read a complete Tape File
+    FD fileDecoder(block_decoder, arg_parser.logging, arg_parser.targetMachine, arg_parser.tapeTiming, arg_parser.cat);
 
-    // Initialise pointers properly
-    CycleDecoder* cycle_decoder_p = NULL;
-    LevelDecoder* level_decoder_p = NULL;
-    Samples *samples_p = NULL;
-    ostream* tfout_p = NULL;
-    TapeReader* tape_reader = NULL;
+    // Read complete tape files using the File Decoder
+    TapeFile tape_file(ACORN_ATOM);
+    bool selected_file_found = false;
+    FileReadStatus read_status;
+    while (fileDecoder.readFile(logFile, tape_file, arg_parser.searchedProgram, read_status)) {
 
-    Bytes pulses;
-    int sample_freq = 44100; // from CSW/WAV file but usually 44100 Hz;
+        selected_file_found = selected_file_found || (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram);
+
+        // If the file was read with some content then add it to the list of tape files
+        // (also incomplete files are saved to support recovery of damaged files)
+        if (tape_file.blocks.size() > 0 && (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram))
+            tapeFiles.push_back(move(tape_file));
+
+    }
+
+    return selected_file_found;
+}
+
+//
+// Read all tape files from the samples of one WAV file channel - either by demodulating the FSK tones
+// or by detecting levels with a Schmitt-trigger. Returns true if the searched program (or any program if no
+// program was searched for) was found.
+//
+bool readSamples(ArgParser& arg_parser, Samples& samples, int sampleFreq, ostream& logFile, vector<TapeFile>& tapeFiles)
+{
+    if (arg_parser.fskDemodulation) {
+        // Create Cycle Decoder used to produce a cycle stream from the demodulated tones
+        GoertzelCycleDecoder cycle_decoder(
+            sampleFreq, samples, arg_parser.startTime, arg_parser.freqThreshold, arg_parser.logging
+        );
+        FSKSampleTapeReader tape_reader(cycle_decoder, 1200.0, arg_parser.tapeTiming, arg_parser.targetMachine, arg_parser.logging);
+        return readTapeFiles<FSKSampleBlockDecoder, FSKSampleFileDecoder>(tape_reader, arg_parser, logFile, tapeFiles);
+    }
+
+    // Create Level Decoder used to filter wave form into a well-defined level stream
+    LevelDecoder level_decoder(
+        sampleFreq, samples, arg_parser.startTime, arg_parser.freqThreshold, arg_parser.levelThreshold, arg_parser.logging,
+        arg_parser.pipelined
+    );
+
+    // Create Cycle Decoder used to produce a cycle stream from the level stream
+    WavCycleDecoder cycle_decoder(sampleFreq, level_decoder, arg_parser.freqThreshold, arg_parser.logging);
+
+    WavSampleTapeReader tape_reader(cycle_decoder, 1200.0, arg_parser.tapeTiming, arg_parser.targetMachine, arg_parser.logging);
+    return readTapeFiles<WavSampleBlockDecoder, WavSampleFileDecoder>(tape_reader, arg_parser, logFile, tapeFiles);
+}
+
+//
+// Read all tape files from each channel of a multi-channel WAV file and merge them.
+//
+// The channels are read in parallel (each with a decoder chain of its own) and each block is then taken
+// from a channel where it was read with a correct CRC (see TapeFileMerger). Returns true if the searched
+// program (or any program if no program was searched for) was found.
+//
+bool readChannels(ArgParser& argParser, vector<Samples>& channels, int sampleFreq, ostream& logFile, vector<TapeFile>& tapeFiles)
+{
+    int n_channels = (int) channels.size();
+    vector<vector<TapeFile>> channel_files(n_channels);
+    vector<ostringstream> channel_logs(n_channels);
+    vector<char> channels_with_selected_file(n_channels, false);
+
+    // Read the channels
+    {
+        int n_threads = (argParser.nThreads > 0 ? argParser.nThreads : WorkerPool::defaultThreads());
+        WorkerPool pool(min(n_threads, n_channels));
+        for (int i = 0; i < n_channels; i++) {
+            pool.submit([&argParser, &channels, sampleFreq, &channel_logs, &channel_files, &channels_with_selected_file, i] {
+                channels_with_selected_file[i] = readSamples(argParser, channels[i], sampleFreq, channel_logs[i], channel_files[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    // Log the channels in channel order
+    bool selected_file_found = false;
+    vector<string> channel_names;
+    for (int i = 0; i < n_channels; i++) {
+        channel_names.push_back("channel " + to_string(i + 1) + " of " + argParser.wavFile);
+        if (!argParser.cat)
+            logFile << "\nChannel " << dec << i + 1 << ":\n" << channel_logs[i].str();
+        selected_file_found = selected_file_found || channels_with_selected_file[i];
+    }
+
+    // Merge the tape files of the channels
+    ostream no_log(NULL); // discards all output
+    TapeFileMerger merger(argParser.logging);
+    (void) merger.merge(channel_files, channel_names, tapeFiles, (argParser.cat ? no_log : logFile));
+
+    if (argParser.logging.verbose) {
+        cout << "Merged " << dec << tapeFiles.size() << " files from " << n_channels << " channels: " << merger.nValidBlocks <<
+            " valid blocks, " << merger.nVotedBlocks << " voted blocks and " << merger.nCorruptedBlocks << " corrupted blocks\n";
+    }
+
+    return selected_file_found;
+}
 
+//
+// Read all tape files from one tape file (UEF, CSW or WAV) as specified by the arguments.
+//
+// Returns false if the tape file couldn't be read. Whether the searched program (or any program
+// if no program was searched for) was found is returned in selectedFileFound.
+//
+bool readTape(ArgParser& arg_parser, ostream& logFile, vector<TapeFile>& tapeFiles, bool& selectedFileFound)
+{
     // Is it a UEF file?
     UEFCodec UEF_codec(arg_parser.logging, arg_parser.targetMachine);
+
+    // Initialise pointers properly (the objects will be deleted when leaving the function)
+    ScanResources res;
+
+    // Concrete decoders (to compose the decoder chain at compile time)
+    UEFTapeReader* UEF_tape_reader_p = NULL;
+    CSWCycleDecoder* CSW_cycle_decoder_p = NULL;
+
+    Bytes pulses;
+    vector<Samples> channels; // samples of each channel of a WAV file
+    int sample_freq = 44100; // from CSW/WAV file but usually 44100 Hz;
+
     bool UEF_file = false;
     Bytes UEF_data;
     if (UEF_codec.validUefFile(arg_parser.wavFile)) {
         if (arg_parser.logging.verbose)
             cout << "UEF file detected - scanning it...\n";
         UEF_file = true;
-        UEFTapeReader* UEF_tape_reader_p = new UEFTapeReader(
+        UEF_tape_reader_p = new UEFTapeReader(
             UEF_codec, arg_parser.wavFile, arg_parser.logging, arg_parser.targetMachine
         );
-        tape_reader = UEF_tape_reader_p;
+        res.tapeReader = UEF_tape_reader_p;
     }
     // Is it a CSW file?
     else if (CSWCodec::isCSWFile(arg_parser.wavFile)) {
@@ -76,31 +234,33 @@ int main(int argc, const char* argv[])
         Level first_half_cycle_level;
         if (!CSW_codec.decode(arg_parser.wavFile, pulses, first_half_cycle_level)) {
             cout << "Couldn't decode CSW Wave file '" << arg_parser.wavFile << "'\n";
-            return -1;
+            return false;
         }
 
-        cycle_decoder_p = new CSWCycleDecoder(
+        CSW_cycle_decoder_p = new CSWCycleDecoder(
             sample_freq, first_half_cycle_level, pulses, arg_parser.freqThreshold, arg_parser.logging
         );
+        res.cycleDecoder = CSW_cycle_decoder_p;
     }
     else // If not a CSW file it must be a WAV file
     {
         if (arg_parser.logging.verbose)
             cout << "WAV file assumed - scanning it...\n";
-        if (!PcmFile::readSamples(arg_parser.wavFile, samples_p, sample_freq, arg_parser.logging)) {
+        if (!PcmFile::readChannels(arg_parser.wavFile, channels, sample_freq, arg_parser.logging)) {
             cout << "Couldn't open PCM Wave file '" << arg_parser.wavFile << "'\n";
-            return -1;
+            return false;
         }
 
-        // Create Level Decoder used to filter wave form into a well-defined level stream
-        level_decoder_p = new LevelDecoder(
-            sample_freq, *samples_p, arg_parser.startTime, arg_parser.freqThreshold, arg_parser.levelThreshold, arg_parser.logging
-        );
- 
-        // Create Cycle Decoder used to produce a cycle stream from the level stream
-        cycle_decoder_p = new WavCycleDecoder(
-            sample_freq, *level_decoder_p, arg_parser.freqThreshold, arg_parser.logging
-        );
+        // Decimate high sample rate samples (the decoders will then use the decimated sample rate)
+        if (arg_parser.decimationFreq > 0 && sample_freq > arg_parser.decimationFreq) {
+            Decimator decimator(sample_freq, arg_parser.decimationFreq, arg_parser.logging);
+            for (int c = 0; c < channels.size(); c++) {
+                Samples decimated_samples;
+                decimator.decimate(channels[c], decimated_samples);
+                channels[c] = move(decimated_samples);
+            }
+            sample_freq = decimator.outputFreq();
+        }
     }
 
     if (arg_parser.logging.verbose) {
@@ -111,33 +271,132 @@ int main(int argc, const char* argv[])
         cout << "Debug time range = [" << Utility::encodeTime(arg_parser.logging.start) << ", " << Utility::encodeTime(arg_parser.logging.end) << "]\n";
         cout << "Frequency tolerance = " << arg_parser.freqThreshold << "\n";
         cout << "Schmitt-trigger level tolerance = " << arg_parser.levelThreshold << "\n";
+        cout << "FSK demodulation (Goertzel filters) = " << (arg_parser.fskDemodulation ? "on" : "off") << "\n";
+        cout << "Pipelined level extraction = " << (arg_parser.pipelined && !arg_parser.fskDemodulation ? "on" : "off") << "\n";
         cout << "Min lead tone duration of first block = " << arg_parser.tapeTiming.minBlockTiming.firstBlockLeadToneDuration << " s\n";
         cout << "Min lead tone duration of subsequent blocks = " << arg_parser.tapeTiming.minBlockTiming.otherBlockLeadToneDuration << " s\n";
         cout << "Min micro lead duration = " << arg_parser.tapeTiming.minBlockTiming.microLeadToneDuration << " s\n";
         cout << "Tape timing to be used when generating UEF files = " << (arg_parser.tapeTiming.preserve ? "Original (from tape)" : "Standard") << "\n";
-        cout << "Sample frequency from input file: " << sample_freq << " Hz\n";
+        cout << "Sample frequency " << (arg_parser.decimationFreq > 0 ? "(after any decimation): " : "from input file: ") << sample_freq << " Hz\n";
+        if (channels.size() > 1)
+            cout << "Channels decoded (and merged) = " << channels.size() << "\n";
         cout << "Target computer: " << _TARGET_MACHINE(arg_parser.targetMachine) << "\n";
     }
 
-    TapeFile tape_file(ACORN_ATOM);
-
-    // Create a reader based on CSW/WAV input as provided by a cycle decoder
-    if (!UEF_file) {
-        WavTapeReader* wav_tape_reader_p = new WavTapeReader(*cycle_decoder_p, 1200.0, arg_parser.tapeTiming,
+    // Read complete tape files using a decoder chain for the type of tape file
+    if (UEF_file) {
+        selectedFileFound = readTapeFiles<UEFBlockDecoder, UEFFileDecoder>(
+            *UEF_tape_reader_p, arg_parser, logFile, tapeFiles
+        );
+    }
+    else if (CSW_cycle_decoder_p != NULL) {
+        CSWPulseTapeReader* CSW_tape_reader_p = new CSWPulseTapeReader(*CSW_cycle_decoder_p, 1200.0, arg_parser.tapeTiming,
             arg_parser.targetMachine, arg_parser.logging
         );
-        tape_reader = wav_tape_reader_p;
+        res.tapeReader = CSW_tape_reader_p;
+        selectedFileFound = readTapeFiles<CSWPulseBlockDecoder, CSWPulseFileDecoder>(
+            *CSW_tape_reader_p, arg_parser, logFile, tapeFiles
+        );
+    }
+    else if (channels.size() == 1) {
+        selectedFileFound = readSamples(arg_parser, channels[0], sample_freq, logFile, tapeFiles);
+    }
+    else {
+        selectedFileFound = readChannels(arg_parser, channels, sample_freq, logFile, tapeFiles);
     }
 
+    return true;
+}
 
-    // Create A Block Decoder used to detect and read one block from a tape reader
-    BlockDecoder block_decoder(*tape_reader, arg_parser.logging, arg_parser.targetMachine, arg_parser.limitBlockNo);
+// Estimate the memory needed for the samples (WAV) or pulses (CSW/UEF) of a tape file when it is scanned
+size_t estimateSampleMemory(string filePath)
+{
+    size_t file_sz = (size_t) file_size(filePath);
+    string ext = path(filePath).extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == ".wav" || ext == ".w64")
+        return file_sz * 2; // 8-bit samples are expanded into 16-bit samples
+    else
+        return file_sz * 8; // Compressed CSW/UEF data expands when decoded
+}
 
-    // Create a File Decoder used to detect and read a complete Tape File
-    FileDecoder fileDecoder(block_decoder, arg_parser.logging, arg_parser.targetMachine, arg_parser.tapeTiming, arg_parser.cat);
+//
+// Read all tape files from several captures (recordings) of the same tape and merge them.
+//
+// The captures are read in parallel and their tape files are then merged block by block (see TapeFileMerger):
+// each block is taken from a capture with a valid copy of it or is voted from the captures' copies of it.
+// The log of each capture as well as what capture(s) each block was taken from is written to logFile.
+//
+bool readCaptures(ArgParser& argParser, ostream& logFile, vector<TapeFile>& tapeFiles, bool& selectedFileFound)
+{
+    vector<string>& inputs = argParser.inputFiles;
+    int n_captures = (int) inputs.size();
+
+    vector<ArgParser> capture_args(n_captures, argParser);
+    vector<vector<TapeFile>> captures(n_captures);
+    vector<ostringstream> capture_logs(n_captures);
+    vector<char> captures_read(n_captures, false);
+    vector<char> captures_with_selected_file(n_captures, false);
+
+    // Read the captures
+    MemoryBudget memory_budget(argParser.maxSampleMemory);
+    {
+        WorkerPool pool(argParser.nThreads);
+        for (int i = 0; i < n_captures; i++) {
+            capture_args[i].wavFile = inputs[i];
+            capture_args[i].inputFiles = { inputs[i] };
+            capture_args[i].nThreads = 1; // the captures are already read in parallel
+            pool.submit([&capture_args, &captures, &capture_logs, &captures_read, &captures_with_selected_file, &memory_budget, i] {
+                MemoryReservation memory(memory_budget, estimateSampleMemory(capture_args[i].wavFile));
+                bool selected_file_found = false;
+                captures_read[i] = readTape(capture_args[i], capture_logs[i], captures[i], selected_file_found);
+                captures_with_selected_file[i] = selected_file_found;
+            });
+        }
+        pool.wait();
+    }
+
+    // Log the captures in the order of the input files (a capture that couldn't be read contributes no files)
+    for (int i = 0; i < n_captures; i++) {
+        if (!captures_read[i])
+            cout << "Failed to read capture '" << inputs[i] << "' - merging the other captures only!\n";
+        if (!argParser.cat)
+            logFile << "\nCapture " << dec << i + 1 << " '" << inputs[i] << "':\n" << capture_logs[i].str();
+        selectedFileFound = selectedFileFound || captures_with_selected_file[i];
+    }
+
+    // Merge the tape files of the captures
+    ostream no_log(NULL); // discards all output
+    TapeFileMerger merger(argParser.logging);
+    if (!merger.merge(captures, inputs, tapeFiles, (argParser.cat ? no_log : logFile)))
+        return false;
+
+    if (!argParser.cat) {
+        cout << "Merged " << dec << tapeFiles.size() << " files from " << n_captures << " captures: " << merger.nValidBlocks <<
+            " valid blocks, " << merger.nVotedBlocks << " voted blocks and " << merger.nCorruptedBlocks << " corrupted blocks\n";
+    }
+
+    return true;
+}
+
+//
+// Scan one tape file (UEF, CSW or WAV) as specified by the arguments.
+//
+// Catalogue output (option -c) is written to catOut. The outcome of the scan is recorded
+// in result.
+//
+int scanTape(ArgParser& arg_parser, ostream& catOut, ScanResult& result)
+{
+    result.inputFile = arg_parser.wavFile;
+    result.outputDir = arg_parser.genDir;
+
+    // The log file will be closed when leaving the function
+    ScanResources res;
 
     // Create a log file
-    ostream* fout_p = &cout;
+    ostream*& fout_p = res.logFile;
+    fout_p = &catOut;
     if (!arg_parser.cat) {
 
         string fout_name = "tape.log";
@@ -148,12 +407,17 @@ int main(int argc, const char* argv[])
         fout_p = new ofstream(fout_path);
         if (!*fout_p) {
             cout << "can't write to log file " << fout_name << "\n";
-            return false;
+            return -1;
         }
     }
 
     if (!arg_parser.cat) {
-        *fout_p << "Input file = '" << arg_parser.wavFile << "'\n";
+        if (arg_parser.mergeCaptures) {
+            for (int i = 0; i < arg_parser.inputFiles.size(); i++)
+                *fout_p << "Input file (capture " << i + 1 << ") = '" << arg_parser.inputFiles[i] << "'\n";
+        }
+        else
+            *fout_p << "Input file = '" << arg_parser.wavFile << "'\n";
         *fout_p << "Start time = " << arg_parser.startTime << "\n";
         *fout_p << "Baudrate = " << arg_parser.tapeTiming.baudRate << "\n";
         *fout_p << "Frequency tolerance = " << arg_parser.freqThreshold << "\n";
@@ -203,22 +467,23 @@ int main(int argc, const char* argv[])
         }
     }
 
-    // Read complete tape files using the File Decoder
+    // Read complete tape files - from one tape file or by merging several captures of the same tape
     bool selected_file_found = false;
     vector<TapeFile> tape_files;
-    vector<TapeFile> tape_files_complete;
-    FileReadStatus read_status;
-    while (fileDecoder.readFile(*fout_p, tape_file, arg_parser.searchedProgram, read_status)) {
-
-        // If the file was read with some content then add it to the list of tape files
-        if (tape_file.blocks.size() > 0 && (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram)) {
-            if (tape_file.complete) // save complete files
-                tape_files_complete.push_back(tape_file);
-            tape_files.push_back(tape_file); // also save incomplete files (to support recovery of damaged files)
-        }
- 
-        selected_file_found = selected_file_found || (arg_parser.searchedProgram == "" || tape_file.header.name == arg_parser.searchedProgram);
+    bool read_tape;
+    if (arg_parser.mergeCaptures)
+        read_tape = readCaptures(arg_parser, *fout_p, tape_files, selected_file_found);
+    else
+        read_tape = readTape(arg_parser, *fout_p, tape_files, selected_file_found);
+    if (!read_tape)
+        return -1;
 
+    result.nFiles = (int) tape_files.size();
+    for (int i = 0; i < tape_files.size(); i++) {
+        if (tape_files[i].complete)
+            result.nCompleteFiles++;
+        if (tape_files[i].corrupted)
+            result.nCorruptedFiles++;
     }
 
     if (arg_parser.searchedProgram != "" && !selected_file_found)
@@ -230,6 +495,8 @@ int main(int argc, const char* argv[])
     if (selected_file_found && !arg_parser.genSSD) {
 
         // Generate the different types of files (DATA, ABC/BBC, TAP, UEF, BIN) for the each file
+        vector<TapeFile*> ABC_tape_files;
+        vector<string> ABC_file_names;
         for (int i = 0; i < tape_files.size(); i++) {
 
             TapeFile& tape_file = tape_files[i];
@@ -244,13 +511,9 @@ int main(int argc, const char* argv[])
                     //return -1;
                 }
 
-                // Creata ABC/BBC program file
-                AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
-                string ABC_file_name = Utility::crEncodedProgramFileNamefromDir(arg_parser.genDir, arg_parser.targetMachine, tape_file);
-                if (!ABC_codec.detokenise(tape_file, ABC_file_name)) {
-                    cout << "Failed to write the program file!\n";
-                    //return -1;
-                }
+                // Collect ABC/BBC program file (all program files are created in parallel afterwards)
+                ABC_tape_files.push_back(&tape_file);
+                ABC_file_names.push_back(Utility::crEncodedProgramFileNamefromDir(arg_parser.genDir, arg_parser.targetMachine, tape_file));
 
                 // Create TAP file
                 TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
@@ -286,11 +549,11 @@ int main(int argc, const char* argv[])
             else if (!genTapeFile && arg_parser.cat) {
 
                 if (!tape_file.complete || tape_file.corrupted)
-                    cout << "***";
+                    catOut << "***";
                 else
-                    cout << "   ";
+                    catOut << "   ";
                 // Log found file
-                tape_file.logFileHdr();
+                tape_file.logFileHdr(&catOut);
             }
 
             else if (genTapeFile && tape_file.complete) {
@@ -301,7 +564,6 @@ int main(int argc, const char* argv[])
                         if (!UEF_encoder.encode(tape_file)) {
                             cout << "Failed to update the UEF file!\n";
                             UEF_encoder.closeTapeFile();
-                            if (samples_p != NULL) delete samples_p;
                             return -1;
                         }
                     }
@@ -309,7 +571,6 @@ int main(int argc, const char* argv[])
                         if (!CSW_encoder.encode(tape_file)) {
                             cout << "Failed to update the CSW file!\n";
                             CSW_encoder.closeTapeFile();
-                            if (samples_p != NULL) delete samples_p;
                             return -1;
                         }
                     }
@@ -317,7 +578,6 @@ int main(int argc, const char* argv[])
                         if (!WAV_encoder.encode(tape_file)) {
                             cout << "Failed to update the WAV file!\n";
                             WAV_encoder.closeTapeFile();
-                            if (samples_p != NULL) delete samples_p;
                             return -1;
                         }
                     }
@@ -325,56 +585,39 @@ int main(int argc, const char* argv[])
                         if (!TAP_encoder.encode(tape_file)) {
                             cout << "Failed to update the TAP file!\n";
                             WAV_encoder.closeTapeFile();
-                            if (samples_p != NULL) delete samples_p;
                             return -1;
                         }
                     }
                     else {
-                        if (samples_p != NULL) delete samples_p;
                         return (-1);
                     }
              }
             
         }
+
+        // Create the ABC/BBC program files
+        AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
+        (void) ABC_codec.detokenise(ABC_tape_files, ABC_file_names, arg_parser.nThreads);
     }
     else if (selected_file_found) {
         // Create disc image from tape files
         DiscCodec DISC_codec = DiscCodec(arg_parser.logging);
         filesystem::path file_path = arg_parser.wavFile;
         string title = Utility::crReadableString(file_path.stem().string(), 12);
+        vector<TapeFile> tape_files_complete;
+        for (int i = 0; i < tape_files.size(); i++) {
+            if (tape_files[i].complete)
+                tape_files_complete.push_back(move(tape_files[i]));
+        }
         if (!DISC_codec.write(title, arg_parser.dstFileName, tape_files_complete)) {
             cout << "Failed to create disc image!\n";
-            if (samples_p != NULL) {
-                delete samples_p;
-            }
             return -1;
         }
     }
 
-    
-    if (tape_reader != NULL)
-        delete tape_reader;
-
-    if (cycle_decoder_p != NULL)
-        delete cycle_decoder_p;
-
-    if (level_decoder_p != NULL)
-        delete level_decoder_p;
 
-
-    // Close and delete log file - if applicable
-    if (fout_p != &cout) {
-        ((ofstream *) fout_p) -> close();
-        delete fout_p;
-    }
-    if (tfout_p != NULL) {
-        ((ofstream*)tfout_p)->close();
-        delete tfout_p;
-    }
-
-    if (samples_p != NULL) {
-        delete samples_p;
-    }
+    // Release decoders, samples and log file before closing the output tape file
+    res.release();
 
     // Close output tape file (if applicable)
     if (arg_parser.genUEF) {
@@ -402,8 +645,122 @@ int main(int argc, const char* argv[])
         }
     }
 
+    result.success = true;
+
     return 0;
 }
 
 
+//
+// Scan a set of tape files in parallel (batch mode).
+//
+// The output of each tape file is put in its own sub directory and a summary of all scans
+// is written to 'scan_summary.log'. The no of tape files being scanned at the same time is limited
+// both by the no of worker threads and by the max memory allowed for the samples of the files.
+//
+int scanTapes(ArgParser& argParser)
+{
+    vector<string>& inputs = argParser.inputFiles;
+    int n_inputs = (int) inputs.size();
+
+    vector<ArgParser> job_args(n_inputs, argParser);
+    vector<ScanResult> results(n_inputs);
+    vector<ostringstream> cat_outputs(n_inputs);
+
+    // Create one output sub directory per input file (named as the file but unique)
+    set<string> dir_names;
+    for (int i = 0; i < n_inputs; i++) {
+        path input_path = inputs[i];
+        job_args[i].wavFile = inputs[i];
+        job_args[i].inputFiles = { inputs[i] };
+        job_args[i].nThreads = 1; // the tape files are already scanned in parallel
+        results[i].inputFile = inputs[i];
+        if (argParser.cat)
+            continue;
+        string dir_name = input_path.stem().string();
+        if (dir_names.count(dir_name) > 0)
+            dir_name += "_" + input_path.extension().string().substr(1);
+        string base_name = dir_name;
+        for (int k = 2; dir_names.count(dir_name) > 0; k++)
+            dir_name = base_name + "_" + to_string(k);
+        dir_names.insert(dir_name);
+        path out_dir = path(argParser.genDir) / dir_name;
+        if (!exists(out_dir) && !create_directories(out_dir)) {
+            cout << "Failed to create output directory '" << out_dir.string() << "'!\n";
+            return -1;
+        }
+        job_args[i].genDir = out_dir.string();
+        if (argParser.dstFileName != "")
+            job_args[i].dstFileName = (out_dir / path(argParser.dstFileName).filename()).string();
+    }
+
+    // Scan the files
+    MemoryBudget memory_budget(argParser.maxSampleMemory);
+    {
+        WorkerPool pool(argParser.nThreads);
+        for (int i = 0; i < n_inputs; i++) {
+            pool.submit([&job_args, &results, &cat_outputs, &memory_budget, i] {
+                MemoryReservation memory(memory_budget, estimateSampleMemory(job_args[i].wavFile));
+                auto t_start = chrono::steady_clock::now();
+                (void) scanTape(job_args[i], cat_outputs[i], results[i]);
+                results[i].scanTime = chrono::duration<double>(chrono::steady_clock::now() - t_start).count();
+            });
+        }
+        pool.wait();
+    }
+
+    // Output catalogues in the order of the input files
+    if (argParser.cat) {
+        for (int i = 0; i < n_inputs; i++)
+            cout << "\n" << inputs[i] << ":\n" << cat_outputs[i].str();
+    }
 
+    // Create summary log
+    ostream* sout_p = &cout;
+    ofstream summary_file;
+    if (!argParser.cat) {
+        path summary_path = path(argParser.genDir) / "scan_summary.log";
+        summary_file.open(summary_path.string());
+        if (!summary_file) {
+            cout << "can't write to summary log file " << summary_path.string() << "\n";
+            return -1;
+        }
+        sout_p = &summary_file;
+    }
+
+    int n_failed = 0, n_files = 0;
+    *sout_p << "\n";
+    for (int i = 0; i < n_inputs; i++) {
+        ScanResult& r = results[i];
+        if (!r.success)
+            n_failed++;
+        n_files += r.nFiles;
+        *sout_p << (r.success ? "OK     " : "FAILED ") << "'" << r.inputFile << "': " << dec << r.nFiles << " files (" <<
+            r.nCompleteFiles << " complete, " << r.nCorruptedFiles << " corrupted) in " << Utility::roundedPD("", r.scanTime, "");
+        if (r.outputDir != "")
+            *sout_p << " => '" << r.outputDir << "'";
+        *sout_p << "\n";
+    }
+    *sout_p << "\n" << n_inputs - n_failed << " of " << n_inputs << " tape files scanned successfully; " << n_files << " files found.\n";
+
+    if (!argParser.cat) {
+        summary_file.close();
+        cout << n_inputs - n_failed << " of " << n_inputs << " tape files scanned successfully; " << n_files << " files found.\n";
+    }
+
+    return (n_failed == 0 ? 0 : -1);
+}
+
+int main(int argc, const char* argv[])
+{
+    ArgParser arg_parser = ArgParser(argc, argv);
+
+    if (arg_parser.failed())
+        return -1;
+
+    if (arg_parser.batchMode)
+        return scanTapes(arg_parser);
+
+    ScanResult result;
+    return scanTape(arg_parser, cout, result);
+}
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <iostream>
 #include <string.h>
+#include <algorithm>
 #include "../shared//Utility.h"
 
 using namespace std;
@@ -15,9 +16,15 @@ bool ArgParser::failed()
 void ArgParser::printUsage(const char *name)
 {
 	cout << "Generate UEF, DAT, BIN and TAP files based on a program file.\n\n"; 
-	cout << "Usage:\t" << name << " <program source file> [-g <output directory>] [-v] [-bbm]\n";
+	cout << "Usage:\t" << name << " <program source file | dir> [<program source file | dir> ...] [-g <output directory>] [-v] [-bbm] [-j <threads>]\n";
 	cout << " \t -g <dir>\n\n";
 	cout << "<program source file>:\n\tBASIC program file to decode\n\n";
+	cout << "<dir>:\n\tDirectory tree with BASIC program files (*.abc and *.bbc) to decode.\n\n";
+	cout << "If more than one file (or a directory) is specified, the programs are converted in parallel.\n";
+	cout << "The files generated for a program in a directory tree are put in the corresponding sub\n";
+	cout << "directory of the output directory. Programs that would get the same output file names\n";
+	cout << "(e.g. 'prog.abc' and 'prog.bbc') get unique names of the form <name>_<k> instead.\n\n";
+	cout << "-j <threads>:\n\tNo of programs to convert in parallel - default is one per hardware thread.\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
 	cout << "-g <dir>:\n\tDirectory to put generated files in\n\t- default is work directory.\n\n";
 	cout << "-bbm:\n\tTarget machine is BBC Micro (default is Acorn Atom)\n\n";
@@ -26,6 +33,41 @@ void ArgParser::printUsage(const char *name)
 	cout << "\n";
 }
 
+bool ArgParser::addInput(string inputPath)
+{
+	filesystem::path fin_path = inputPath;
+
+	if (filesystem::is_directory(fin_path)) {
+		vector<filesystem::path> files;
+		for (auto const& dir_entry : filesystem::recursive_directory_iterator(fin_path)) {
+			if (!dir_entry.is_regular_file())
+				continue;
+			string ext = dir_entry.path().extension().string();
+			transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			if (ext == ".abc" || ext == ".bbc")
+				files.push_back(dir_entry.path());
+		}
+		// Directory iteration order is unspecified so sort to get a deterministic order
+		sort(files.begin(), files.end());
+		for (int i = 0; i < files.size(); i++) {
+			inputFiles.push_back(files[i].string());
+			inputSubDirs.push_back(files[i].parent_path().lexically_relative(fin_path).string());
+		}
+		batchMode = true;
+		return true;
+	}
+
+	if (!filesystem::exists(fin_path)) {
+		cout << "File '" << inputPath << "' cannot be opened!\n";
+		return false;
+	}
+
+	inputFiles.push_back(inputPath);
+	inputSubDirs.push_back("");
+
+	return true;
+}
+
 ArgParser::ArgParser(int argc, const char* argv[])
 {
 
@@ -36,15 +78,22 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		return;
 	}
 
-	filesystem::path fin_path = argv[1];
-	if (!filesystem::exists(fin_path)) {
-		cout << "File '" << argv[1] << "' cannot be opened!\n";
+	// Get input files - all arguments preceeding the first option
+	int first_option = 1;
+	for (; first_option < argc && (first_option == 1 || argv[first_option][0] != '-'); first_option++) {
+		if (!addInput(argv[first_option]))
+			return;
+	}
+	if (first_option > 2)
+		batchMode = true;
+	if (inputFiles.size() == 0) {
+		cout << "No BASIC program files to decode!\n";
 		return;
 	}
-	srcFileName = argv[1];
+	srcFileName = inputFiles[0];
 	dstDir = filesystem::current_path().string();
 
-	int ac = 2;
+	int ac = first_option;
 
 	while (ac < argc) {
 		if (strcmp(argv[ac], "-bbm") == 0) {
@@ -60,6 +109,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		else if (strcmp(argv[ac], "-v") == 0) {
 			logging.verbose = true;
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				nThreads = (int) n;
+				ac++;
+			}
+		}
 		else {
 			cout << "Unknown option " << argv[ac] << "\n";
 			printUsage(argv[0]);
@@ -17,6 +17,10 @@ public:
 	string srcFileName;
 	Logging logging;
 	TargetMachine targetMachine = ACORN_ATOM;
+	bool batchMode = false;
+	vector<string> inputFiles;
+	vector<string> inputSubDirs; // Sub directory (of dstDir) to put the generated files of each input file in
+	int nThreads = 0; // No of programs to convert in parallel (0 <=> one per hardware thread)
 
 
 private:
@@ -25,6 +29,8 @@ private:
 
 	bool mParseSuccess = false;
 
+	bool addInput(string inputPath);
+
 	
 
 public:
@@ -5,6 +5,9 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include <atomic>
+#include <map>
+#include <algorithm>
 
 #include <math.h>
 
@@ -18,78 +21,214 @@
 #include "../shared/Utility.h"
 #include "../shared/TAPCodec.h"
 #include "../shared/BinCodec.h"
+#include "../shared/WorkerPool.h"
 
 using namespace std;
 using namespace std::filesystem;
 
 
 
-/*
- * 
- * Create UEF, DATA & TAP/MMC files from an Acorn Atom/BBC Micro BASIC source program file
- * * 
- */
-int main(int argc, const char* argv[])
+//
+// The codecs needed to convert a program into all the file formats.
+//
+// The codecs are created once and then reused for every program converted (by the same thread).
+//
+class ProgramConverter
 {
+public:
+
+    ProgramConverter(ArgParser& argParser) :
+        mABCCodec(argParser.logging, argParser.targetMachine),
+        mDATACodec(argParser.logging),
+        mTAPCodec(argParser.logging),
+        mUEFCodec(false, argParser.logging, argParser.targetMachine),
+        mBINCodec(argParser.logging)
+    {
+    }
 
-    ArgParser arg_parser = ArgParser(argc, argv);
-
-    if (arg_parser.failed())
-        return -1;
-
-    if (arg_parser.logging.verbose)
-        cout << "Output directory = " << arg_parser.dstDir << "\n";
+    //
+    // Create UEF, DATA, TAP, BIN & INF files in dstDir from a BASIC source program file
+    //
+    // The files are named after the program unless a (unique) dstName is provided.
+    //
+    bool convert(string srcFileName, string dstDir, string dstName = "")
+    {
+        bool success = true;
+
+        // Decode BASIC source file
+        TapeFile TAP_file(ACORN_ATOM);
+        if (!mABCCodec.tokenise(srcFileName, TAP_file)) {
+            printf("Failed to decode program file '%s'\n", srcFileName.c_str());
+            success = false;
+        }
+
+        //
+        // Generate files
+        // 
+
+        // Generate DATA file
+        string DATA_file_name = outputFileName(dstDir, dstName, TAP_file, "dat");
+        if (!mDATACodec.encode(TAP_file, DATA_file_name)) {
+            cout << "Failed to write the DATA file!\n";
+            success = false;
+        }
+
+        // Generate TAP file
+        string TAP_file_name = outputFileName(dstDir, dstName, TAP_file, "tap");
+        if (!mTAPCodec.encode(TAP_file, TAP_file_name)) {
+            cout << "Failed to write the TAP file!\n";
+            success = false;
+        }
+
+
+        // generate UEF file
+        string UEF_file_name = outputFileName(dstDir, dstName, TAP_file, "uef");
+        if (!mUEFCodec.encode(TAP_file, UEF_file_name)) {
+            cout << "Failed to write the UEF file!\n";
+            success = false;
+        }
+
+        // Create binary file
+        string BIN_file_name = outputFileName(dstDir, dstName, TAP_file, "");
+        if (!mBINCodec.encode(TAP_file, BIN_file_name)) {
+            cout << "can't create Binary file " << BIN_file_name << "\n";
+            success = false;
+        }
+
+        // Create INF file
+        if (!BinCodec::writeInfFile(outputFileName(dstDir, dstName, TAP_file, "inf"), TAP_file)) {
+            cout << "Failed to write the INF file!\n";
+            success = false;
+        }
+
+        return success;
+    }
 
+private:
 
-    // Decode BASIC source file
-    TapeFile TAP_file(ACORN_ATOM);
-    AtomBasicCodec ABC_codec = AtomBasicCodec(arg_parser.logging, arg_parser.targetMachine);
-    if (!ABC_codec.tokenise(arg_parser.srcFileName, TAP_file)) {
-        printf("Failed to decode program file '%s'\n", arg_parser.srcFileName.c_str());
+    static string outputFileName(string dstDir, string dstName, TapeFile& tapeFile, string ext)
+    {
+        if (dstName == "")
+            return Utility::crEncodedFileNamefromDir(dstDir, tapeFile, ext);
+        path file_name = path(dstDir) / dstName;
+        if (ext != "")
+            file_name += "." + ext;
+        return file_name.string();
     }
-    
 
+    AtomBasicCodec mABCCodec;
+    DataCodec mDATACodec;
+    TAPCodec mTAPCodec;
+    UEFCodec mUEFCodec;
+    BinCodec mBINCodec;
+};
 
+// Key identifying an output file name (without extension) in a directory
+static string outputKey(string dstDir, string fileName)
+{
+    string key = (path(dstDir) / fileName).string();
+    transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char) tolower(c); });
+    return key;
+}
 
+//
+// Convert a set of programs in parallel (batch mode).
+//
+// Each worker thread has its own set of codecs and takes the next program to convert
+// until all programs have been converted.
+//
+int convertPrograms(ArgParser& argParser)
+{
+    vector<string>& inputs = argParser.inputFiles;
+    int n_inputs = (int) inputs.size();
+
+    // Create the output (sub) directories
+    vector<string> dst_dirs(n_inputs);
+    for (int i = 0; i < n_inputs; i++) {
+        path dst_dir = path(argParser.dstDir) / argParser.inputSubDirs[i];
+        if (!exists(dst_dir) && !create_directories(dst_dir)) {
+            cout << "Failed to create output directory '" << dst_dir.string() << "'!\n";
+            return -1;
+        }
+        dst_dirs[i] = dst_dir.string();
+    }
 
     //
-    // Generate files
-    // 
-
-    // Generate DATA file
-    DataCodec DATA_codec = DataCodec(arg_parser.logging);
-    string DATA_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, TAP_file, "dat");
-    if (!DATA_codec.encode(TAP_file, DATA_file_name)) {
-        cout << "Failed to write the DATA file!\n";
+    // Programs with the same name (e.g. 'a/prog.abc' and 'b/prog.abc' or 'prog.abc' and 'prog.bbc')
+    // would be written to the same output files. Give all but the first of them a unique
+    // name of the form <name>_<k> instead (compared without case to also avoid collisions on
+    // case-insensitive file systems).
+    //
+    vector<string> dst_names(n_inputs);
+    map<string, int> output_names;
+    for (int i = 0; i < n_inputs; i++) {
+        string base_name = Utility::crValidHostFileName(
+            TapeFile::crValidBlockName(argParser.targetMachine, path(inputs[i]).stem().string())
+        );
+        string dst_name = base_name;
+        for (int k = 2; output_names.count(outputKey(dst_dirs[i], dst_name)) > 0; k++)
+            dst_name = base_name + "_" + to_string(k);
+        output_names[outputKey(dst_dirs[i], dst_name)] = i;
+        if (dst_name != base_name) {
+            cout << "Program file '" << inputs[i] << "' has the same name as '" <<
+                inputs[output_names[outputKey(dst_dirs[i], base_name)]] << "' - naming its output files '" << dst_name << ".*'\n";
+            dst_names[i] = dst_name;
+        }
     }
 
-    // Generate TAP file
-    TAPCodec TAP_codec = TAPCodec(arg_parser.logging);
-    string TAP_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, TAP_file, "tap");
-    if (!TAP_codec.encode(TAP_file, TAP_file_name)) {
-        cout << "Failed to write the TAP file!\n";
+    // Convert one program at a time when logging so that the log isn't mixed up
+    int n_threads = (argParser.nThreads > 0 ? argParser.nThreads : WorkerPool::defaultThreads());
+    if (argParser.logging.verbose)
+        n_threads = 1;
+    n_threads = min(n_threads, max(n_inputs, 1));
+
+    vector<char> converted(n_inputs, false);
+    atomic<int> next_input(0);
+    {
+        WorkerPool pool(n_threads);
+        for (int t = 0; t < n_threads; t++) {
+            pool.submit([&argParser, &inputs, &dst_dirs, &dst_names, &converted, &next_input, n_inputs] {
+                ProgramConverter converter(argParser);
+                for (int i = next_input++; i < n_inputs; i = next_input++)
+                    converted[i] = converter.convert(inputs[i], dst_dirs[i], dst_names[i]);
+            });
+        }
+        pool.wait();
     }
 
-
-    // generate UEF file
-    UEFCodec UEF_codec = UEFCodec(false, arg_parser.logging, arg_parser.targetMachine);
-    string UEF_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, TAP_file, "uef");
-    if (!UEF_codec.encode(TAP_file, UEF_file_name)) {
-        cout << "Failed to write the UEF file!\n";
+    int n_failed = 0;
+    for (int i = 0; i < n_inputs; i++) {
+        if (!converted[i]) {
+            cout << "Failed to convert program file '" << inputs[i] << "'!\n";
+            n_failed++;
+        }
     }
+    cout << n_inputs - n_failed << " of " << n_inputs << " program files converted.\n";
 
-    // Create binary file
-    string BIN_file_name = Utility::crEncodedFileNamefromDir(arg_parser.dstDir, TAP_file, "");
-    BinCodec BIN_codec(arg_parser.logging);
-    if (!BIN_codec.encode(TAP_file, BIN_file_name)) {
-        cout << "can't create Binary file " << BIN_file_name << "\n";
-    }
+    return (n_failed == 0 ? 0 : -1);
+}
 
-    // Create INF file
-    if (!BinCodec::generateInfFile(arg_parser.dstDir, TAP_file)) {
-        cout << "Failed to write the INF file!\n";
-        //return -1;
-    }
+/*
+ * 
+ * Create UEF, DATA & TAP/MMC files from Acorn Atom/BBC Micro BASIC source program files
+ * * 
+ */
+int main(int argc, const char* argv[])
+{
+
+    ArgParser arg_parser = ArgParser(argc, argv);
+
+    if (arg_parser.failed())
+        return -1;
+
+    if (arg_parser.logging.verbose)
+        cout << "Output directory = " << arg_parser.dstDir << "\n";
+
+    if (arg_parser.batchMode)
+        return convertPrograms(arg_parser);
+
+    ProgramConverter converter(arg_parser);
+    (void) converter.convert(arg_parser.srcFileName, arg_parser.dstDir);
 
     return 0;
 }
@@ -0,0 +1,63 @@
+#include "ArgParser.h"
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+
+bool ArgParser::failed()
+{
+	return !mParseSuccess;
+}
+
+void ArgParser::printUsage(const char* name)
+{
+	cout << "Measure the time to decode a tape file with the polymorphic decoder chain\n";
+	cout << "(virtual calls between the decoders) and with the decoder chain composed at\n";
+	cout << "compile time for the type of tape file. Also checks that both chains decode\n";
+	cout << "exactly the same data.\n\n";
+	cout << "Usage:\t" << name << " <WAV/CSW/UEF file> [-n <iterations>] [-bbm] [-v]\n";
+	cout << "<WAV/CSW/UEF file>:\n\tTape file to decode\n\n";
+	cout << "-n <iterations>:\n\tNo of times to decode the tape file with each chain - default is " << nIterations << "\n\n";
+	cout << "-bbm:\n\tDecode for BBC Micro (default is Acorn Atom)\n\n";
+	cout << "-v:\n\tVerbose output\n\n";
+	cout << "\n";
+}
+
+ArgParser::ArgParser(int argc, const char* argv[])
+{
+
+	if (argc <= 1) {
+		printUsage(argv[0]);
+		return;
+	}
+
+	srcFileName = argv[1];
+
+	int ac = 2;
+	while (ac < argc) {
+		if (strcmp(argv[ac], "-n") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n <= 0)
+				cout << "-n without a valid no of iterations\n";
+			else {
+				nIterations = (int) n;
+				ac++;
+			}
+		}
+		else if (strcmp(argv[ac], "-bbm") == 0) {
+			targetMachine = BBC_MODEL_B;
+			tapeTiming = bbmTiming;
+		}
+		else if (strcmp(argv[ac], "-v") == 0) {
+			logging.verbose = true;
+		}
+		else {
+			cout << "Unknown option " << argv[ac] << "\n";
+			printUsage(argv[0]);
+			return;
+		}
+		ac++;
+	}
+
+	mParseSuccess = true;
+}
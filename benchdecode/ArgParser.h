@@ -0,0 +1,43 @@
+#pragma once
+#ifndef ARG_PARSER_H
+#define ARG_PARSER_H
+
+
+#include <string>
+#include "../shared/TapeProperties.h"
+#include "../shared/FileBlock.h"
+#include "../shared/Logging.h"
+
+
+using namespace std;
+
+class ArgParser
+{
+public:
+
+
+	string srcFileName;
+	TapeProperties tapeTiming = atomTiming;
+	TargetMachine targetMachine = ACORN_ATOM;
+	int nIterations = 5; // No of times to decode the tape file with each decoder chain
+	double freqThreshold = 0.25;
+	double levelThreshold = 0.0;
+	Logging logging;
+
+
+
+private:
+
+	void printUsage(const char*);
+
+	bool mParseSuccess = false;
+
+public:
+
+	ArgParser(int argc, const char* argv[]);
+
+	bool failed();
+
+};
+
+#endif
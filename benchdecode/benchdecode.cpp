@@ -0,0 +1,242 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+#include "../shared/LevelDecoder.h"
+#include "../shared/WavCycleDecoder.h"
+#include "../shared/CSWCycleDecoder.h"
+#include "../shared/WavTapeReader.h"
+#include "../shared/UEFTapeReader.h"
+#include "../shared/BlockDecoder.h"
+#include "../shared/FileDecoder.h"
+#include "../shared/DecoderChain.h"
+#include "../shared/CSWCodec.h"
+#include "../shared/UEFCodec.h"
+#include "../shared/PcmFile.h"
+#include "ArgParser.h"
+
+using namespace std;
+
+//
+// Count all heap allocations (to check how many allocations the decoding makes)
+//
+static atomic<size_t> nAllocations(0);
+
+void* operator new(size_t sz)
+{
+    nAllocations++;
+    void* p = malloc(sz > 0 ? sz : 1);
+    if (p == NULL)
+        throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+//
+// What was decoded by a decoder chain (used to check that two chains decode the same data)
+//
+class DecodeResult
+{
+public:
+    int nFiles = 0;
+    int nBlocks = 0;
+    size_t nBytes = 0;
+    uint32_t checksum = 2166136261u; // FNV-1a hash of all file names and block data
+
+    void add(TapeFile& tapeFile)
+    {
+        nFiles++;
+        for (char c : tapeFile.header.name)
+            hash((Byte) c);
+        for (int i = 0; i < tapeFile.blocks.size(); i++) {
+            nBlocks++;
+            nBytes += tapeFile.blocks[i].data.size();
+            for (Byte b : tapeFile.blocks[i].data)
+                hash(b);
+        }
+    }
+
+    bool operator==(const DecodeResult& r) const
+    {
+        return nFiles == r.nFiles && nBlocks == r.nBlocks && nBytes == r.nBytes && checksum == r.checksum;
+    }
+
+private:
+    void hash(Byte b) { checksum = (checksum ^ b) * 16777619u; }
+};
+
+//
+// Decode all tape files from a tape reader with a decoder chain of block decoder type BD and
+// file decoder type FD
+//
+template <class BD, class FD, class TR> void decodeFiles(TR& tapeReader, ArgParser& argParser, DecodeResult& result)
+{
+    ostream no_log(NULL); // discards all output
+
+    BD block_decoder(tapeReader, argParser.logging, argParser.targetMachine);
+    FD file_decoder(block_decoder, argParser.logging, argParser.targetMachine, argParser.tapeTiming);
+
+    TapeFile tape_file(argParser.targetMachine);
+    FileReadStatus read_status;
+    while (file_decoder.readFile(no_log, tape_file, "", read_status)) {
+        if (tape_file.blocks.size() > 0)
+            result.add(tape_file);
+    }
+}
+
+//
+// Decode WAV samples with a tape reader of type TR (over a WavCycleDecoder) and the block and
+// file decoders BD and FD
+//
+template <class TR, class BD, class FD> void decodeSamples(
+    Samples& samples, int sampleFreq, ArgParser& argParser, DecodeResult& result
+)
+{
+    LevelDecoder level_decoder(sampleFreq, samples, 0.0, argParser.freqThreshold, argParser.levelThreshold, argParser.logging);
+    WavCycleDecoder cycle_decoder(sampleFreq, level_decoder, argParser.freqThreshold, argParser.logging);
+    TR tape_reader(cycle_decoder, 1200.0, argParser.tapeTiming, argParser.targetMachine, argParser.logging);
+    decodeFiles<BD, FD>(tape_reader, argParser, result);
+}
+
+//
+// Decode CSW pulses with a tape reader of type TR (over a CSWCycleDecoder) and the block and
+// file decoders BD and FD
+//
+template <class TR, class BD, class FD> void decodePulses(
+    Bytes& pulses, Level firstHalfCycleLevel, int sampleFreq, ArgParser& argParser, DecodeResult& result
+)
+{
+    CSWCycleDecoder cycle_decoder(sampleFreq, firstHalfCycleLevel, pulses, argParser.freqThreshold, argParser.logging);
+    TR tape_reader(cycle_decoder, 1200.0, argParser.tapeTiming, argParser.targetMachine, argParser.logging);
+    decodeFiles<BD, FD>(tape_reader, argParser, result);
+}
+
+//
+// Decode UEF chunks with the block and file decoders BD and FD
+//
+template <class BD, class FD> void decodeChunks(UEFCodec &uefCodec, ArgParser& argParser, DecodeResult& result)
+{
+    UEFTapeReader tape_reader(uefCodec, argParser.srcFileName, argParser.logging, argParser.targetMachine);
+    decodeFiles<BD, FD>(tape_reader, argParser, result);
+}
+
+//
+// Time nIterations decodings (with a decoding function that adds to a DecodeResult) and count
+// the no of heap allocations made by one decoding
+//
+template <class F> double timeDecoding(int nIterations, DecodeResult& result, size_t& nAllocs, F decode)
+{
+    double min_t = -1;
+    for (int i = 0; i < nIterations; i++) {
+        result = DecodeResult();
+        size_t allocs_before = nAllocations;
+        auto start = chrono::steady_clock::now();
+        decode(result);
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        nAllocs = nAllocations - allocs_before;
+        if (min_t < 0 || t < min_t)
+            min_t = t;
+    }
+    return min_t;
+}
+
+/*
+ *
+ * Benchmark the polymorphic and the compile-time composed decoder chains
+ *
+ */
+int main(int argc, const char* argv[])
+{
+    ArgParser arg_parser = ArgParser(argc, argv);
+
+    if (arg_parser.failed())
+        return -1;
+
+    UEFCodec UEF_codec(arg_parser.logging, arg_parser.targetMachine);
+    Samples* samples_p = NULL;
+    Bytes pulses;
+    Level first_half_cycle_level;
+    int sample_freq = 44100;
+
+    DecodeResult poly_result, static_result;
+    double poly_t, static_t;
+    size_t poly_allocs = 0, static_allocs = 0;
+    int n = arg_parser.nIterations;
+
+    if (UEF_codec.validUefFile(arg_parser.srcFileName)) {
+        cout << "UEF file '" << arg_parser.srcFileName << "'\n";
+        poly_t = timeDecoding(n, poly_result, poly_allocs, [&](DecodeResult& r) {
+            decodeChunks<BlockDecoder, FileDecoder>(UEF_codec, arg_parser, r);
+        });
+        static_t = timeDecoding(n, static_result, static_allocs, [&](DecodeResult& r) {
+            decodeChunks<UEFBlockDecoder, UEFFileDecoder>(UEF_codec, arg_parser, r);
+        });
+    }
+    else if (CSWCodec::isCSWFile(arg_parser.srcFileName)) {
+        CSWCodec CSW_codec = CSWCodec(false, sample_freq, arg_parser.tapeTiming, arg_parser.logging, arg_parser.targetMachine);
+        if (!CSW_codec.decode(arg_parser.srcFileName, pulses, first_half_cycle_level)) {
+            cout << "Couldn't decode CSW Wave file '" << arg_parser.srcFileName << "'\n";
+            return -1;
+        }
+        cout << "CSW file '" << arg_parser.srcFileName << "' with " << pulses.size() << " pulses\n";
+        poly_t = timeDecoding(n, poly_result, poly_allocs, [&](DecodeResult& r) {
+            decodePulses<WavTapeReader, BlockDecoder, FileDecoder>(pulses, first_half_cycle_level, sample_freq, arg_parser, r);
+        });
+        static_t = timeDecoding(n, static_result, static_allocs, [&](DecodeResult& r) {
+            decodePulses<CSWPulseTapeReader, CSWPulseBlockDecoder, CSWPulseFileDecoder>(
+                pulses, first_half_cycle_level, sample_freq, arg_parser, r
+            );
+        });
+    }
+    else {
+        if (!PcmFile::readSamples(arg_parser.srcFileName, samples_p, sample_freq, arg_parser.logging) || samples_p == NULL) {
+            cout << "Couldn't open PCM Wave file '" << arg_parser.srcFileName << "'\n";
+            return -1;
+        }
+        cout << "WAV file '" << arg_parser.srcFileName << "' with " << samples_p->size() << " samples\n";
+        poly_t = timeDecoding(n, poly_result, poly_allocs, [&](DecodeResult& r) {
+            decodeSamples<WavTapeReader, BlockDecoder, FileDecoder>(*samples_p, sample_freq, arg_parser, r);
+        });
+        static_t = timeDecoding(n, static_result, static_allocs, [&](DecodeResult& r) {
+            decodeSamples<WavSampleTapeReader, WavSampleBlockDecoder, WavSampleFileDecoder>(*samples_p, sample_freq, arg_parser, r);
+        });
+        delete samples_p;
+    }
+
+    cout << dec << poly_result.nFiles << " files with " << poly_result.nBlocks << " blocks and " << poly_result.nBytes << " bytes decoded\n";
+    cout << "Best of " << n << " iterations:\n";
+    cout << "\tPolymorphic chain:\t" << poly_t * 1000 << " ms\n";
+    cout << "\tStatic chain:\t\t" << static_t * 1000 << " ms";
+    if (static_t > 0)
+        cout << " (speedup " << poly_t / static_t << ")";
+    cout << "\n";
+
+    // The allocations that remain per block are the ones for the decoded data kept in the Tape Files
+    double n_blocks = (poly_result.nBlocks > 0 ? poly_result.nBlocks : 1);
+    cout << "Heap allocations per decoding:\n";
+    cout << "\tPolymorphic chain:\t" << poly_allocs << " (" << poly_allocs / n_blocks << " per block)\n";
+    cout << "\tStatic chain:\t\t" << static_allocs << " (" << static_allocs / n_blocks << " per block)\n";
+
+    if (!(poly_result == static_result)) {
+        cout << "The chains decoded different data (" << static_result.nFiles << " files with " << static_result.nBlocks <<
+            " blocks and " << static_result.nBytes << " bytes for the static chain)!\n";
+        return -1;
+    }
+
+    return 0;
+}
+
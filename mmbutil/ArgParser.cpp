@@ -16,14 +16,25 @@ bool ArgParser::failed()
 void ArgParser::printUsage(const char* name)
 {
 	cout << "Encodes and decodes MMB files.\n\n";
-	cout << "Usage:\t" << name << " [-decode] <MMB src file> [-c] [-g <dst dir>] [-v]\n";
-	cout << "\t" << name << " -encode <src_dir> -o <MMB output file>\n";
+	cout << "Usage:\t" << name << " [-decode] <MMB src file> [-c] [-g <dst dir>] [-j <threads>] [-v]\n";
+	cout << "\t" << name << " [-decode] <MMB src file> -x <disc> [-o <SSD file>] [-v]\n";
+	cout << "\t" << name << " [-decode] <MMB src file> -replace <disc> <SSD file> | -add <SSD file> |\n";
+	cout << "\t\t-lock <disc> | -unlock <disc> | -blank <disc> [-v]\n";
+	cout << "\t" << name << " -encode <src_dir> -o <MMB output file> [-j <threads>] [-v]\n";
 	cout << "<MMB src file>:\n\tMMB file to decode\n\n";
 	cout << "<MMB dst file>:\n\tMMB file to encode (i.e., generate)\n\n";
 	cout << "If no directory is specified, it will default to the\n";
 	cout << "current working directory'.\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
+	cout << "-j <threads>:\n\tNo of threads used to encode/decode the discs - default is one per hardware thread\n\n";
 	cout << "-c:\n\t(decoding only) only output a catalogue\n\n";
+	cout << "-x <disc>:\n\t(decoding only) only extract one disc (title or slot no) - default SSD file is <disc title>.ssd\n\n";
+	cout << "-replace <disc> <SSD file>:\n\tReplace one disc (title or slot no) of the MMB file with an SSD file\n\n";
+	cout << "-add <SSD file>:\n\tAdd an SSD file to the first unformatted slot of the MMB file\n\n";
+	cout << "-lock <disc> / -unlock <disc>:\n\tLock/unlock one disc (title or slot no) of the MMB file\n\n";
+	cout << "-blank <disc>:\n\tRemove one disc (title or slot no) from the MMB file and mark its slot as unformatted\n\n";
+	cout << "The -replace, -add, -lock, -unlock and -blank options update the MMB file in place\n";
+	cout << "(only the affected disc slot and title are written).\n\n";
 	cout << "\n";
 }
 
@@ -51,6 +62,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		else if (strcmp(argv[ac], "-v") == 0) {
 			logging.verbose = true;
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				mThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (files_provided == 0 && strcmp(argv[ac], "-d") == 0 && ac + 1 < argc) {
 			dirName = argv[ac + 1];
 			files_provided++;
@@ -65,6 +85,35 @@ ArgParser::ArgParser(int argc, const char* argv[])
 			cat = true;
 			files_provided++;
 		}
+		else if (decode && files_provided == 1 && strcmp(argv[ac], "-replace") == 0 && ac + 2 < argc) {
+			update = REPLACE_DISC;
+			updateDisc = argv[ac + 1];
+			SSDFileName = argv[ac + 2];
+			files_provided++;
+			ac += 2;
+		}
+		else if (decode && files_provided == 1 && strcmp(argv[ac], "-add") == 0 && ac + 1 < argc) {
+			update = ADD_DISC;
+			SSDFileName = argv[ac + 1];
+			files_provided++;
+			ac++;
+		}
+		else if (decode && files_provided == 1 && (strcmp(argv[ac], "-lock") == 0 || strcmp(argv[ac], "-unlock") == 0 ||
+			strcmp(argv[ac], "-blank") == 0) && ac + 1 < argc) {
+			update = (strcmp(argv[ac], "-lock") == 0 ? LOCK_DISC : (strcmp(argv[ac], "-unlock") == 0 ? UNLOCK_DISC : BLANK_DISC));
+			updateDisc = argv[ac + 1];
+			files_provided++;
+			ac++;
+		}
+		else if (decode && files_provided == 1 && strcmp(argv[ac], "-x") == 0 && ac + 1 < argc) {
+			extractDisc = argv[ac + 1];
+			files_provided++;
+			ac++;
+		}
+		else if (decode && extractDisc != "" && strcmp(argv[ac], "-o") == 0 && ac + 1 < argc) {
+			SSDFileName = argv[ac + 1];
+			ac++;
+		}
 		else if (!decode && files_provided == 1 && strcmp(argv[ac], "-o") == 0 && ac + 1 < argc) {
 			fileName = argv[ac + 1];
 			files_provided++;
@@ -22,6 +22,17 @@ public:
 
 	bool cat = false;
 
+	string extractDisc = ""; // disc (title or slot no) to extract (if only one disc shall be extracted)
+
+	string SSDFileName = ""; // file to extract the disc to (or to replace/add a disc with)
+
+	// In-place update of one disc of the MMB file
+	enum UpdateOp { NO_UPDATE, REPLACE_DISC, ADD_DISC, LOCK_DISC, UNLOCK_DISC, BLANK_DISC };
+	UpdateOp update = NO_UPDATE;
+	string updateDisc = ""; // disc (title or slot no) to update
+
+	int mThreads = 0; // No of threads to encode/decode the discs with (0 <=> one per hardware thread)
+
 private:
 
 	void printUsage(const char*);
@@ -34,11 +34,25 @@ int main(int argc, const char* argv[])
 
     MMBCodec MMB_codec = MMBCodec(arg_parser.logging);
 
-    if (arg_parser.decode)
-        MMB_codec.decode(arg_parser.fileName, arg_parser.dirName, arg_parser.cat);
+    bool success;
+    if (arg_parser.update == ArgParser::REPLACE_DISC)
+        success = MMB_codec.replaceDisc(arg_parser.fileName, arg_parser.updateDisc, arg_parser.SSDFileName);
+    else if (arg_parser.update == ArgParser::ADD_DISC)
+        success = MMB_codec.addDisc(arg_parser.fileName, arg_parser.SSDFileName);
+    else if (arg_parser.update == ArgParser::LOCK_DISC || arg_parser.update == ArgParser::UNLOCK_DISC)
+        success = MMB_codec.lockDisc(arg_parser.fileName, arg_parser.updateDisc, arg_parser.update == ArgParser::LOCK_DISC);
+    else if (arg_parser.update == ArgParser::BLANK_DISC)
+        success = MMB_codec.blankDisc(arg_parser.fileName, arg_parser.updateDisc);
+    else if (arg_parser.decode && arg_parser.extractDisc != "")
+        success = MMB_codec.extract(arg_parser.fileName, arg_parser.extractDisc, arg_parser.SSDFileName);
+    else if (arg_parser.decode)
+        success = MMB_codec.decode(arg_parser.fileName, arg_parser.dirName, arg_parser.cat, arg_parser.mThreads);
     else
-        MMB_codec.encode(arg_parser.dirName, arg_parser.fileName);
+        success = MMB_codec.encode(arg_parser.dirName, arg_parser.fileName, arg_parser.mThreads);
 
+    // Let scripts detect a failed (e.g. refused in-place) update
+    if (!success)
+        return -1;
 
     return 0;
 }
@@ -7,8 +7,13 @@
 #include "Logging.h"
 #include "FileBlock.h"
 #include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <charconv>
+#include <algorithm>
 #include "BinCodec.h"
 #include "TAPCodec.h"
+#include "WorkerPool.h"
 
 using namespace std;
 
@@ -17,22 +22,24 @@ AtomBasicCodec::AtomBasicCodec(Logging logging, TargetMachine targetMachine) :mD
 {
     // Intialise  dictionary of BBC Micro BASIC program tokens
     //
-    // There is one for lookup of keyword from id (mTokenDictId)
-    // and another for lookup of id from keyword (including abbreviations of keyword) (mTokenDictStr)
+    // There is one for lookup of keyword from id (mTokenIndex)
+    // and another for lookup of id from keyword (including abbreviations of keyword) (mKeywords)
+    for (int id = 0; id < 256; id++)
+        mTokenIndex[id] = -1;
     for (int i = 0; i < mBBMTokens.size(); i++) {
         TokenEntry e = mBBMTokens[i];
         if (e.id1 != -1) {
-            mTokenDictId[e.id1] = e;
-            mTokenDictStr[e.fullT] = e;
+            mTokenIndex[e.id1] = i;
+            mKeywords.add(e.fullT, i);
             int min_len = (int) (e.shortT.length() - 1);
             for (int l = min_len; l < e.fullT.length(); l++) {
                 string a = e.fullT.substr(0, l) + ".";
-                mTokenDictStr[a] = e;
+                mKeywords.add(a, i);
             }
         }
 
         if (e.tokeniseInfo & ADD_40_FOR_START_OF_STATEMENT) {
-            mTokenDictId[e.id1 + 0x40] = e;
+            mTokenIndex[e.id1 + 0x40] = i;
         }
 
         
@@ -216,7 +223,85 @@ bool AtomBasicCodec::detokenise(string program, Bytes& tokenisedProgram, Bytes&
     }
 }
 
-bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Bytes& SourceProgram, bool &faultyTermination)
+bool AtomBasicCodec::detokenise(vector<TapeFile*>& tapeFiles, vector<string>& dstFiles, int nThreads)
+{
+    int n_files = (int) tapeFiles.size();
+    if (n_files == 0)
+        return true;
+
+    // Detokenise one program at a time when logging so that the log isn't mixed up
+    if (nThreads <= 0)
+        nThreads = WorkerPool::defaultThreads();
+    if (mDebugInfo.verbose)
+        nThreads = 1;
+
+    // Each job detokenises with its own copy of the codec as the target machine is taken from the Tape File
+    vector<char> detokenised(n_files, false);
+    {
+        WorkerPool pool(min(nThreads, n_files));
+        for (int i = 0; i < n_files; i++) {
+            pool.submit([this, &tapeFiles, &dstFiles, &detokenised, i] {
+                AtomBasicCodec ABC_codec = *this;
+                detokenised[i] = ABC_codec.detokenise(*tapeFiles[i], dstFiles[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    bool success = true;
+    for (int i = 0; i < n_files; i++) {
+        if (!detokenised[i]) {
+            cout << "Failed to write the program file '" << dstFiles[i] << "'!\n";
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+//
+// Detokenise in two passes: the first pass only counts the no of source code bytes so that the
+// source code can be written directly into a buffer of the right size by the second pass.
+//
+bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Bytes& SourceProgram, bool& faultyTermination)
+{
+    size_t size = 0;
+    if (!detokeniseBBM(program, tokenisedProgram, NULL, size, faultyTermination))
+        return false;
+
+    size_t start = SourceProgram.size();
+    SourceProgram.resize(start + size);
+    size = 0;
+    return detokeniseBBM(program, tokenisedProgram, SourceProgram.data() + start, size, faultyTermination);
+}
+
+bool AtomBasicCodec::detokeniseAtom(string program, Bytes& tokenisedProgram, Bytes& SourceProgram, bool& faultyTermination)
+{
+    size_t size = 0;
+    if (!detokeniseAtom(program, tokenisedProgram, NULL, size, faultyTermination))
+        return false;
+
+    size_t start = SourceProgram.size();
+    SourceProgram.resize(start + size);
+    size = 0;
+    return detokeniseAtom(program, tokenisedProgram, SourceProgram.data() + start, size, faultyTermination);
+}
+
+// Add a number (right-aligned in a field of at least width chars) to the source code (or only count its chars if sourceCode is NULL)
+static void addNumber(Byte* sourceCode, size_t& size, int n, int width)
+{
+    char digits[16];
+    char* digits_end = to_chars(digits, digits + sizeof(digits), n).ptr;
+    int n_digits = (int) (digits_end - digits);
+    for (int i = n_digits; i < width; i++, size++)
+        if (sourceCode != NULL)
+            sourceCode[size] = ' ';
+    if (sourceCode != NULL)
+        memcpy(sourceCode + size, digits, n_digits);
+    size += n_digits;
+}
+
+bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte* sourceCode, size_t& size, bool &faultyTermination)
 {
     faultyTermination = false;
 
@@ -224,24 +309,30 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
 
     int tape_file_sz = (int) tokenisedProgram.size();
 
+    // Add a byte to the source code (or only count it)
+    auto add = [sourceCode, &size](Byte b) {
+        if (sourceCode != NULL)
+            sourceCode[size] = b;
+        size++;
+    };
 
     int line_pos = -1;
     int line_no_low = 0;
     int line_no_high = 0;
     bool first_line = true;
-    bool end_of_program = false;   
+    bool end_of_program = false;
     int line_len;
 
-    bool parsing_goto_line = false;
-    int encoded_goto_line_cnt = -1;
-    string goto_line_bytes = "";
-    
+    char goto_line_bytes[4];
+    int n_goto_line_bytes = 0;
+
     TokeniseState t_state = TOKENISATION;
-    BytesIter t_code_iter = tokenisedProgram.begin();
+    const Byte* t_code = tokenisedProgram.data();
+    const Byte* t_code_end = t_code + tokenisedProgram.size();
     int line_no = -1;
-    while (t_code_iter < tokenisedProgram .end()  && !end_of_program) {
-        
-        Byte b = *t_code_iter++;
+    while (t_code < t_code_end && !end_of_program) {
+
+        Byte b = *t_code++;
 
         switch (t_state) {
 
@@ -253,7 +344,7 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                         int n_non_ABC_bytes = tape_file_sz - read_bytes;
                         if (mDebugInfo.verbose && n_non_ABC_bytes > 0) {
                             faultyTermination = true;
-                            if (mDebugInfo.verbose)
+                            if (mDebugInfo.verbose && sourceCode != NULL)
                                 cout << "Program file '" << program << "' contains " << n_non_ABC_bytes <<
                                 " extra bytes after end of program - skipping this data for BBC Micro BASIC file generation!\n";
                         }
@@ -270,10 +361,7 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                 else { // if (line_pos == 2) {
                     line_len = b;
                     line_no = line_no_high * 256 + line_no_low;
-                    stringstream ss;
-                    ss << setw(5) << line_no;
-                    string s = ss.str();
-                    for (int i = 0; i < s.length(); SourceProgram.push_back((Byte)s[i++]));
+                    addNumber(sourceCode, size, line_no, 5);
                     t_state = TOKENISATION;
                 }
                 break;
@@ -284,7 +372,7 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                     t_state = START_OF_LINE;
                     line_pos = 0;
                     if (!first_line) {
-                        SourceProgram.push_back(0xd);
+                        add(0xd);
                     }
                     first_line = false;
                 }
@@ -292,25 +380,19 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                 else {
 
                     // Check for keyword
-                    TokenEntry keyword_entry;
-                    string keyword = "";
-                    bool keyword_detected = false;
-                    if (mTokenDictId.find(b) != mTokenDictId.end()) {
-                        keyword_entry = mTokenDictId[(int) b];
-                        keyword = keyword_entry.fullT;
-                        keyword_detected = true;
-                    }
+                    int keyword_index = mTokenIndex[b];
+                    bool keyword_detected = (keyword_index >= 0);
 
                     bool stop_further_processing = false;
 
                     // Check for pending goto line no
                     if (t_state == PARSING_GOTO_LINE_NO) {
                         stop_further_processing = true;
-                        if (goto_line_bytes.length() == 0) {
+                        if (n_goto_line_bytes == 0) {
                             if (b == 0x20)
-                                SourceProgram.push_back(b);
+                                add(b);
                             else if (b == 0x8d)
-                                goto_line_bytes += (char)b;
+                                goto_line_bytes[n_goto_line_bytes++] = (char)b;
                             else { // Not an encoded line no => continue processing!
                                 t_state = TOKENISATION;
                                 stop_further_processing = false;
@@ -318,16 +400,13 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                         }
                         else { // some encoded bytes already read
 
-                            goto_line_bytes += (char)b;
-                            if (goto_line_bytes.length() == 4) {
+                            goto_line_bytes[n_goto_line_bytes++] = (char)b;
+                            if (n_goto_line_bytes == 4) {
 
                                 int goto_line;
-                                if (!decodeLineNo(goto_line_bytes, goto_line))
+                                if (!decodeLineNo(string(goto_line_bytes, 4), goto_line))
                                     return false;
-                                stringstream ss;
-                                ss << goto_line;
-                                string s = ss.str();
-                                for (int i = 0; i < s.length(); SourceProgram.push_back((Byte)s[i++]));
+                                addNumber(sourceCode, size, goto_line, 0);
                                 t_state = TOKENISATION;
                             }
                         }
@@ -335,17 +414,20 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
 
                     // No further tokenisation?
                     if (!stop_further_processing && t_state == NO_TOKENISATION) {
-                        SourceProgram.push_back(b);
+                        add(b);
                     }
 
                     if (!stop_further_processing && t_state == TOKENISATION) {
                         if (keyword_detected) {
                             // Add keyword to source code
-                            for (int i = 0; i < keyword.length(); SourceProgram.push_back((Byte)keyword[i++]));
+                            const TokenEntry& keyword_entry = mBBMTokens[keyword_index];
+                            if (sourceCode != NULL)
+                                memcpy(sourceCode + size, keyword_entry.fullT.data(), keyword_entry.fullT.length());
+                            size += keyword_entry.fullT.length();
                             // Check for GOTO-type of keyword
                             if (keyword_entry.tokeniseInfo & TokeniseInfo::GOTO_LINE) {
                                 t_state = PARSING_GOTO_LINE_NO;
-                                goto_line_bytes = "";
+                                n_goto_line_bytes = 0;
                             }
                             // Check for stop tokenisation-type of keyword
                             else if (keyword_entry.tokeniseInfo & TokeniseInfo::STOP_TOKENISE)
@@ -353,7 +435,7 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
                         }
                         else
                             // No (tokenised) keyword => add char to source code 'as is'
-                            SourceProgram.push_back(b);
+                            add(b);
                     }
 
                 }
@@ -369,8 +451,9 @@ bool AtomBasicCodec::detokeniseBBM(string program, Bytes& tokenisedProgram, Byte
     return true;
 }
 
-bool AtomBasicCodec::detokeniseAtom(string program, Bytes& tokenisedProgram, Bytes& SourceProgram, bool& faultyTermination)
+bool AtomBasicCodec::detokeniseAtom(string program, Bytes& tokenisedProgram, Byte* sourceCode, size_t& size, bool& faultyTermination)
 {
+    faultyTermination = false;
 
     int read_bytes = 0;
 
@@ -381,53 +464,57 @@ bool AtomBasicCodec::detokeniseAtom(string program, Bytes& tokenisedProgram, Byt
     bool first_line = true;
     bool end_of_program = false;
 
-    BytesIter t_code_iter = tokenisedProgram.begin();
-    while (t_code_iter < tokenisedProgram.end() && !end_of_program) {
-
-        Byte b = *t_code_iter++;
-
-        //
-        // Format of Acorn Atom BASIC program in memory:
-        // {<cr> <linehi> <linelo> <text>} <cr> <ff>
-        //
-        
-            if (line_pos == 0) {
-
-                if (b == 0xff) {
-                    end_of_program = true;
-                    int n_non_ABC_bytes = tape_file_sz - read_bytes;
-                    if (mDebugInfo.verbose)
-                        cout << "Program file '" << program << "' contains " << n_non_ABC_bytes <<
-                        " extra bytes after end of program - skipping this data for Acorn Atom BASIC file generation!\n";
-                }
-                else {
-                    line_no_high = int(b);
-                    line_pos++;
-                }
-            }
-            else if (line_pos == 1) {
-                int line_no_low = int(b);
-                line_pos = -1;
-                int line_no = line_no_high * 256 + line_no_low;
-                stringstream ss;
-                ss << setw(5) << line_no;
-                string s = ss.str();
-                for (int i = 0; i < s.length(); SourceProgram.push_back((Byte)s[i++]));
-            }
-            else if (b == 0xd) {
-                line_pos = 0;
-                if (!first_line) {
-                    SourceProgram.push_back(0xd);
-                }
-                first_line = false;
-
+    //
+    // Format of Acorn Atom BASIC program in memory:
+    // {<cr> <linehi> <linelo> <text>} <cr> <ff>
+    //
+    // The text is copied as is so only the start of each line needs to be found
+    //
+    const Byte* t_code = tokenisedProgram.data();
+    const Byte* t_code_end = t_code + tokenisedProgram.size();
+    while (t_code < t_code_end && !end_of_program) {
+
+        if (line_pos == 0) {
+
+            Byte b = *t_code++;
+            if (b == 0xff) {
+                end_of_program = true;
+                int n_non_ABC_bytes = tape_file_sz - read_bytes;
+                if (mDebugInfo.verbose && sourceCode != NULL)
+                    cout << "Program file '" << program << "' contains " << n_non_ABC_bytes <<
+                    " extra bytes after end of program - skipping this data for Acorn Atom BASIC file generation!\n";
             }
             else {
-                SourceProgram.push_back(b);
+                line_no_high = int(b);
+                line_pos++;
             }
-
-
-
+        }
+        else if (line_pos == 1) {
+            int line_no_low = int(*t_code++);
+            line_pos = -1;
+            int line_no = line_no_high * 256 + line_no_low;
+            addNumber(sourceCode, size, line_no, 5);
+        }
+        else if (*t_code == 0xd) {
+            t_code++;
+            line_pos = 0;
+            if (!first_line) {
+                if (sourceCode != NULL)
+                    sourceCode[size] = 0xd;
+                size++;
+            }
+            first_line = false;
+        }
+        else {
+            // Copy the text up to the end of the line
+            const Byte* text_end = (const Byte*) memchr(t_code, 0xd, t_code_end - t_code);
+            if (text_end == NULL)
+                text_end = t_code_end;
+            if (sourceCode != NULL)
+                memcpy(sourceCode + size, t_code, text_end - t_code);
+            size += text_end - t_code;
+            t_code = text_end;
+        }
 
     }
 
@@ -579,41 +666,41 @@ bool AtomBasicCodec::tokenise(string program, Bytes& sourceCode, Bytes& tokenise
         return false;
 
     // Tokenise each line
-    BytesIter bi = sourceCode.begin();
-    while (bi < sourceCode.end()) {
+    const char* src = (const char*) sourceCode.data();
+    size_t src_len = sourceCode.size();
+    size_t line_start = 0;
+    int line_no = 0;
+    while (line_start < src_len) {
 
         // Read line
-        string line;
-        string code ;
-        int line_no;
-        while (bi < sourceCode.end() && *bi != 0xd)
-            line += (char)*bi++;
-        if (bi < sourceCode.end())
-            bi++;
-        istringstream sin(line);
-
-        // Get line no
-        sin >> line_no;
+        const char* line_end_p = (const char*) memchr(src + line_start, 0xd, src_len - line_start);
+        size_t line_end = (line_end_p != NULL ? line_end_p - src : src_len);
+        string_view line(src + line_start, line_end - line_start);
+        line_start = (line_end < src_len ? line_end + 1 : line_end);
 
-        // Get rest of line
-        getline(sin, code);
+        // Get line no and rest of line
+        string_view code;
+        splitLine(line, line_no, code);
 
         // Add start of line (0xd) and line no
         tokenisedData.push_back(0xd);
         tokenisedData.push_back(line_no / 256);
-        tokenisedData.push_back(line_no % 256);  
+        tokenisedData.push_back(line_no % 256);
 
         if (mTargetMachine <= BBC_MASTER) {
-            string tCode;
-            if (!tokeniseLine(line_no, code, tCode)) {
+            // Tokenise the code directly into the tokenised data (after the line length that is only known afterwards)
+            size_t line_len_pos = tokenisedData.size();
+            tokenisedData.push_back(0x0);
+            if (!tokeniseLine(line_no, code, tokenisedData)) {
+                string tCode(tokenisedData.begin() + line_len_pos + 1, tokenisedData.end());
                 cout << "Failed to tokenise line '" << code << "' ('" << tCode << "')\n";
                 return false;
             }
-            tokenisedData.push_back((Byte) (4+tCode.length())); // line length + "size for <CR>,line no & line no"=4
-            for (int i = 0; i < tCode.length(); tokenisedData.push_back((Byte) tCode[i++]));
+            size_t tCode_len = tokenisedData.size() - line_len_pos - 1;
+            tokenisedData[line_len_pos] = (Byte) (4 + tCode_len); // line length + "size for <CR>,line no & line no"=4
         }
         else { // mTargetMachine == ACORN_ATOM
-            for (int i = 0; i < code.length(); tokenisedData.push_back((Byte) code[i++]));
+            tokenisedData.insert(tokenisedData.end(), code.begin(), code.end());
         }
     }
 
@@ -625,35 +712,75 @@ bool AtomBasicCodec::tokenise(string program, Bytes& sourceCode, Bytes& tokenise
 
 }
 
-bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
+//
+// Split a source code line into its line no and code.
+//
+// Gives the same result as reading the line no with 'istringstream >> int' and then the code with getline:
+// leading white space is skipped, a blank line keeps the line no it is given, a line without a (valid)
+// line no gets line no 0 and no code, and the code ends at any newline.
+//
+void AtomBasicCodec::splitLine(string_view line, int& lineNo, string_view& code)
+{
+    size_t pos = 0;
+    while (pos < line.length() && (line[pos] == ' ' || (line[pos] >= '\t' && line[pos] <= '\r')))
+        pos++;
+
+    code = string_view();
+    if (pos == line.length())
+        return;
+
+    bool negative = false;
+    if (pos < line.length() && (line[pos] == '+' || line[pos] == '-')) {
+        negative = (line[pos] == '-');
+        pos++;
+    }
+
+    size_t digits_start = pos;
+    long long n = 0;
+    while (pos < line.length() && line[pos] >= '0' && line[pos] <= '9') {
+        if (n <= (long long) INT_MAX + 1)
+            n = n * 10 + (line[pos] - '0');
+        pos++;
+    }
+    if (negative)
+        n = -n;
+
+    if (pos == digits_start)
+        lineNo = 0;
+    else if (n > INT_MAX)
+        lineNo = INT_MAX;
+    else if (n < INT_MIN)
+        lineNo = INT_MIN;
+    else {
+        lineNo = (int) n;
+        code = line.substr(pos);
+        size_t newline = code.find('\n');
+        if (newline != string_view::npos)
+            code = code.substr(0, newline);
+    }
+}
+
+bool AtomBasicCodec::tokeniseLine(int lineNo, string_view line, Bytes& tCode)
 {
-    string space, token;
-    TokenEntry entry;
-    int pos = 0;
+    string_view space, token;
+    const TokenEntry* entry;
     bool start_of_potential_sys_var_decl = true;
     bool within_string = false;
     bool fun_or_proc = false;
-    string code = line;
+    string_view code = line;
     bool no_tokenisation = false;
     uint8_t last_keyword_id;
-    string last_space;
+    string_view last_space;
     bool pending_conditional_tokenisation = false;
-    string last_token;
+    string_view last_token;
 
     bool pending_goto = false;
     bool pending_DEF = false;
 	bool pending_PROC = false;
 
-    tCode = "";
-    /*
-    cout << dec << setfill('0') << setw(5) << lineNo << " ";
-    for(int i=0; i< line.length(); i++)
-		cout << hex << setfill('0') << setw(2) << (int)line[i] << " ";
-    cout << "\n\t";
-    for (int i = 0; i < code.length(); i++)
-        cout << (char)line[i] << " ";
-    cout << "\n\t"; 
-    */
+    // The tokens are views of the line that are appended directly to the tokenised code
+    auto add = [&tCode](string_view text) { tCode.insert(tCode.end(), text.begin(), text.end()); };
+
     while (code.length() > 0) {
 
         bool skip_further_processing = false;
@@ -662,13 +789,7 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
         if (!getKeyWord(fun_or_proc, start_of_potential_sys_var_decl, within_string, code, space, token, entry)) {
             return false;
         }
-        bool keyword_detected = entry.fullT != "" && !no_tokenisation;
-        /*
-        if (keyword_detected)
-            cout << "[" << entry.fullT << ":" << hex << setw(2) << setfill('0') << (int)entry.id1 << "]";
-        else
-            cout << token;
-            */
+        bool keyword_detected = entry != NULL && !no_tokenisation;
 
         // Check for any pending conditional tokenisation of a keyword (from the last round)
         if (pending_conditional_tokenisation) {
@@ -679,27 +800,23 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
                 ((token[0] >= 'a' && token[0] <= 'z') || (token[0] >= 'A' && token[0] <= 'Z'))
             ) {
                 // Don't tokenise as followed by an alphabetic character
-                tCode += last_space + last_token;
-                //cout << "CONDITIONAL TOKENISATION at line " << lineNo << " of '" << last_token << "'" <<
-                //    " => NO TOKENISATION as followed by '" << space + token << "'\n";
+                add(last_space);
+                add(last_token);
             }
             else {
-                tCode += last_space + (char)last_keyword_id;
-                //cout << "CONDITIONAL TOKENISATION at line " << lineNo << " of '" << last_token << "'" <<
-                //    " => TOKENISATION as followed by '" << space + token << "'\n";
+                add(last_space);
+                tCode.push_back(last_keyword_id);
             }
         }
 
         // If the token was a keyword, then determine it's id
         uint8_t keyword_id = 0x0;
         if (keyword_detected) {
-            if ((entry.tokeniseInfo & ADD_40_FOR_START_OF_STATEMENT) && start_of_potential_sys_var_decl) {
-                keyword_id = entry.id1 + 0x40; // start of a statement <=> potential left side of assigment => add 0x40 to id
-                //cout << "ASSIGMENT at line " << lineNo << " of '" << last_token << "'" <<
-                //    " => add 0x40 to keyword id => 0x" << hex << keyword_id << " (instead of 0x " << entry.id1 << dec << ")\n";
+            if ((entry->tokeniseInfo & ADD_40_FOR_START_OF_STATEMENT) && start_of_potential_sys_var_decl) {
+                keyword_id = entry->id1 + 0x40; // start of a statement <=> potential left side of assigment => add 0x40 to id
             }
             else {
-                keyword_id = entry.id1;
+                keyword_id = entry->id1;
             }
         }
 
@@ -707,51 +824,47 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
         if (pending_goto) {
             pending_goto = false;
             int line_no;
-            if (entry.fullT == "" && token2Int(token, line_no) && line_no >= 0 && line_no < 32768) {
-                // A GOTO line no that shall be encoded identified           
+            if (entry == NULL && token2Int(token, line_no) && line_no >= 0 && line_no < 32768) {
+                // A GOTO line no that shall be encoded identified
                 string encoded_bytes;
                 if (!encodeLineNo(line_no, encoded_bytes))
                     return false;
-                tCode += space + encoded_bytes;
+                add(space);
+                add(encoded_bytes);
                 skip_further_processing = true; // stop this round
-                // cout << "GOTO line " << line_no << " to encode for keyword '" << last_token << "' at line " << lineNo << "\n";
             }
-            //cout << "NO GOTO LINE (but instead a token '" << token << "') to encode for keyword '" << last_token << "' at line " << lineNo << "\n";
-            //if (keyword_detected)
-            //    cout << "KEYWORD detected at line " << lineNo << "\n";
         }
 
         // Process a tokenisable keyword
         if (!skip_further_processing && !no_tokenisation && keyword_detected) {
 
-            if (entry.tokeniseInfo & TokeniseInfo::CONDITIONAL_TOKENISATION) {
+            if (entry->tokeniseInfo & TokeniseInfo::CONDITIONAL_TOKENISATION) {
                 // The tokenisation of the keyword is conditional and has to wait to next round (so save it)
                 pending_conditional_tokenisation = true;
             }
             else {
-                tCode += space + (char) keyword_id;
-                if (entry.tokeniseInfo & TokeniseInfo::GOTO_LINE) {
+                add(space);
+                tCode.push_back(keyword_id);
+                if (entry->tokeniseInfo & TokeniseInfo::GOTO_LINE) {
                     // Postpone processing of GOTO line no to next round
                     pending_goto = true;
-                    // cout << "GOTO-type of keyword '" << entry.fullT << "' at line " << lineNo << "\n";
                 }
-                else if (entry.tokeniseInfo & TokeniseInfo::STOP_TOKENISE) {
+                else if (entry->tokeniseInfo & TokeniseInfo::STOP_TOKENISE) {
                     // No further tokenisation shall be made for the line
                     no_tokenisation = true;
-                    // cout << "Stop tokenisation - type of keyword '" << entry.fullT << "' at line " << lineNo << "\n";
                 }
             }
 			// Check for start of statement where a declaration of a system variable (<system var> = <expr>) could be expected.
             // After THEN and ELSE a new statement will always start and it could potentially be a declaration.
-            if (entry.fullT == "THEN" || entry.fullT == "ELSE") // THEN, ELSE <=>  start of statement
+            if (entry->fullT == "THEN" || entry->fullT == "ELSE") // THEN, ELSE <=>  start of statement
                 start_of_potential_sys_var_decl = true;
             else
 				start_of_potential_sys_var_decl = false;
 
-            if (pending_DEF && entry.fullT == "PROC")
+            if (pending_DEF && entry->fullT == "PROC")
                 pending_PROC = true;
 
-            if (entry.fullT == "DEF")
+            if (entry->fullT == "DEF")
                 pending_DEF = true;
             else
 				pending_DEF = false;
@@ -759,7 +872,7 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
 
 
         }
-        
+
         // Process a non-keyword token (including non-tokenisable keyword)
         if (!skip_further_processing && !keyword_detected) {
 
@@ -779,7 +892,8 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
             if (token == "\"")
                 within_string = !within_string;
 
-            tCode += space + token;
+            add(space);
+            add(token);
         }
 
         if (keyword_detected)
@@ -794,49 +908,44 @@ bool AtomBasicCodec::tokeniseLine(int lineNo, string &line, string& tCode)
     if (pending_conditional_tokenisation) {
         // Decide whether the last keyword should be tokenised or not
         pending_conditional_tokenisation = false;
-       tCode += last_space + (char)last_keyword_id;
+        add(last_space);
+        tCode.push_back(last_keyword_id);
     }
-    /*
-    cout << "\n\t";
-    for (int i = 0; i < tCode.length(); i++)
-        cout << hex << setfill('0') << setw(2) << (int)(tCode[i] & 0xff) << " ";
-    cout << "\n\t";
-    for (int i = 0; i < tCode.length(); i++)
-        cout << (tCode[i] < 0x7f && tCode[i] >= 0x20 ? (char)tCode[i] : '.') << " ";
-    cout << "\n\n";
-    */
 
     return true;
 }
 
 bool AtomBasicCodec::isDelimiter(char c)
 {
-    const string delimiters = "'+-*/^!,<>?;[]:*{}@\"#$%&'()=~|_";
-
-    for (int i = 0; i < delimiters.length(); i++) {
-        if (c == delimiters[i])
-            return true;
-    }
-    return false;
+    // Table of all delimiters (built once)
+    static const vector<bool> delimiter_table = [] {
+        const string delimiters = "'+-*/^!,<>?;[]:*{}@\"#$%&'()=~|_";
+        vector<bool> table(256, false);
+        for (int i = 0; i < delimiters.length(); i++)
+            table[(Byte) delimiters[i]] = true;
+        return table;
+    }();
+
+    return delimiter_table[(Byte) c];
 }
 
 // Advance one token
-bool AtomBasicCodec::nextToken(string& text, string& token)
+bool AtomBasicCodec::nextToken(string_view& text, string_view& token)
 {
     // Check for end of line
     if (text.length() == 0) {
-        token = "";
+        token = string_view();
         return true;
     }
-    // 
+    //
     // Check for number
-    int pos = 0;
+    size_t pos = 0;
     while (pos < text.length() && !isDelimiter(text[pos]) && text[pos] >= '0' && text[pos] <= '9')
         pos++;
     if (pos > 0) {
         token = text.substr(0, pos);
-        text = text.substr(pos);
-       
+        text.remove_prefix(pos);
+
         return true;
     }
 
@@ -845,7 +954,7 @@ bool AtomBasicCodec::nextToken(string& text, string& token)
         pos++;
     if (pos > 0) {
         token = text.substr(0, pos);
-        text = text.substr(pos);
+        text.remove_prefix(pos);
 
         return true;
     }
@@ -856,7 +965,7 @@ bool AtomBasicCodec::nextToken(string& text, string& token)
         }
         if (pos > 0) {
             token = text.substr(0, pos);
-            text = text.substr(pos);
+            text.remove_prefix(pos);
 
             return true;
         }
@@ -865,42 +974,38 @@ bool AtomBasicCodec::nextToken(string& text, string& token)
     return false;
 }
 
-bool AtomBasicCodec::getKeyWord(bool &fun_or_proc, bool startOfStatement, bool withinString, string& text, string &space, string& token, TokenEntry& entry)
+bool AtomBasicCodec::getKeyWord(bool &fun_or_proc, bool startOfStatement, bool withinString, string_view& text, string_view& space, string_view& token, const TokenEntry*& entry)
 {
-    int pos = 0;
+    size_t pos = 0;
 
-    token = "";
-    const TokenEntry empty = { "", "", 0x00, 0x00 };
-    space = "";
-
-    entry = empty;
-
-    
+    token = string_view();
+    entry = NULL;
 
     // Skip initial space
     while (pos < text.length() && text[pos] == ' ')
         pos++;
-    if (pos > 0) {
-        space = text.substr(0, pos);
-        text = text.substr(pos);
-        pos = 0;
-    }
+    space = text.substr(0, pos);
+    text.remove_prefix(pos);
+    pos = 0;
 
     if (withinString)
         return nextToken(text, token);
 
     if (fun_or_proc) {
         fun_or_proc = false;
-        return nextToken(text, token);     
+        return nextToken(text, token);
     }
 
 
     // Get start of keyword that consists of pure upper-case letters
+    // (following the keyword trie for as long as the text could still be a keyword)
+    int node = BasicKeywordTrie::root;
     int first_matched_pos = -1;
-    TokenEntry first_matched_keyword = empty;
     while (pos < text.length() && (first_matched_pos != -1 || text[pos] >= 'A' && text[pos] <= 'Z')) {
-        token = text.substr(0, pos+1);
-        if (pos > 0 && mTokenDictStr.find(token) != mTokenDictStr.end()) {
+        node = mKeywords.next(node, text[pos]);
+        if (node < 0 && first_matched_pos != -1)
+            break; // no longer keyword can be matched
+        if (pos > 0 && mKeywords.keyword(node) >= 0) {
             // Some full keywords could be a sub string of another one:
             //  END(PROC), ERR(OR), GET($), INKEY($), MOD(E)
             // If a match for the shorter keyword is made, we need to
@@ -908,13 +1013,12 @@ bool AtomBasicCodec::getKeyWord(bool &fun_or_proc, bool startOfStatement, bool w
             // If the longer is matched, that one shall be used and not
             // the shorter one.
             if (first_matched_pos == -1) {
-                first_matched_pos = pos;
-                first_matched_keyword = mTokenDictStr[token];               
+                first_matched_pos = (int) pos;
             }
             else {
-                text = text.substr(pos+1);
-                entry = mTokenDictStr[token];
-                //cout << "\n*** " << entry.fullT << " *** \n";
+                token = text.substr(0, pos + 1);
+                text.remove_prefix(pos + 1);
+                entry = &mBBMTokens[mKeywords.keyword(node)];
                 return true;
             }
         }
@@ -925,7 +1029,7 @@ bool AtomBasicCodec::getKeyWord(bool &fun_or_proc, bool startOfStatement, bool w
     // If a complete keyword was matched previously, then use it!
     if (first_matched_pos != -1) {
         (void) matchAgainstKeyword(text, first_matched_pos + 1, token, entry);
-        if (entry.fullT == "FN" || entry.fullT == "PROC")
+        if (entry->fullT == "FN" || entry->fullT == "PROC")
             fun_or_proc = true;
         return true;
     }
@@ -957,21 +1061,55 @@ bool AtomBasicCodec::getKeyWord(bool &fun_or_proc, bool startOfStatement, bool w
     else
         return nextToken(text, token);
 
-
-    return true;
-
 }
 
-bool AtomBasicCodec::matchAgainstKeyword(string& text, int pos, string& token, TokenEntry& entry) {
+bool AtomBasicCodec::matchAgainstKeyword(string_view& text, size_t pos, string_view& token, const TokenEntry*& entry) {
     token = text.substr(0, pos);
-    if (mTokenDictStr.find(token) != mTokenDictStr.end()) {
-        text = text.substr(pos);
-        entry = mTokenDictStr[token];
+    int keyword = mKeywords.find(token);
+    if (keyword >= 0) {
+        text.remove_prefix(pos);
+        entry = &mBBMTokens[keyword];
         return true;
     }
     return false;
 }
 
+int BasicKeywordTrie::charIndex(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    else if (c == '$')
+        return 26;
+    else if (c == '(')
+        return 27;
+    else if (c == '.')
+        return 28;
+    else
+        return -1;
+}
+
+void BasicKeywordTrie::add(const string& keyword, int keywordIndex)
+{
+    int node = root;
+    for (int i = 0; i < keyword.length(); i++) {
+        int c = charIndex(keyword[i]);
+        if (mNodes[node].child[c] < 0) {
+            mNodes[node].child[c] = (int16_t) mNodes.size();
+            mNodes.push_back(Node());
+        }
+        node = mNodes[node].child[c];
+    }
+    mNodes[node].keyword = (int16_t) keywordIndex;
+}
+
+int BasicKeywordTrie::find(string_view text)
+{
+    int node = root;
+    for (int i = 0; node >= 0 && i < text.length(); i++)
+        node = next(node, text[i]);
+    return keyword(node);
+}
+
 // Tokenising the line number:
     // The top two bits are split off each of the two bytes of the 16-bit line number.
     // These bits are combined (in binary as 00LlHh00), exclusive-ORred with 0x54, and
@@ -1013,12 +1151,15 @@ bool AtomBasicCodec::decodeLineNo(string encodedBytes, int& lineNo)
     return true;
 }
 
-bool AtomBasicCodec::token2Int(string token, int &num)
+bool AtomBasicCodec::token2Int(string_view token, int &num)
 {
     try {
-        num = stoi(token);
+        num = stoi(string(token));
+    }
+    catch (const invalid_argument&) {
+        return false;
     }
-    catch (const invalid_argument) {
+    catch (const out_of_range&) {
         return false;
     }
 
@@ -2,6 +2,8 @@
 
 #include "FileBlock.h"
 #include <map>
+#include <string_view>
+#include <cstdint>
 #include "Logging.h"
 
 
@@ -47,6 +49,53 @@ public:
 
 
 
+//
+// Trie of the BBC Micro BASIC keywords and their abbreviations (e.g., "P.", "PR.", "PRI.", "PRIN." and "PRINT"
+// for PRINT) used to match keywords in place - character by character - without creating any sub strings.
+//
+// Each node has one child per character that can be part of a keyword ('A' to 'Z', '$', '(' and '.')
+// and refers to the keyword (as an index in the token table) that ends at the node (if any).
+//
+class BasicKeywordTrie
+{
+
+private:
+
+	static const int mNChars = 29;
+
+	class Node {
+	public:
+		int16_t child[mNChars];
+		int16_t keyword = -1;
+		Node() { for (int i = 0; i < mNChars; i++) child[i] = -1; }
+	};
+
+	vector<Node> mNodes = vector<Node>(1);
+
+	static int charIndex(char c);
+
+public:
+
+	static const int root = 0;
+
+	// Add a keyword (replacing any keyword previously added with the same text)
+	void add(const string& keyword, int keywordIndex);
+
+	// Node reached from a node by character c (-1 if no keyword continues with c or if node is -1)
+	int next(int node, char c)
+	{
+		int i = charIndex(c);
+		return (node < 0 || i < 0 ? -1 : mNodes[node].child[i]);
+	}
+
+	// The keyword that ends at a node (-1 if none)
+	int keyword(int node) { return (node < 0 ? -1 : mNodes[node].keyword); }
+
+	// The keyword that is exactly the text (-1 if none)
+	int find(string_view text);
+};
+
+
 class AtomBasicCodec
 {
 
@@ -181,14 +230,14 @@ private:
 		{"WIDTH",		"W.",		0xFE, 0x02}
 	};
 
-	map<int, TokenEntry> mTokenDictId;
-	map<string, TokenEntry> mTokenDictStr;
+	int16_t mTokenIndex[256]; // keyword id => index in mBBMTokens (-1 if not a keyword)
+	BasicKeywordTrie mKeywords; // keywords (including abbreviations of keywords) => index in mBBMTokens
 
 	// Encode/decode the line number (BBC Micro only)
 	bool encodeLineNo(int lineNo, string &encodedBytes);
 	bool decodeLineNo(string encodedBytes, int& lineNo);
 
-	bool token2Int(string token, int& num);
+	bool token2Int(string_view token, int& num);
 
 
 public:
@@ -202,6 +251,9 @@ public:
 	bool detokenise(string program, Bytes& tokenisedProgram, string& filePath, bool& faultyTermination);
 	bool detokenise(string program, Bytes& tokenisedProgram, Bytes &sourceCode, bool& faultyTermination);
 
+	// Detokenise several Tape Files (tapeFiles[i] into dstFiles[i]) in parallel using nThreads threads (0 <=> one per hardware thread)
+	bool detokenise(vector<TapeFile*>& tapeFiles, vector<string>& dstFiles, int nThreads = 0);
+
 
 	 // Encode (tokenise) BBC Basic source code as tokenised data
 	bool tokenise(string& srcFile, string& dstFile);
@@ -214,15 +266,23 @@ private:
 	bool readFileBytes(bool tokenisedBytes, string& srcFile, Bytes& data, string& program);
 	bool writeFileBytes(bool tokenisedBytes, string program, Bytes& data, string& dstFile);
 
-	bool getKeyWord(bool& fun_or_proc, bool startOfStatement, bool withinString, string& text, string &space, string &token, TokenEntry& entry);
+	bool getKeyWord(bool& fun_or_proc, bool startOfStatement, bool withinString, string_view& text, string_view& space, string_view& token, const TokenEntry*& entry);
 	bool isDelimiter(char);
-	bool nextToken(string& text, string& token);
+	bool nextToken(string_view& text, string_view& token);
 
 	bool detokeniseAtom(string program, Bytes& tokenisedProgram, Bytes& sourceCode, bool& faultyTermination);
 	bool detokeniseBBM(string program, Bytes& tokenisedProgram, Bytes& sourceCode, bool& faultyTermination);
 
-	bool tokeniseLine(int lineNo, string &line, string  &tCode);
+	// Detokenise into sourceCode (or only count the no of bytes the source code will have if sourceCode is NULL)
+	bool detokeniseAtom(string program, Bytes& tokenisedProgram, Byte* sourceCode, size_t& size, bool& faultyTermination);
+	bool detokeniseBBM(string program, Bytes& tokenisedProgram, Byte* sourceCode, size_t& size, bool& faultyTermination);
+
+	// Split a source code line into its line no and code (as for reading the line no with >> and then the rest of the line with getline)
+	void splitLine(string_view line, int& lineNo, string_view& code);
+
+	// Tokenise the code of a line (appending the tokenised code to tCode)
+	bool tokeniseLine(int lineNo, string_view line, Bytes& tCode);
 
-	bool matchAgainstKeyword(string& text, int pos, string& token, TokenEntry& entry);
+	bool matchAgainstKeyword(string_view& text, size_t pos, string_view& token, const TokenEntry*& entry);
 };
 
@@ -89,7 +89,15 @@ bool BinCodec::encode(TapeFile& tapeFile, string& binFileName)
 //
 bool BinCodec::decode(FileHeader fileMetaData, Bytes &data, TapeFile& tapeFile)
 {
-    if (data.size() == 0)
+    return decode(fileMetaData, data.data(), data.size(), tapeFile);
+}
+
+//
+// Decode binary data (e.g., referring directly to a disc image) without first copying it
+//
+bool BinCodec::decode(FileHeader fileMetaData, const Byte* data, size_t dataSize, TapeFile& tapeFile)
+{
+    if (dataSize == 0)
         return false;
 
     FileBlock block(fileMetaData.targetMachine);
@@ -104,56 +112,38 @@ bool BinCodec::decode(FileHeader fileMetaData, Bytes &data, TapeFile& tapeFile)
 
     int load_adr = fileMetaData.loadAdr;
     int block_no = 0;
-    bool new_block = true;
-    int count = 0;
-    BytesIter data_iter = data.begin();
-    int block_sz;
-    int tape_file_sz = 0;
-
-    while (data_iter < data.end()) {
+    const Byte* data_p = data;
+    const Byte* data_end = data + dataSize;
 
-        if (new_block) {
-            count = 0;
-            if (data.end() - data_iter < 256)
-                block_sz = (int)(data.end() - data_iter);
-            else
-                block_sz = 256;
-            tape_file_sz += block_sz;
+    while (data_p < data_end) {
 
-            if (!block.init())
-                return false;
+        // Each block has (up to) 256 bytes
+        int block_sz = (int) min((ptrdiff_t) 256, data_end - data_p);
 
-            block.targetMachine = fileMetaData.targetMachine;
+        if (!block.init())
+            return false;
 
-            if (!block.encodeTAPHdr(block_name, fileMetaData.loadAdr, load_adr, fileMetaData.execAdr, block_no, block_sz)) {
-                cout << "Failed to encode Tape File header for program '" << block_name << "'!\n";
-                return false;
-            }
-            new_block = false;
+        block.targetMachine = fileMetaData.targetMachine;
 
+        if (!block.encodeTAPHdr(block_name, fileMetaData.loadAdr, load_adr, fileMetaData.execAdr, block_no, block_sz)) {
+            cout << "Failed to encode Tape File header for program '" << block_name << "'!\n";
+            return false;
         }
 
-        if (count < block_sz) {
-            block.data.push_back(*data_iter++);
-            count++;
-        }
-        if (count == block_sz) {
-
-            if (mDebugInfo.verbose)
-                block.logFileBlockHdr();
-
-            // Mirror the complete file's locked status to each block
-            block.locked = tapeFile.header.locked;
+        block.data.insert(block.data.end(), data_p, data_p + block_sz);
+        data_p += block_sz;
 
-            tapeFile.blocks.push_back(block);
-            new_block = true;
+        if (mDebugInfo.verbose)
+            block.logFileBlockHdr();
 
-            if (fileMetaData.targetMachine == ACORN_ATOM)
-                load_adr += count;
-            block_no++;
-         }
+        // Mirror the complete file's locked status to each block
+        block.locked = tapeFile.header.locked;
 
+        tapeFile.blocks.push_back(block);
 
+        if (fileMetaData.targetMachine == ACORN_ATOM)
+            load_adr += block_sz;
+        block_no++;
     }
 
     // Set the type for each block (FIRST, LAST, OTHER or SINGLE) - can only be made when the no of blocks are known
@@ -174,13 +164,17 @@ bool BinCodec::decode(FileHeader fileMetaData, Bytes &data, TapeFile& tapeFile)
 }
 
 bool BinCodec::generateInfFile(string dir, TapeFile& tapeFile)
+{
+    return writeInfFile(Utility::crEncodedFileNamefromDir(dir, tapeFile, "inf"), tapeFile);
+}
+
+bool BinCodec::writeInfFile(string INFFileName, TapeFile& tapeFile)
 {
     if (tapeFile.blocks.size() == 0)
         return false;
 
     // Create INF file
-    string INF_file_name = Utility::crEncodedFileNamefromDir(dir, tapeFile, "inf");
-    ofstream INF_file(INF_file_name, ios::out);
+    ofstream INF_file(INFFileName, ios::out);
 
     if (!INF_file)
         return false;
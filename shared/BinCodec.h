@@ -29,8 +29,10 @@ public:
 	// Decode binary data as TAP File structure
 	//
 	bool decode(FileHeader fileMetaData, Bytes &data, TapeFile& tapFile);
+	bool decode(FileHeader fileMetaData, const Byte* data, size_t dataSize, TapeFile& tapFile);
 
 	static bool generateInfFile(string dir, TapeFile& tapeFile);
+	static bool writeInfFile(string INFFileName, TapeFile& tapeFile);
 
 
 private:
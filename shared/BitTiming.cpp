@@ -11,6 +11,7 @@ bool BitTiming::setBitTiming(int sampleFreq, double baseFreq, int baudRate, Targ
 {
 
     fS = sampleFreq;
+    this->baseFreq = baseFreq;
 
     if (baudRate == 300) {
         startBitCycles = 4; // Start bit length in cycles of F1 frequency carrier
@@ -31,6 +31,7 @@ public:
     double F1Samples = 44100 / 1200; // No of samples for a complete F1 cycle
 
     int fS = 44100; // sample frequency
+    double baseFreq = 1200; // base frequency (F1) the timing is based on
 
     int F2CyclesPerByte = 8 + 8 * 8 + 9; // start bit + 8 data bits + 1 stop bit (with extra wave)
   
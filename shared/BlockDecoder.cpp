@@ -1,4 +1,5 @@
 #include "BlockDecoder.h"
+#include "DecoderChain.h"
 #include "WaveSampleTypes.h"
 #include <iostream>
 #include "Logging.h"
@@ -6,8 +7,8 @@
 #include <cmath>
 
 
-BlockDecoder::BlockDecoder(
-	TapeReader& tapeReader, Logging logging, TargetMachine targetMachine, bool limitBlockNo) :
+template <class TR> BlockDecoderT<TR>::BlockDecoderT(
+	TR& tapeReader, Logging logging, TargetMachine targetMachine, bool limitBlockNo) :
 	mReader(tapeReader), mDebugInfo(logging), mTargetMachine(targetMachine), mLimitBlockNo(limitBlockNo)
 {
 	nReadBytes = 0; // Not needed but made to make compiler happy
@@ -15,7 +16,7 @@ BlockDecoder::BlockDecoder(
 
 
 
-bool BlockDecoder::checkByte(Byte refVal, Byte& readVal) {
+template <class TR> bool BlockDecoderT<TR>::checkByte(Byte refVal, Byte& readVal) {
 	if (!mReader.readByte(readVal) || readVal != refVal) {
 		return false;
 	}
@@ -24,7 +25,7 @@ bool BlockDecoder::checkByte(Byte refVal, Byte& readVal) {
 
 
 
-bool BlockDecoder::checkBytes(Bytes &bytes, Byte refVal, int n) {
+template <class TR> bool BlockDecoderT<TR>::checkBytes(Bytes &bytes, Byte refVal, int n) {
 	bool failed = false;
 	int start_cycle = 0;
 	for (int i = start_cycle; i < n && !failed; i++) {
@@ -39,9 +40,30 @@ bool BlockDecoder::checkBytes(Bytes &bytes, Byte refVal, int n) {
 	return !failed;
 }
 
-bool BlockDecoder::getWord(Word* word)
+template <class TR> bool BlockDecoderT<TR>::readFrames(Bytes& bytes, int n, int& nReadBytes)
 {
-	Bytes bytes;
+	ByteFrames& frames = mFrames;
+	frames.clear();
+	bool success = mReader.readFrames(n, frames);
+	nReadBytes = (int) frames.bytes.size();
+	bytes.insert(bytes.end(), frames.bytes.begin(), frames.bytes.end());
+
+	if (mDebugInfo.verbose && frames.errorPositions.size() > 0) {
+		cout << dec << frames.errorPositions.size() << " out of " << nReadBytes << " bytes decoded with low confidence:";
+		for (int i = 0; i < frames.errorPositions.size(); i++) {
+			int pos = frames.errorPositions[i];
+			cout << " #" << pos << " (0x" << hex << (int) frames.bytes[pos] << dec << ", " << (int) frames.confidence[pos] << "%)";
+		}
+		cout << " before " << Utility::encodeTime(getTime()) << "\n";
+	}
+
+	return success;
+}
+
+template <class TR> bool BlockDecoderT<TR>::getWord(Word* word)
+{
+	Bytes& bytes = mWordBytes;
+	bytes.clear();
 	if (!mReader.readBytes(bytes, 2)) {
 		return false;
 	}
@@ -49,7 +71,7 @@ bool BlockDecoder::getWord(Word* word)
 	return true;
 }
 
-int BlockDecoder::getMinLeadCarrierCycles(bool firstBlock, BlockTiming blockTiming, TargetMachine targetMachine, double carrierFreq)
+template <class TR> int BlockDecoderT<TR>::getMinLeadCarrierCycles(bool firstBlock, BlockTiming blockTiming, TargetMachine targetMachine, double carrierFreq)
 {
 	double carrier_duration;
 	int carrierCycles;
@@ -83,7 +105,7 @@ int BlockDecoder::getMinLeadCarrierCycles(bool firstBlock, BlockTiming blockTimi
  * values than above are used to have some margin.
  * 
  */
-bool BlockDecoder::readBlock(
+template <class TR> bool BlockDecoderT<TR>::readBlock(
 	BlockTiming blockTiming, bool firstBlock, FileBlock& readBlock, bool& leadToneDetected, BlockError& readStatus
 )
 {
@@ -139,7 +161,8 @@ bool BlockDecoder::readBlock(
 
 	// Read block header's preamble (i.e., synchronisation bytes)
 	int nPremable = 1;
-	Bytes preamble_bytes;
+	Bytes& preamble_bytes = mPreambleBytes;
+	preamble_bytes.clear();
 	if (mTargetMachine == ACORN_ATOM)
 		nPremable = 4;
 	if (!checkBytes(preamble_bytes, 0x2a, nPremable)) {
@@ -148,7 +171,7 @@ bool BlockDecoder::readBlock(
 		return false;
 	}
 	if (mTargetMachine == ACORN_ATOM) // For Atom the premable is included in the CRC
-		updateCRC(readBlock, crc, preamble_bytes);
+		updateCRC(crc, preamble_bytes);
 
 
 	// Get phaseshift when transitioning from lead tone to start bit.
@@ -156,16 +179,18 @@ bool BlockDecoder::readBlock(
 	readBlock.phaseShift = mReader.getPhaseShift();
 
 	// Read block name
-	Bytes name_bytes;
+	Bytes& name_bytes = mNameBytes;
+	name_bytes.clear();
 	if (!getBlockName(name_bytes)) {
 		if (mDebugInfo.tracing)
 			DEBUG_PRINT(getTime(), ERR, "Failed to read header block name%s\n", "");
 		return false;
 	}
-	updateCRC(readBlock, crc, name_bytes);
+	updateCRC(crc, name_bytes);
 
 	// Read rest of header (excluding any CRC)
-	Bytes hdr_bytes;
+	Bytes& hdr_bytes = mHdrBytes;
+	hdr_bytes.clear();
 	int n_read_bytes; // see how many bytes was successfully read
 	if (!mReader.readBytes(hdr_bytes, readBlock.tapeHdrSz(), n_read_bytes)) {
 		if (mDebugInfo.tracing)
@@ -176,7 +201,7 @@ bool BlockDecoder::readBlock(
 	readStatus = BlockError(readStatus ^ BLOCK_HDR_INCOMPLETE);
 	readBlock.completeHdr = true;
 	nReadBytes += n_read_bytes;
-	updateCRC(readBlock, crc, hdr_bytes);
+	updateCRC(crc, hdr_bytes);
 
 	// Decode header
 	if (!readBlock.decodeTapeBlockHdr(name_bytes, hdr_bytes, mLimitBlockNo)) {
@@ -236,13 +261,13 @@ bool BlockDecoder::readBlock(
 	// Get data bytes (if they exist)
 	int block_len = readBlock.size;
 	if (block_len > 0) {
-		if (!mReader.readBytes(readBlock.data, block_len, n_read_bytes)) {
+		if (!readFrames(readBlock.data, block_len, n_read_bytes)) {
 			if (mDebugInfo.tracing)
 				DEBUG_PRINT(getTime(), ERR, "Failed to read block data for file '%s'!\n", readBlock.name.c_str());
 			nReadBytes += n_read_bytes;
 			return false;
 		}
-		updateCRC(readBlock, crc, readBlock.data);
+		updateCRC(crc, readBlock.data);
 		nReadBytes += n_read_bytes;
 
 		if (mDebugInfo.verbose)
@@ -321,7 +346,6 @@ bool BlockDecoder::readBlock(
 		// After detection, there will be a roll back to the end of the block
 		// so that the next block detection will not miss the lead tone.
 		checkpoint();
-		FileBlock saved_block = readBlock;
 		int min_carrier_cycles, carrier_cycles;
 		double waiting_time;
 		min_carrier_cycles = getMinLeadCarrierCycles(true, blockTiming, mTargetMachine, mReader.carrierFreq());
@@ -340,7 +364,6 @@ bool BlockDecoder::readBlock(
 			}
 		}
 		rollback();
-		readBlock = saved_block;
 		readBlock.blockGap = waiting_time;
 
 	}
@@ -355,7 +378,7 @@ bool BlockDecoder::readBlock(
 	return true;
 }
 
-bool BlockDecoder::getBlockName(Bytes &name)
+template <class TR> bool BlockDecoderT<TR>::getBlockName(Bytes &name)
 {
 
 	Byte b;
@@ -381,24 +404,33 @@ bool BlockDecoder::getBlockName(Bytes &name)
 }
 
 
-bool BlockDecoder::updateCRC(FileBlock block, Word& crc, Bytes data)
+template <class TR> bool BlockDecoderT<TR>::updateCRC(Word& crc, const Bytes& data)
 {
 	if (data.size() == 0)
 		return false;
 
-	for(int i = 0; i < data.size(); block.updateCRC(crc,data[i++]));
+	for(int i = 0; i < data.size(); FileBlock::updateCRC(mTargetMachine, crc, data[i++]));
 
 	return true;
 }
 
 // Save the current file position
-bool BlockDecoder::checkpoint()
+template <class TR> bool BlockDecoderT<TR>::checkpoint()
 {
 	return mReader.checkpoint();
 }
 
 // Roll back to a previously saved file position
-bool BlockDecoder::rollback()
+template <class TR> bool BlockDecoderT<TR>::rollback()
 {
 	return mReader.rollback();
-}
\ No newline at end of file
+}
+
+// Polymorphic block decoder (any tape reader)
+template class BlockDecoderT<TapeReader>;
+
+// Block decoders with the tape reader resolved at compile time
+template class BlockDecoderT<WavSampleTapeReader>;
+template class BlockDecoderT<FSKSampleTapeReader>;
+template class BlockDecoderT<CSWPulseTapeReader>;
+template class BlockDecoderT<UEFTapeReader>;
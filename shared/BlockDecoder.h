@@ -37,12 +37,20 @@ inline BlockError& operator&=(BlockError& left, BlockError right) {
 	return left = left & right;
 }
 
-class BlockDecoder
+//
+// Block decoder reading blocks from a tape reader.
+//
+// The type of tape reader is a template parameter. With the (abstract) TapeReader
+// (i.e., BlockDecoder) all calls to the tape reader are virtual. With a concrete (final)
+// tape reader type, the calls are resolved at compile time.
+// The supported instantiations are made in BlockDecoder.cpp.
+//
+template <class TR> class BlockDecoderT
 {
 
 protected:
 
-	TapeReader &mReader;
+	TR &mReader;
 
 	Logging mDebugInfo;
 
@@ -50,12 +58,19 @@ protected:
 
 	bool mLimitBlockNo = false;
 
+	// Buffers reused for every block read (so that reading a block doesn't allocate any memory for them)
+	Bytes mPreambleBytes;
+	Bytes mNameBytes;
+	Bytes mHdrBytes;
+	Bytes mWordBytes;
+	ByteFrames mFrames;
+
 public:
 
 
 	int nReadBytes;
 
-	BlockDecoder(TapeReader& tapeReader, Logging logging, TargetMachine targetMachine, bool limitBlockNo = false);
+	BlockDecoderT(TR& tapeReader, Logging logging, TargetMachine targetMachine, bool limitBlockNo = false);
 
 	bool readBlock(BlockTiming blockTiming, bool firstBlock, FileBlock& readBlock, bool& leadToneDetected, BlockError &readStatus);
 
@@ -70,7 +85,7 @@ public:
 
 protected:
 
-	bool updateCRC(FileBlock block, Word& crc, Bytes data);
+	bool updateCRC(Word& crc, const Bytes& data);
 
 	// Get a word (two bytes)
 	bool getWord(Word* word);
@@ -79,6 +94,9 @@ protected:
 
 	bool checkBytes(Bytes &bytes, Byte refVal, int n);
 
+	// Read n bytes as byte frames in one go (logging any bytes decoded with low confidence)
+	bool readFrames(Bytes& bytes, int n, int& nReadBytes);
+
 	// Get block name
 	bool getBlockName(Bytes& name);
 
@@ -86,4 +104,7 @@ protected:
 
 };
 
+// Block decoder for any type of tape reader
+typedef BlockDecoderT<TapeReader> BlockDecoder;
+
 #endif
\ No newline at end of file
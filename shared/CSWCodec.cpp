@@ -733,6 +733,19 @@ bool CSWCodec::writeByte(Byte byte, DataEncoding encoding)
 
 }
 
+bool CSWCodec::writeBytes(const Byte* bytes, size_t n, DataEncoding encoding)
+{
+    // Each byte results in at most two pulses per F2 cycle
+    mPulses.reserve(mPulses.size() + n * 2 * mBitTiming.F2CyclesPerByte);
+
+    for (size_t i = 0; i < n; i++) {
+        if (!writeByte(bytes[i], encoding))
+            return false;
+    }
+
+    return true;
+}
+
 bool CSWCodec::writeDataBit(int bit)
 {
     int n_cycles;
@@ -855,6 +868,33 @@ bool CSWCodec::writeHalfCycle(unsigned nSamples)
     return writePulse(nSamples);
 }
 
+bool CSWCodec::writeHalfCycles(const vector<uint32_t>& durations)
+{
+    // Most pulses fit into one byte
+    mPulses.reserve(mPulses.size() + durations.size());
+
+    for (size_t i = 0; i < durations.size(); i++) {
+        if (!writePulse(durations[i]))
+            return false;
+    }
+
+    return true;
+}
+
+bool CSWCodec::writeSinglePulse(bool highFreq, Level level)
+{
+    double n_samples = (highFreq ? mBitTiming.F2Samples : mBitTiming.F1Samples) / 2;
+
+    // The level of a CSW pulse is given by the previous pulse (the pulses alternate) so a pulse
+    // of the requested level can only be written if the previous pulse had the other level
+    Level pulse_level = (mPulseLevel == Level::LowLevel ? Level::HighLevel : Level::LowLevel);
+    if (level != pulse_level)
+        cout << "Single " << (level == Level::HighLevel ? "high" : "low") << " pulse written as a " <<
+        (pulse_level == Level::HighLevel ? "high" : "low") << " pulse as it must follow a pulse of the same level!\n";
+
+    return writePulse((unsigned) round(n_samples));
+}
+
 bool CSWCodec::writeCycle(bool highFreq, unsigned n)
 {
     if (n == 0)
@@ -130,6 +130,7 @@ public:
 	static bool isCSWFile(string& CSWFileName);
 
 	bool writeByte(Byte byte, DataEncoding encoding);
+	bool writeDataBit(int bit);
 	bool writeTone(double duration);
 	bool writeGap(double duration);
 
@@ -140,6 +141,18 @@ public:
 	bool writeSamples(string filePath);
 
 	bool writeHalfCycle(unsigned nSamples);
+
+	// Write a sequence of 1/2 cycles (durations in samples) in one go
+	bool writeHalfCycles(const vector<uint32_t>& durations);
+
+	// Write n bytes in one go (reserving pulse space for all of them first)
+	bool writeBytes(const Byte* bytes, size_t n, DataEncoding encoding);
+
+	// Write a single 1/2 cycle of either F1 or F2 (its level is implied by the previous pulse - a mismatch with level is reported)
+	bool writeSinglePulse(bool highFreq, Level level);
+
+	// Write n cycles of either F1 or F2
+	bool writeCycle(bool high, unsigned n);
 	
 
 private:
@@ -148,7 +161,7 @@ private:
 	BitTiming mBitTiming;
 
 	// Current pulse level (writing)
-	Level mPulseLevel;
+	Level mPulseLevel = Level::LowLevel; // the CSW header specifies a low initial polarity
 
 	// Pulses read or to write
 	Bytes mPulses;
@@ -156,12 +169,9 @@ private:
 	Word mCRC = 0;
 
 
-	bool writeDataBit(int bit);
 	bool writeStartBit();
 	bool writeStopBit(DataEncoding encoding);
 
-	bool writeCycle(bool high, unsigned n);
-
 	bool writePulse(unsigned len);
 	
 
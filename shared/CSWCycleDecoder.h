@@ -8,7 +8,7 @@
 
 
 
-class CSWCycleDecoder : public CycleDecoder
+class CSWCycleDecoder final : public CycleDecoder
 {
 
 	class PulseInfo {
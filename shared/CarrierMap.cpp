@@ -0,0 +1,103 @@
+#include "CarrierMap.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+CarrierMap::CarrierMap(int sampleFreq, Samples& samples, double freqThreshold, Logging logging) : mDebugInfo(logging)
+{
+	mNSamples = (int) samples.size();
+	mWindowSize = max(1, (int) round(sampleFreq * mWindowDuration));
+	int n_windows = (mNSamples + mWindowSize - 1) / mWindowSize;
+
+	// Measure the envelope and the no of zero crossings (with the same sign convention as the LevelDecoder
+	// uses with a zero level threshold) of each window
+	vector<int> envelopes(n_windows);
+	vector<int> crossings(n_windows);
+	const Sample* s = samples.data();
+	for (int w = 0; w < n_windows; w++) {
+		int start = w * mWindowSize;
+		int end = min(start + mWindowSize, mNSamples);
+		int peak = 0;
+		for (int i = start; i < end; i++) {
+			int a = abs((int) s[i]);
+			peak = (a > peak ? a : peak);
+		}
+		int n_crossings = 0;
+		for (int i = max(start, 1); i < end; i++)
+			n_crossings += ((s[i - 1] >> 15) ^ (s[i] >> 15)) & 1;
+		envelopes[w] = peak;
+		crossings[w] = n_crossings;
+	}
+
+	// A tone of frequency f has 2f zero crossings per second. A possible carrier has at least half the zero crossings
+	// of an F1 tone (at the lowest tolerated frequency) as a window can be only partly filled by the tone.
+	double min_crossings = F1_FREQ * (1 - freqThreshold) * mWindowDuration;
+
+	// The typical carrier envelope is taken as a high percentile of all envelopes (to not be affected by clicks)
+	int carrier_envelope = 0;
+	if (n_windows > 0) {
+		vector<int> sorted_envelopes = envelopes;
+		int percentile_pos = (int) (0.99 * (n_windows - 1));
+		nth_element(sorted_envelopes.begin(), sorted_envelopes.begin() + percentile_pos, sorted_envelopes.end());
+		carrier_envelope = sorted_envelopes[percentile_pos];
+	}
+	double silence_envelope = carrier_envelope * mSilenceLevel;
+
+	// Classify each window
+	mRegions.resize(n_windows);
+	int n_region_windows[3] = { 0, 0, 0 };
+	for (int w = 0; w < n_windows; w++) {
+		Region r;
+		if (envelopes[w] <= silence_envelope)
+			r = SILENCE_REGION;
+		else if (crossings[w] < min_crossings)
+			r = NOISE_REGION;
+		else
+			r = CARRIER_REGION;
+		mRegions[w] = r;
+		n_region_windows[r]++;
+	}
+
+	// Record the next carrier window for each window
+	mNextCarrierWindow.resize(n_windows);
+	int next_carrier_window = n_windows;
+	for (int w = n_windows - 1; w >= 0; w--) {
+		if (mRegions[w] == CARRIER_REGION)
+			next_carrier_window = w;
+		mNextCarrierWindow[w] = next_carrier_window;
+	}
+
+	if (mDebugInfo.verbose && n_windows > 0) {
+		cout << "Carrier map of " << n_windows << " windows of " << mWindowSize << " samples: " <<
+			(int) round(100.0 * n_region_windows[SILENCE_REGION] / n_windows) << "% silence, " <<
+			(int) round(100.0 * n_region_windows[NOISE_REGION] / n_windows) << "% noise and " <<
+			(int) round(100.0 * n_region_windows[CARRIER_REGION] / n_windows) << "% possible carrier\n";
+	}
+}
+
+// Get the region type of the window that sample sampleNo is part of
+CarrierMap::Region CarrierMap::region(int sampleNo)
+{
+	if (sampleNo < 0 || sampleNo >= mNSamples)
+		return SILENCE_REGION;
+
+	return (Region) mRegions[sampleNo / mWindowSize];
+}
+
+//
+// Get the sample to skip to from sample sampleNo to come shortly before the next possible carrier.
+//
+// If there is no possible carrier after sampleNo, it is the end of the samples (less the margin).
+//
+int CarrierMap::skipTo(int sampleNo)
+{
+	if (sampleNo < 0 || sampleNo >= mNSamples)
+		return sampleNo;
+
+	int window = sampleNo / mWindowSize;
+	int target_window = mNextCarrierWindow[window] - mMarginWindows;
+	if (target_window - window < mMinSkipWindows)
+		return sampleNo;
+
+	return min(target_window * mWindowSize, mNSamples);
+}
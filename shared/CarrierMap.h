@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef CARRIER_MAP_H
+#define CARRIER_MAP_H
+
+#include <vector>
+#include <cstdint>
+#include "WaveSampleTypes.h"
+#include "Logging.h"
+
+using namespace std;
+
+//
+// Coarse map of the regions of a tape that could contain a carrier.
+//
+// The samples are divided into short windows and for each window its envelope (peak amplitude) and
+// zero-crossing rate are measured in one pass (with loops that the compiler vectorises). A window is then
+// classified as silence (an envelope far below the typical carrier level), noise (too few zero
+// crossings for a 1200/2400 Hz tone, e.g. hum, speech or music) or a possible carrier. The map is conservative:
+// any window that might contain a tone (including a noisy one) is classified as a possible carrier.
+//
+// A decoder that is waiting for a carrier can then jump straight over silence and noise instead of
+// looking for a lead tone 1/2 cycle by 1/2 cycle.
+//
+class CarrierMap
+{
+
+public:
+
+	enum Region { SILENCE_REGION = 0, NOISE_REGION = 1, CARRIER_REGION = 2 };
+
+private:
+
+	int mWindowSize; // no of samples per window
+	int mNSamples;
+
+	vector<uint8_t> mRegions; // region type (Region) of each window
+	vector<int> mNextCarrierWindow; // first carrier window at or after each window (no of windows if none)
+
+	// Duration of a window [s]
+	const double mWindowDuration = 0.005;
+
+	// Envelope (relative the typical carrier envelope) below which a window is silent
+	const double mSilenceLevel = 1.0 / 16;
+
+	// No of windows before a carrier region to stop at when skipping (so that the start of the carrier isn't missed)
+	const int mMarginWindows = 2;
+
+	// Min no of windows to skip (shorter non-carrier regions aren't worth skipping)
+	const int mMinSkipWindows = 4;
+
+	Logging mDebugInfo;
+
+public:
+
+	CarrierMap(int sampleFreq, Samples& samples, double freqThreshold, Logging logging);
+
+	// Get the region type of the window that sample sampleNo is part of
+	Region region(int sampleNo);
+
+	// Get the sample to skip to from sample sampleNo to come shortly before the next possible carrier
+	// (or sampleNo itself if there is no non-carrier region worth skipping)
+	int skipTo(int sampleNo);
+
+};
+
+#endif
@@ -85,6 +85,7 @@ CycleDecoder::CycleDecoder(int sampleFreq, double freqThreshold, Logging logging
 	mDebugInfo(logging)
 {
 	mCT.set(sampleFreq, F2_FREQ, freqThreshold);
+	mNominalCarrierHalfCycle = mCarrierHalfCycle = sampleFreq / (2.0 * F2_FREQ);
 
 	if (mDebugInfo.verbose) {
 		cout << "\n\nCycle Sample Timing:\n\n";
@@ -165,18 +166,24 @@ void CycleDecoder::updatePhase(Frequency f1, Frequency f2, Level f2Level)
 // 
 // Neither the recorded phase nor the sequences above are currently used to determine the value of a data bit.
 //
-void CycleDecoder::updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLevel)
+void CycleDecoder::updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLevel, double exactDuration)
 {
+	// Re-centre the ranges if the tracked carrier differs from the one they are centred around
+	// (which can be the case after a roll back)
+	if (mTrackCarrier && mHalfCycle.carrierHalfCycle > 0)
+		centreRanges(mHalfCycle.carrierHalfCycle);
+
 	// Save information about previous 1/2 cycle
 	HalfCycleInfo hc_p = mHalfCycle;
 
 	// Record level and duration
 	mHalfCycle.level = halfCycleLevel;
 	mHalfCycle.duration = halfCycleDuration;
+	mHalfCycle.exactDuration = (exactDuration >= 0 ? exactDuration : halfCycleDuration);
 
 	// Classify previous and current 1/2 cycle as either F12 or F1/F2 (F12 having lowest priority)
-	Frequency fr_p = getHalfCycleFrequency(hc_p.duration);
-	Frequency fr = getHalfCycleFrequency(mHalfCycle.duration);
+	Frequency fr_p = getHalfCycleFrequency(hc_p.exactDuration);
+	Frequency fr = getHalfCycleFrequency(mHalfCycle.exactDuration);
 
 	// Determine phaseshift
 	updatePhase(fr_p, fr, halfCycleLevel);
@@ -195,6 +202,8 @@ void CycleDecoder::updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLev
 	else
 		mHalfCycle.freq = Frequency::UndefinedFrequency;
 
+	if (mTrackCarrier)
+		trackCarrier();
 
 	if (true || hc_p.phaseShift != mHalfCycle.phaseShift)
 		DEBUG_PRINT(
@@ -216,12 +225,12 @@ void CycleDecoder::updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLev
 // The valid range for an F2 (short) 1/2 cycle to clearly distinguish it from an F1 1/2 cycle
 // is [min F2 1/2 cycle, F1/F2 1/2 cycle threshold]
 // 
-bool CycleDecoder::validHalfCycleRange(Frequency f, int duration)
+bool CycleDecoder::validHalfCycleRange(Frequency f, double duration)
 {
 	if (f == Frequency::F2)
-		return (duration >= mCT.mMinNSamplesF2HalfCycle && (double)duration <= mCT.mSamplesThresholdHalfCycle);
+		return (duration >= mCT.mMinNSamplesF2HalfCycle && duration <= mCT.mSamplesThresholdHalfCycle);
 	else if (f == Frequency::F1)
-		return ((double) duration > mCT.mSamplesThresholdHalfCycle && duration <= mCT.mMaxNSamplesF1HalfCycle);
+		return (duration > mCT.mSamplesThresholdHalfCycle && duration <= mCT.mMaxNSamplesF1HalfCycle);
 	else if (f == Frequency::F12)
 		return (duration >= mCT.mMinNSamplesF12HalfCycle && duration <= mCT.mMaxNSamplesF12HalfCycle);
 	else
@@ -236,7 +245,7 @@ bool CycleDecoder::validHalfCycleRange(Frequency f, int duration)
 //
 // The valid range for an F2 (short) 1/2 cycle is [min F2 1/2 cycle, max F2 1/2 cycle]
 //
-bool CycleDecoder::strictValidHalfCycleRange(Frequency f, int duration)
+bool CycleDecoder::strictValidHalfCycleRange(Frequency f, double duration)
 {
 	if (f == Frequency::F2)
 		return (duration >= mCT.mMinNSamplesF2HalfCycle && duration <= mCT.mMaxNSamplesF2HalfCycle);
@@ -249,7 +258,7 @@ bool CycleDecoder::strictValidHalfCycleRange(Frequency f, int duration)
 }
 
 // Determine the type of 1/2 cycle (F1, F2, F12 or unknown) - F12 has highest priority
-Frequency CycleDecoder::getHalfCycleFrequencyRange(int duration)
+Frequency CycleDecoder::getHalfCycleFrequencyRange(double duration)
 {
 	if (duration >= mCT.mMinNSamplesF12HalfCycle && duration <= mCT.mMaxNSamplesF12HalfCycle)
 		return Frequency::F12;
@@ -262,7 +271,7 @@ Frequency CycleDecoder::getHalfCycleFrequencyRange(int duration)
 }
 
 // Determine the type of 1/2 cycle (F1, F2, F12 or unknown) - F12 has lowest priority
-Frequency CycleDecoder::getHalfCycleFrequency(int duration)
+Frequency CycleDecoder::getHalfCycleFrequency(double duration)
 {
 	if (duration >= mCT.mMinNSamplesF1HalfCycle && duration <= mCT.mMaxNSamplesF1HalfCycle)
 		return Frequency::F1;
@@ -285,4 +294,213 @@ double CycleDecoder::carrierFreq()
 void CycleDecoder::setCarrierFreq(double carrierFreq)
 {
 	mCT.set(carrierFreq);
-}
\ No newline at end of file
+	mCarrierHalfCycle = mHalfCycle.carrierHalfCycle = mCT.fS / (2 * carrierFreq);
+}
+
+//
+// Update the tracked carrier with the last 1/2 cycle.
+//
+// Each valid F2 1/2 cycle (or valid F1 1/2 cycle, counted as two F2 1/2 cycles) moves the estimated
+// F2 1/2 cycle duration a fraction (the tracking gain) towards its own duration. The estimate is kept within
+// the frequency tolerance of the nominal carrier frequency.
+//
+void CycleDecoder::trackCarrier()
+{
+	if (mHalfCycle.carrierHalfCycle == 0)
+		mHalfCycle.carrierHalfCycle = mCarrierHalfCycle;
+
+	double d;
+	if (mHalfCycle.freq == Frequency::F2 && strictValidHalfCycleRange(Frequency::F2, mHalfCycle.exactDuration))
+		d = mHalfCycle.exactDuration;
+	else if (mHalfCycle.freq == Frequency::F1 && strictValidHalfCycleRange(Frequency::F1, mHalfCycle.exactDuration))
+		d = mHalfCycle.exactDuration / 2;
+	else
+		return;
+
+	double estimate = mHalfCycle.carrierHalfCycle + mTrackingGain * (d - mHalfCycle.carrierHalfCycle);
+	double min_estimate = mNominalCarrierHalfCycle / (1 + mCT.freqThreshold);
+	double max_estimate = mNominalCarrierHalfCycle / (1 - mCT.freqThreshold);
+	mHalfCycle.carrierHalfCycle = min(max(estimate, min_estimate), max_estimate);
+
+	centreRanges(mHalfCycle.carrierHalfCycle);
+}
+
+//
+// Centre the F1/F2 1/2 cycle ranges around an F2 1/2 cycle duration [samples]
+// (only when it differs noticeably from the one they are already centred around)
+//
+void CycleDecoder::centreRanges(double carrierHalfCycle)
+{
+	if (abs(carrierHalfCycle - mCarrierHalfCycle) <= mMinTrackingChange * mCarrierHalfCycle)
+		return;
+
+	mCarrierHalfCycle = carrierHalfCycle;
+	mCT.set(mCT.fS / (2 * carrierHalfCycle));
+}
+
+//
+// Find a window with [minthresholdCycles, maxThresholdCycles] 1/2 cycles and starting with an
+// 1/2 cycle of frequency type f.
+//
+bool CycleDecoder::detectWindow(Frequency f, int nSamples, int minThresholdCycles, int maxThresholdCycles, int & nHalfCycles)
+{
+
+	mHalfCycle.freq = Frequency::UndefinedFrequency;
+
+	nHalfCycles = 0;
+	int n = 0;
+	vector<int> half_cycle_durations;
+
+	for (; n < nSamples && !endOfSamples(); n++) {
+
+		// Get next sample
+		bool transition;
+		if (!getNextSample(transition)) // can fail for too long level duration or end of samples
+			return false;
+
+		// Check for a new 1/2 cycle
+		if (transition) {
+			half_cycle_durations.push_back(mHalfCycle.duration);
+			nHalfCycles++;		
+		}
+
+		// Check for a completed rolling window
+		if (n >= nSamples - 1) {
+			// Rolling window is completely filled
+			if (nHalfCycles <= minThresholdCycles || nHalfCycles >= maxThresholdCycles) {
+				// Rolling window is complete but the 1/2 cycles are not the expected
+				// => trim window from left until the next 1/2 cycle of frequency f is found
+				//    and adjust #samples in window and the 1/2 cycle count accordingly
+				bool stop = false;
+				while (!stop && half_cycle_durations.size() > 0) {
+					int d = half_cycle_durations.front();
+					half_cycle_durations.erase(half_cycle_durations.begin());
+					nHalfCycles--;
+					if (n > d) n -= d; else n = 0;
+					if (half_cycle_durations.size() > 0) {
+						d = half_cycle_durations.front();
+						if (strictValidHalfCycleRange(f, d))
+							stop = true;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+// Advance n samples and record the encountered no of 1/2 cycles
+int CycleDecoder::countHalfCycles(
+	int nSamples, int& nHalfCycles, int& minHalfCycleDuration, int& maxHalfCycleDuration,
+	Frequency& dominatingFreq
+)
+{
+
+	nHalfCycles = 0;
+	maxHalfCycleDuration = -1;
+	minHalfCycleDuration = 99999;
+	dominatingFreq = Frequency::UndefinedFrequency;
+	int f1_cnt = 0;
+	int f2_cnt = 0;
+	bool first_half_cycle = true;
+	const int min_first_half_cycle_samples = this->mCT.mMinNSamplesF2HalfCycle / 2;
+
+	for (int n = 0; n < nSamples && !endOfSamples(); n++) {
+
+		bool transition;
+		if (!getNextSample(transition)) // can fail for too long level duration or end of samples
+			return false;
+
+		// Check for a new 1/2 cycle
+		if (transition) {
+
+			// Only evaluate 1/2 cycles that stretches at least min_first_half_cycle_samples into the sample window
+			if (!first_half_cycle || (first_half_cycle && n > min_first_half_cycle_samples)) {
+
+				// Check for min & max
+				if (mHalfCycle.duration > maxHalfCycleDuration)
+					maxHalfCycleDuration = mHalfCycle.duration;
+				if (mHalfCycle.duration < minHalfCycleDuration)
+					minHalfCycleDuration = mHalfCycle.duration;
+
+				// Check for dominating frequency
+				if (lastHalfCycleFrequency() == Frequency::F1)
+					f1_cnt++;
+				else if (lastHalfCycleFrequency() == Frequency::F2)
+					f2_cnt++;
+				if (f1_cnt > f2_cnt)
+					dominatingFreq = Frequency::F1;
+				else if (f2_cnt > f1_cnt)
+					dominatingFreq = Frequency::F2;
+				else
+					dominatingFreq = Frequency::UndefinedFrequency;
+			}
+
+			first_half_cycle = false;
+
+			// Count no of transitions
+			nHalfCycles++;
+
+		}
+	}
+
+	return true;
+}
+
+// Consume as many 1/2 cycles of frequency f as possible
+int CycleDecoder::consumeHalfCycles(Frequency f, int &nHalfCycles)
+{
+
+	nHalfCycles = 0;
+	bool stop = false;
+
+	for (;!stop;) {
+
+		if (!advanceHalfCycle())
+			return false;
+
+		// Is it of the expected duration?
+		if (strictValidHalfCycleRange(f, mHalfCycle.exactDuration)) {
+			nHalfCycles++;
+		}
+		else {
+			stop = true;
+		}
+		
+	}
+
+
+	return true;
+}
+
+// Stop at first occurrence of n 1/2 cycles of frequency f
+int CycleDecoder::stopOnHalfCycles(Frequency f, int nHalfCycles, double &waitingTime)
+{
+
+	double t_start = getTime();
+	double t_end;
+	int n = 0;
+
+	for (; n < nHalfCycles;) {
+
+		t_end = getTime();	
+
+		if (!advanceHalfCycle())
+			return false;
+
+		// Is it of the expected frequency?
+		if (mHalfCycle.freq == f) {
+			n++;
+			if (n == 1) { 
+				waitingTime = t_end - t_start;
+			}
+
+		}
+		else
+			n = 0;
+	}
+
+	return true;
+}
@@ -53,6 +53,9 @@ public:
 	int duration; // duration of 1/2 cycle
 	int phaseShift; // phaseshift [degrees] when starting an F1/F2 1/2 cycle
 	int nSamples = 0; // No of samples since last transition (only used by WavTapeReader)
+	double exactDuration = 0; // duration of 1/2 cycle [samples] between the (interpolated) transitions
+	double transitionPos = 0; // (interpolated) sample position of the last transition (only used by WavCycleDecoder)
+	double carrierHalfCycle = 0; // tracked duration [samples] of an F2 1/2 cycle (0 <=> not yet tracked)
 	string info(); // string representation of the 1/2 cycle info
 };
 
@@ -71,6 +74,17 @@ protected:
 	HalfCycleInfo mHalfCycle = { Frequency::NoCarrierFrequency, Level::NoCarrierLevel, 0, 0 };
 	vector<HalfCycleInfo> mHalfCycleCheckpoints;
 
+	//
+	// Carrier tracking - the duration of an F2 1/2 cycle is continuously estimated from the detected
+	// F1 & F2 1/2 cycles (a first-order tracking loop) and the F1/F2 1/2 cycle ranges are re-centred around it.
+	// This follows speed variations (wow & flutter) of a tape without having to increase the frequency tolerance.
+	//
+	bool mTrackCarrier = true;
+	const double mTrackingGain = 1.0 / 64; // weight of a new 1/2 cycle in the estimate
+	const double mMinTrackingChange = 0.002; // min relative change of the estimate for the ranges to be re-centred
+	double mNominalCarrierHalfCycle; // duration [samples] of an F2 1/2 cycle for the nominal carrier frequency
+	double mCarrierHalfCycle; // duration [samples] of an F2 1/2 cycle that the ranges are centred around
+
 	// For UEF format
 	// 0 <=> cycle starts with a LOW level
 	// 180 <=> cycle starts with a HIGH level
@@ -93,21 +107,27 @@ public:
 	// Get the current phaseshift (in degrees)
 	int getPhaseShift() { return mHalfCycle.phaseShift;  }
 
+	//
+	// The 1/2 cycle functions below are implemented for a cycle decoder that processes the signal sample
+	// by sample (with getNextSample and endOfSamples). A cycle decoder working on something else than
+	// samples (e.g., CSW pulses) overrides them instead.
+	//
+
 	// Advance n samples and record the encountered no of 1/2 cycles
 	virtual int countHalfCycles(
 		int nSamples, int& nHalfCycles, int& minHalfCycleDuration, int& maxHalfCycleDuration,
 		Frequency& dominatingFreq
-	) = 0;
+	);
 
 	// Find a window with [minthresholdCycles, maxThresholdCycles] 1/2 cycles and starting with an
 	// 1/2 cycle of frequency type f.
-	virtual bool detectWindow(Frequency f, int nSamples, int minThresholdCycles, int maxThresholdCycles, int& nHalfCycles) = 0;
+	virtual bool detectWindow(Frequency f, int nSamples, int minThresholdCycles, int maxThresholdCycles, int& nHalfCycles);
 
 	// Consume as many 1/2 cycles of frequency f as possible
-	virtual int  consumeHalfCycles(Frequency f, int &nHalfCycles) = 0;
+	virtual int  consumeHalfCycles(Frequency f, int &nHalfCycles);
 
 	// Stop at first occurrence of n 1/2 cycles of frequency f
-	virtual int stopOnHalfCycles(Frequency f, int nHalfCycles, double &waitingTime) = 0;
+	virtual int stopOnHalfCycles(Frequency f, int nHalfCycles, double &waitingTime);
 
 	// Get duration (in samples) of one F2 cycle
 	double getF2Samples() { return (double) mCT.fS / carrierFreq();  }
@@ -118,6 +138,9 @@ public:
 	// Get the next 1/2 cycle (F1, F2 or unknown)
 	virtual bool advanceHalfCycle() = 0;
 
+	// Skip silence and noise up to shortly before the next possible carrier (returns false if nothing was skipped)
+	virtual bool skipToCarrier() { return false; }
+
 	// Get tape time
 	virtual double getTime() = 0;
 
@@ -139,27 +162,40 @@ public:
 	// Check for valid range for either an F1 or an F2 1/2 cycle
 	// The valid range for an 1/2 cycle extends to the threshold
 	// between an F1 & F2 1/2 cycle.
-	bool validHalfCycleRange(Frequency f, int duration);
+	bool validHalfCycleRange(Frequency f, double duration);
 
 	// Check for valid range for either an F1 or an F2 1/2 cycle
 	// Only the specified tolerance will be used to validate a 1/2 cycle
 	// duration.
-	bool strictValidHalfCycleRange(Frequency f, int duration);
+	bool strictValidHalfCycleRange(Frequency f, double duration);
 
 	// Determine the type of 1/2 cycle (F1, F2, F12 or unknown) - F12 has highest priority
-	Frequency getHalfCycleFrequencyRange(int duration);
+	Frequency getHalfCycleFrequencyRange(double duration);
 
 	// Determine the type of 1/2 cycle (F1, F2, or unknown) - F12 has lowest priority
-	Frequency getHalfCycleFrequency(int duration);
+	Frequency getHalfCycleFrequency(double duration);
 
 protected:
 
+	// Get next sample and update 1/2 cycle info for a transition (only needed for the sample-based 1/2 cycle functions)
+	virtual bool getNextSample(bool& transition) { transition = false; return false; }
+
+	// End of samples reached? (only needed for the sample-based 1/2 cycle functions)
+	virtual bool endOfSamples() { return true; }
+
 	// Record the frequency of the last 1/2 cycle (but only if a 1/2 cycle was detected)
-	void updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLevel);
+	// The 1/2 cycle is classified from its exact (fractional) duration if it is known (>= 0)
+	void updateHalfCycleFreq(int halfCycleDuration, Level halfCycleLevel, double exactDuration = -1);
 
 	// Get phase shift when a frequency shift occurs
 	void updatePhase(Frequency f1, Frequency f2, Level level);
 
+	// Update the tracked carrier with the last 1/2 cycle
+	void trackCarrier();
+
+	// Centre the F1/F2 1/2 cycle ranges around an F2 1/2 cycle duration [samples] (if it has changed noticeably)
+	void centreRanges(double carrierHalfCycle);
+
 };
 
 #endif
\ No newline at end of file
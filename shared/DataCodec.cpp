@@ -4,6 +4,8 @@
 #include <iostream>
 #include <sstream>
 #include <cstdint>
+#include <climits>
+#include <cstring>
 #include "TAPCodec.h"
 #include "UEFCodec.h"
 #include "Utility.h"
@@ -21,43 +23,114 @@ DataCodec::DataCodec(Logging logging): mDebugInfo(logging)
 
 }
 
+// Value of a hex digit (-1 if not a hex digit)
+static int hexDigitValue(char c)
+{
+    static const signed char* values = [] {
+        static signed char table[256];
+        for (int i = 0; i < 256; i++)
+            table[i] = -1;
+        for (int i = 0; i < 10; i++)
+            table['0' + i] = i;
+        for (int i = 0; i < 6; i++) {
+            table['a' + i] = 10 + i;
+            table['A' + i] = 10 + i;
+        }
+        return table;
+    }();
+
+    return values[(Byte) c];
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Parse a hex number starting at pos (after any white space and with an optional sign and '0x' prefix) - false if there is none
+static bool parseHex(const char* text, size_t len, size_t& pos, uint64_t maxValue, int64_t& value)
+{
+    while (pos < len && isSpace(text[pos]))
+        pos++;
+
+    bool negative = false;
+    if (pos < len && (text[pos] == '+' || text[pos] == '-')) {
+        negative = (text[pos] == '-');
+        pos++;
+    }
+    if (pos + 2 < len && text[pos] == '0' && (text[pos + 1] == 'x' || text[pos + 1] == 'X') && hexDigitValue(text[pos + 2]) >= 0)
+        pos += 2;
+
+    size_t digits_start = pos;
+    uint64_t v = 0;
+    int d;
+    while (pos < len && (d = hexDigitValue(text[pos])) >= 0) {
+        if (v <= maxValue)
+            v = v * 16 + d;
+        pos++;
+    }
+    if (pos == digits_start || v > maxValue + (negative ? 1 : 0))
+        return false;
+
+    value = (negative ? -(int64_t) v : (int64_t) v);
+    return true;
+}
+
+//
+// Decode the lines '<address> <byte values> <ASCII>' of a DATA file.
+//
+// The whole file is read into memory and then parsed in one pass. The byte values of a line are the
+// hex numbers that follow the address up to the first double space (that separates them from the ASCII part).
+// Lines without a (hex) address are skipped.
+//
 bool DataCodec::data2Bytes(string& dataFileName, int& startAdress, Bytes& data)
 {
-    ifstream fin(dataFileName);
+    ifstream fin(dataFileName, ios::in | ios::binary | ios::ate);
 
     if (!fin) {
         cout << "Failed to open file '" << dataFileName << "'\n";
         return false;
     }
-    filesystem::path fin_p = dataFileName;
-
-    string line;
-    uint32_t address;
 
+    // Read the whole file
+    size_t file_size = (size_t) fin.tellg();
+    string text(file_size, '\0');
     fin.seekg(0);
-    string values;
-
-    // Store data as a byte vector
-    bool first_line = true;
-    while (getline(fin, line)) {
-
-        istringstream sin(line);
-        sin >> hex >> address;
+    if (file_size > 0 && !fin.read(&text[0], file_size)) {
+        cout << "Failed to read file '" << dataFileName << "'\n";
+        return false;
+    }
+    fin.close();
 
-        getline(sin, values);
+    // There are (at most) 16 values per 16 + 3 * 16 + 7 chars long line
+    data.reserve(data.size() + file_size / 4);
 
+    const char* t = text.data();
+    bool first_line = true;
+    size_t line_start = 0;
+    while (line_start < file_size) {
+
+        const char* line_end_p = (const char*) memchr(t + line_start, '\n', file_size - line_start);
+        size_t line_end = (line_end_p != NULL ? line_end_p - t : file_size);
+        size_t pos = line_start;
+        line_start = line_end + 1;
+
+        // Get address
+        int64_t address;
+        if (!parseHex(t, line_end, pos, UINT32_MAX, address))
+            continue;
         if (first_line) {
-            startAdress = address;
+            startAdress = (int) address;
             first_line = false;
         }
+
         // Determine the #values on the row (16 on all but the last one possibly)
-        istringstream v_stream(values);
-        char c;
         int n_space = 0;
         char pc = ' ';
         int n_values = 0;
-        while ((v_stream >> std::noskipws >> c) && n_space < 2) {
-            if ((char)c == (char)' ')
+        for (size_t p = pos; p < line_end && n_space < 2; p++) {
+            char c = t[p];
+            if (c == ' ')
                 n_space++;
             if (c != ' ' && pc == ' ') {
                 n_values++;
@@ -65,14 +138,13 @@ bool DataCodec::data2Bytes(string& dataFileName, int& startAdress, Bytes& data)
             }
             pc = c;
         }
-        int val;
-        v_stream = istringstream(values);
-        int n = 0;
-        while (v_stream >> hex >> val && n++ < n_values)
-            data.push_back(val);
+
+        // Get the values
+        int64_t val;
+        for (int n = 0; n < n_values && parseHex(t, line_end, pos, INT_MAX, val); n++)
+            data.push_back((Byte) val);
 
     }
-    fin.close();
 
     return true;
 }
@@ -96,6 +168,22 @@ bool DataCodec::encode(TapeFile& tapeFile, string& filePath)
         return encodeBBM(tapeFile, filePath, fout);
 }
 
+/*
+ * Write the data of a block as DATA file lines (16 values per line) starting from an address
+ */
+static void encodeBlockData(string& text, uint32_t address, Bytes& data)
+{
+    char line[Utility::hexDumpLineMaxLen + 1];
+
+    for (size_t i = 0; i < data.size(); i += 16) {
+        int line_sz = (int) min(data.size() - i, (size_t) 16);
+        int line_len = Utility::hexDumpLine(line, address, &data[i], line_sz);
+        line[line_len++] = '\n';
+        text.append(line, line_len);
+        address += 16;
+    }
+}
+
 /*
  * Encode BBC Micro TAP File structure as DATA file
  */
@@ -105,17 +193,13 @@ bool DataCodec::encodeBBM(TapeFile& tapeFile, string& filePath, ofstream& fout)
     if (mDebugInfo.verbose)
         cout << "\nEncoding BBC Micro program '" << tapeFile.header.name << "' as a DATA file...\n\n";
 
-    FileBlockIter file_block_iter = tapeFile.blocks.begin();
-
-    int c = 0;
-    bool new_line = true;
+    // Format all lines before writing them in one go
+    string text;
     int tape_file_sz = 0;
-    while (file_block_iter < tapeFile.blocks.end()) {
+    for (FileBlockIter file_block_iter = tapeFile.blocks.begin(); file_block_iter < tapeFile.blocks.end(); file_block_iter++) {
 
-        BytesIter bi = file_block_iter->data.begin();
         uint32_t file_load_adr = file_block_iter->loadAdr;
         int block_sz = file_block_iter->size;
-        char s[64];
 
         int load_adr = file_load_adr + tape_file_sz; 
 
@@ -124,49 +208,11 @@ bool DataCodec::encodeBBM(TapeFile& tapeFile, string& filePath, ofstream& fout)
         }
 
         tape_file_sz += block_sz;
-        
-        BytesIter li;
-        int line_sz = 16;
-        while (bi < file_block_iter->data.end()) {
-
-            if (new_line) {
-                if (file_block_iter->data.end() - bi < 16)
-                    line_sz = (int) (file_block_iter->data.end() - bi);
-                li = bi;
-                sprintf(s, "%.4x ", load_adr);
-                fout << s;
-                c = 0;
-                new_line = false;
-            }
-
-            sprintf(s, "%.2x ", int(*bi++));
-            fout << s;
-
-            if (c == line_sz - 1) {
-                new_line = true;
-
-                load_adr += 16;
-                c = 0;
-                fout << " ";
-                for (int j = 0; j < 16 - line_sz; j++)
-                    fout << "   ";
-                for (int i = 0; i < line_sz; i++) {
-                    Byte b = *li++;
-                    if (b >= 0x20 && b <= 0x7e)
-                        fout << (char)b;
-                    else
-                        fout << ".";
-                }
-                fout << "\n";
-            }
 
-            c++;
-
-
-        }
-        file_block_iter++;
+        encodeBlockData(text, load_adr, file_block_iter->data);
     }
 
+    fout.write(text.data(), text.size());
     fout.close();
 
     if (mDebugInfo.verbose) {
@@ -188,70 +234,17 @@ bool DataCodec::encodeAtom(TapeFile &tapeFile, string& filePath, ofstream &fout)
     if (mDebugInfo.verbose)
         cout << "\nEncoding Acorn Atom program '" << tapeFile.header.name << "' as a DATA file...\n\n";
 
-    FileBlockIter file_block_iter = tapeFile.blocks.begin();
-
-    int c = 0;
-    bool new_line = true;
-    int block_no = 0;
-    int tape_file_sz = 0;
-    while (file_block_iter < tapeFile.blocks.end()) {
-
-        BytesIter bi = file_block_iter->data.begin();
-        int exec_adr = file_block_iter->execAdr;
-        int load_adr = file_block_iter->loadAdr;
-        int data_len = file_block_iter->size;
-        string name = file_block_iter->name;
-        char s[64];
+    // Format all lines before writing them in one go
+    string text;
+    for (FileBlockIter file_block_iter = tapeFile.blocks.begin(); file_block_iter < tapeFile.blocks.end(); file_block_iter++) {
 
         if (mDebugInfo.verbose)
             file_block_iter->logFileBlockHdr();
-        
-        block_no++;
-        tape_file_sz += data_len;
-
-
-        BytesIter li;
-        int line_sz = 16;
-        while (bi < file_block_iter->data.end()) {
-
-            if (new_line) {
-                if (file_block_iter->data.end() - bi < 16)
-                    line_sz = (int) (file_block_iter->data.end() - bi);
-                li = bi;
-                sprintf(s, "%.4x ", load_adr);
-                fout << s;
-                c = 0;
-                new_line = false;
-            }
-
-            sprintf(s, "%.2x ", int(*bi++));
-            fout << s;
-
-            if (c == line_sz - 1) {
-                new_line = true;
-
-                load_adr += 16;
-                c = 0;
-                fout << " ";
-                for (int j = 0; j < 16 - line_sz; j++)
-                    fout << "   ";
-                for (int i = 0; i < line_sz; i++) {
-                    Byte b = *li++;
-                    if (b >= 0x20 && b <= 0x7e)
-                        fout << (char)b;
-                    else
-                        fout << ".";
-                }
-                fout << "\n";
-            }
 
-            c++;
-
-
-        }
-        file_block_iter++;
+        encodeBlockData(text, file_block_iter->loadAdr, file_block_iter->data);
     }
 
+    fout.write(text.data(), text.size());
     fout.close();
 
     if (mDebugInfo.verbose) {
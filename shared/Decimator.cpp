@@ -0,0 +1,107 @@
+#include "Decimator.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+Decimator::Decimator(int sampleFreq, int targetFreq, Logging logging) :
+	mInputFreq(sampleFreq), mOutputFreq(sampleFreq), mDebugInfo(logging)
+{
+	// Select the largest factor that keeps the rate at or above the target rate and gives an integer rate
+	if (targetFreq > 0) {
+		for (int m = sampleFreq / targetFreq; m > 1 && mFactor == 1; m--) {
+			if (sampleFreq % m == 0)
+				mFactor = m;
+		}
+	}
+	mOutputFreq = sampleFreq / mFactor;
+
+	if (mFactor > 1)
+		createFilter();
+
+	if (mDebugInfo.verbose) {
+		cout << "Decimation of " << sampleFreq << " Hz samples to " << mOutputFreq << " Hz (factor " << mFactor <<
+			", " << mTaps.size() << " taps)\n";
+	}
+}
+
+//
+// Create a Blackman windowed-sinc low-pass filter with mPhaseTaps taps per phase (normalised to unity DC gain)
+//
+void Decimator::createFilter()
+{
+	const double PI = 3.14159265358979323846;
+	int n_taps = mPhaseTaps * mFactor;
+	double fc = mCutOff / mFactor; // relative the input rate
+	double centre = n_taps / 2;
+	mTaps.resize(n_taps);
+	double sum = 0;
+	for (int k = 0; k < n_taps; k++) {
+		double x = k - centre;
+		double sinc = (x == 0 ? 2 * fc : sin(2 * PI * fc * x) / (PI * x));
+		double w = 0.42 + 0.5 * cos(PI * x / (centre + 1)) + 0.08 * cos(2 * PI * x / (centre + 1));
+		mTaps[k] = (float) (sinc * w);
+		sum += mTaps[k];
+	}
+	for (int k = 0; k < n_taps; k++)
+		mTaps[k] = (float) (mTaps[k] / sum);
+}
+
+//
+// Decimate the samples.
+//
+// Decimated sample n is y[n] = sum h[k] * x[n * M + c - k] where c = (mPhaseTaps / 2) * M centres the filter
+// around input sample n * M. With k = j * M + p and the phase streams s_r[m] = x[m * M + r], the term for
+// tap j of phase p is h[j * M + p] * s_r[n - j + mPhaseTaps / 2 - (p > 0 ? 1 : 0)] with r = (M - p) mod M.
+// Each (j, p) term is therefore added to a whole block of decimated samples from consecutive samples
+// of one phase stream.
+//
+void Decimator::decimate(Samples& samples, Samples& decimatedSamples)
+{
+	if (mFactor == 1) {
+		decimatedSamples = samples;
+		return;
+	}
+
+	const int M = mFactor;
+	const int L = mPhaseTaps;
+	const int n_samples = (int) samples.size();
+	const int n_out = n_samples / M;
+	decimatedSamples.resize(n_out);
+
+	// Phase streams for one block of decimated samples (including the samples needed before and after it)
+	const int stream_len = mBlockSize + L + 1;
+	vector<vector<float>> streams(M, vector<float>(stream_len));
+	vector<float> acc(mBlockSize);
+
+	for (int block_start = 0; block_start < n_out; block_start += mBlockSize) {
+		const int block_len = (n_out - block_start < mBlockSize ? n_out - block_start : mBlockSize);
+
+		// Fill the phase streams (zeros outside the samples)
+		const int m_lo = block_start - L / 2 - 1;
+		for (int r = 0; r < M; r++) {
+			float* stream = streams[r].data();
+			for (int i = 0; i < stream_len; i++) {
+				long pos = (long) (m_lo + i) * M + r;
+				stream[i] = (pos >= 0 && pos < n_samples ? samples[pos] : 0.0f);
+			}
+		}
+
+		// Accumulate the contribution of each tap
+		fill(acc.begin(), acc.begin() + block_len, 0.0f);
+		float* out = acc.data();
+		for (int p = 0; p < M; p++) {
+			const float* stream = streams[(M - p) % M].data();
+			for (int j = 0; j < L; j++) {
+				const float h = mTaps[j * M + p];
+				const float* src = stream + (block_start - j + L / 2 - (p > 0 ? 1 : 0) - m_lo);
+				for (int i = 0; i < block_len; i++)
+					out[i] += h * src[i];
+			}
+		}
+
+		for (int i = 0; i < block_len; i++) {
+			float y = roundf(out[i]);
+			decimatedSamples[block_start + i] = (Sample) (y > SAMPLE_HIGH_MAX ? SAMPLE_HIGH_MAX : (y < SAMPLE_LOW_MIN ? SAMPLE_LOW_MIN : y));
+		}
+	}
+}
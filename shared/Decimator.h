@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <vector>
+#include "WaveSampleTypes.h"
+#include "Logging.h"
+
+using namespace std;
+
+//
+// Decimates samples of a high sample rate (e.g. 96 or 192 kHz) to a lower rate before they are decoded.
+//
+// The rate is reduced by an integer factor M (the largest factor that gives a rate of at least the target
+// rate and that divides the sample rate). Before every M:th sample is kept, the samples are low-pass filtered
+// (anti-aliasing) by a windowed-sinc FIR filter in polyphase form: the samples are split into M phases and each
+// phase is filtered by its own part of the filter, which only computes the kept samples and makes the inner loop
+// a multiply-add over consecutive samples that the compiler vectorises.
+//
+// The 1200/2400 Hz tones are far below the cut-off frequency so the decoding isn't affected, only sped up.
+//
+class Decimator
+{
+
+private:
+
+	int mFactor = 1; // decimation factor M
+	int mInputFreq;
+	int mOutputFreq;
+
+	// Taps per phase (even, as the filter is centred around the kept sample)
+	static constexpr int mPhaseTaps = 16;
+
+	// Cut-off frequency of the anti-aliasing filter (relative the output rate)
+	const double mCutOff = 0.4;
+
+	// No of output samples computed at once
+	static constexpr int mBlockSize = 4096;
+
+	// Filter taps h[k] (k = j * M + p for tap j of phase p)
+	vector<float> mTaps;
+
+	Logging mDebugInfo;
+
+	void createFilter();
+
+public:
+
+	Decimator(int sampleFreq, int targetFreq, Logging logging);
+
+	// Output sample rate (the same as the input sample rate if there is no decimation)
+	int outputFreq() { return mOutputFreq; }
+
+	// Decimation factor (1 <=> no decimation)
+	int factor() { return mFactor; }
+
+	// Decimate the samples
+	void decimate(Samples& samples, Samples& decimatedSamples);
+
+};
+
+#endif
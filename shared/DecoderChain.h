@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef DECODER_CHAIN_H
+#define DECODER_CHAIN_H
+
+#include "WavCycleDecoder.h"
+#include "CSWCycleDecoder.h"
+#include "GoertzelCycleDecoder.h"
+#include "WavTapeReader.h"
+#include "UEFTapeReader.h"
+#include "BlockDecoder.h"
+#include "FileDecoder.h"
+
+//
+// Decoder chains composed at compile time.
+//
+// The polymorphic chain (FileDecoder => BlockDecoder => TapeReader => CycleDecoder) makes
+// virtual calls per byte and per 1/2 cycle. The chains below are instead composed of the concrete
+// decoder types so that all these calls are resolved at compile time (and can be inlined
+// as the library is built with link-time optimisation when the compiler supports it).
+//
+
+// WAV samples => LevelDecoder => WavCycleDecoder => ...
+typedef WavTapeReaderT<WavCycleDecoder> WavSampleTapeReader;
+typedef BlockDecoderT<WavSampleTapeReader> WavSampleBlockDecoder;
+typedef FileDecoderT<WavSampleBlockDecoder> WavSampleFileDecoder;
+
+// WAV samples => GoertzelCycleDecoder => ...
+typedef WavTapeReaderT<GoertzelCycleDecoder> FSKSampleTapeReader;
+typedef BlockDecoderT<FSKSampleTapeReader> FSKSampleBlockDecoder;
+typedef FileDecoderT<FSKSampleBlockDecoder> FSKSampleFileDecoder;
+
+// CSW pulses => CSWCycleDecoder => ...
+typedef WavTapeReaderT<CSWCycleDecoder> CSWPulseTapeReader;
+typedef BlockDecoderT<CSWPulseTapeReader> CSWPulseBlockDecoder;
+typedef FileDecoderT<CSWPulseBlockDecoder> CSWPulseFileDecoder;
+
+// UEF chunks => UEFTapeReader => ...
+typedef BlockDecoderT<UEFTapeReader> UEFBlockDecoder;
+typedef FileDecoderT<UEFBlockDecoder> UEFFileDecoder;
+
+#endif
@@ -4,59 +4,107 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <set>
 #include <filesystem>
 #include <cstdint>
 #include "Utility.h"
 #include <cmath>
 
-DiscCodec::DiscCodec(Logging logging) : mVerbose(logging.verbose)
+//
+// Disc image view
+//
+
+bool DiscImage::open(string discPath, bool interleaved)
 {
+    if (!mFile.open(discPath))
+        return false;
+
+    assign(mFile.data(), mFile.size(), interleaved);
+
+    return true;
 }
 
-bool DiscCodec::openDiscFile(string discPath, Disc &disc)
+void DiscImage::assign(const Byte* image, size_t imageSize, bool interleaved)
 {
-    mDisc_p = &disc;
-    mFin_p = new ifstream(discPath, ios::in | ios::binary | ios::ate);
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
 
-    if (!*mFin_p) {
-        cout << "couldn't open file " << discPath << "\n";
-        return false;
-    }
+    mImage = image;
+    mInterleaved = interleaved;
+    mImageSize = min(imageSize, (size_t) MAX_NO_OF_TRACKS_PER_SIDE * nSides() * track_size);
+}
 
-    return true;
+int DiscImage::nTracks()
+{
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
+
+    return (int) ((mImageSize + track_size - 1) / track_size);
 }
 
-bool DiscCodec::closeDiscFile()
+size_t DiscImage::imagePos(int side, size_t pos)
 {
-    if (mFin_p != NULL) {
-        mFin_p->close();
-        delete mFin_p;
-    }
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
 
-    return true;
+    if (!mInterleaved)
+        return pos;
+
+    return (pos / track_size * 2 + side) * track_size + pos % track_size;
 }
 
-bool DiscCodec::read(string discPath, Disc& disc)
+size_t DiscImage::sideSize(int side)
 {
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
 
-    if (!openDiscFile(discPath, disc)) {
-        cout << "couldn't open file " << discPath << "\n";
-        return false;
+    if (!mInterleaved)
+        return mImageSize;
+
+    // Complete tracks alternate between the sides and an incomplete last track belongs to the side it would have been on
+    size_t n_complete_tracks = mImageSize / track_size;
+    size_t n_side_tracks = (n_complete_tracks + 1 - side) / 2;
+    size_t last_track_size = (n_complete_tracks % 2 == side ? mImageSize % track_size : 0);
+
+    return n_side_tracks * track_size + last_track_size;
+}
+
+bool DiscImage::contiguous(int side, size_t pos, size_t n)
+{
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
+
+    return !mInterleaved || n == 0 || pos / track_size == (pos + n - 1) / track_size;
+}
+
+void DiscImage::copy(int side, size_t pos, size_t n, Byte* dst)
+{
+    const size_t track_size = NO_OF_SECTORS_PER_TRACK * SECTOR_SIZE;
+
+    // Copy track by track (as the tracks of a side are not contiguous in a DSD image)
+    while (n > 0) {
+        size_t n_track_bytes = min(n, track_size - pos % track_size);
+        std::copy(bytes(side, pos), bytes(side, pos) + n_track_bytes, dst);
+        pos += n_track_bytes;
+        dst += n_track_bytes;
+        n -= n_track_bytes;
     }
+}
+
+DiscCodec::DiscCodec(Logging logging) : mVerbose(logging.verbose)
+{
+}
 
+bool DiscCodec::read(string discPath, Disc& disc)
+{
     if (mVerbose)
         cout << dec;
 
     // Check the format
-    int n_sides;
+    bool interleaved;
     string file_ext = Utility::getFileExt(discPath);
     if (file_ext == ".ssd") {
-        n_sides = 1;
+        interleaved = false;
         if (mVerbose)
             cout << "Single-sided format SSD detected\n";
     }
     else if (file_ext == ".dsd") {
-        n_sides = 2;
+        interleaved = true;
         if (mVerbose)
             cout << "Single-sided interleaved format DSD detected\n";
     }
@@ -65,94 +113,84 @@ bool DiscCodec::read(string discPath, Disc& disc)
         return false;
     }
 
-    // Get file size
-    mFin_p->seekg(0, ios::end);
-    streamsize file_sz = mFin_p->tellg();
-    mFin_p->seekg(0);
-
-    // Constants for single density, 80 tracks, 10 sectors per track, 256 bytes per sector
-    const int block_size = 8;
-    const int sector_size = 256;
-    const int no_of_tracks = 80; // could sometimes be 40 but assumed 80 to start with
-    const int sectors_per_track = 10;
-    const int track_size = sectors_per_track * sector_size;
-
-    // Read disc image into one or two byte vectors (one per disc side)
-    // The disc image should really be complete but as sometimes
+    // Map the disc image - the disc image should really be complete but as sometimes
     // it is not (sectors without data are not written to the disc image)
     // we need to tolerate this and stop even if the expected no of tracks
-    // have not been read. Will also allow #tracks to be different
+    // are not in the image. Will also allow #tracks to be different
     // (like 40 instead of 80).
-    Bytes side_image_bytes[2];
-    Byte track_bytes[track_size];
-    bool eof = false;
-    int track = 0;
-    if (n_sides == 2) {
-        for (track = 0; !eof && track < no_of_tracks*2; track++) {
-            if (!mFin_p->read((char*) &track_bytes[0], track_size)) {              
-                eof = true;
-                streamsize n_read_bytes = mFin_p->gcount();
-                if (track % 2 == 0)
-                    side_image_bytes[0].insert(side_image_bytes[0].end(), track_bytes, track_bytes + n_read_bytes);
-                else
-                    side_image_bytes[1].insert(side_image_bytes[1].end(), track_bytes, track_bytes + n_read_bytes);
-            }
-            else {
-                if (track % 2 == 0)
-                    side_image_bytes[0].insert(side_image_bytes[0].end(), track_bytes, track_bytes + track_size);
-                else
-                    side_image_bytes[1].insert(side_image_bytes[1].end(), track_bytes, track_bytes + track_size);
-            }
-        }
-    } else {
-        for (track = 0; !eof && track < no_of_tracks; track++) {
-            if (!mFin_p->read((char*)&track_bytes[0], track_size)) {
-                eof = true;
-                streamsize n_read_bytes = mFin_p->gcount();
-                side_image_bytes[0].insert(side_image_bytes[0].end(), track_bytes, track_bytes + n_read_bytes);
-            }
-            else {
-                side_image_bytes[0].insert(side_image_bytes[0].end(), track_bytes, track_bytes + track_size);
-            }
-        }
+    disc.image = make_shared<DiscImage>();
+    if (!disc.image->open(discPath, interleaved)) {
+        cout << "couldn't open file " << discPath << "\n";
+        return false;
     }
-    if (!closeDiscFile())
-            return false;
 
     if (mVerbose)
-        cout << dec << track << " tracks read\n";
+        cout << dec << disc.image->nTracks() << " tracks read\n";
+
+    return readSides(disc);
+}
+
+//
+// Read a disc image already in memory (e.g., a disc slot of an MMB file)
+//
+// The image is single-sided (SSD) or double-sided with interleaved tracks (DSD).
+//
+bool DiscCodec::read(const Byte* image, size_t imageSize, bool interleaved, Disc& disc)
+{
+    disc.image = make_shared<DiscImage>();
+    disc.image->assign(image, imageSize, interleaved);
+
+    if (mVerbose)
+        cout << dec << disc.image->nTracks() << " tracks read\n";
+
+    return readSides(disc);
+}
+
+//
+// Read the catalogue and files of the disc image's side(s)
+//
+// The files' data are not copied but refer directly to the disc image unless they are
+// split between tracks that are not contiguous in the image (for a DSD image).
+//
+// As for Utility::readBytes, n bytes at a position are only considered available if there
+// are more than n bytes left of the side.
+//
+bool DiscCodec::readSides(Disc& disc)
+{
+    const int block_size = 8;
+    const int sector_size = 256;
+    DiscImage& image = *disc.image;
 
     // Read one to two sides of the disc
-    for (int side_no = 0; side_no < n_sides; side_no++) {
+    for (int side_no = 0; side_no < image.nSides(); side_no++) {
 
         DiscSide ds;
         disc.side.push_back(ds);
         DiscSide &discSide = disc.side[side_no];
 
-        Bytes &image_bytes = side_image_bytes[side_no];
-        BytesIter image_bytes_iter = image_bytes.begin();
+        size_t side_size = image.sideSize(side_no);
+        auto available = [side_size](size_t pos, size_t n) { return pos + n < side_size; };
 
         // Read first 8 chars of volume title from sector 0 bytes 0 to 7
         // Space or null-padded ASCII chars
         Byte title[12];
-        if (!Utility::readBytes(image_bytes_iter, image_bytes, &title[0], 8)) { 
+        if (!available(0, 8)) {
             cout << "Failed to read first eight characters of the volume title\n";
             return false;
         }
-
-        // Jump to next sector
-        if (image_bytes_iter + sector_size - 8 >= image_bytes.end())
-            return false;
-        image_bytes_iter += sector_size - 8;
+        image.copy(side_no, 0, 8, &title[0]);
 
         // Get first block of sector 1
+        if (sector_size >= side_size)
+            return false;
         Byte catalogue_info[8];
-        if (!Utility::readBytes(image_bytes_iter, image_bytes, &catalogue_info[0], 8)) {
+        if (!available(sector_size, 8)) {
             cout << "Failed to read first catalogue block of sector 0\n";
             return false;
         }
+        image.copy(side_no, sector_size, 8, &catalogue_info[0]);
 
-;        // Read last 4 chars of volume title from sector 1 bytes 0 to 3
+        // Read last 4 chars of volume title from sector 1 bytes 0 to 3
         copy(&catalogue_info[0], &catalogue_info[4], &title[8]);
         discSide.discTitle = Utility::paddedByteArray2String(title, 12);
         if (mVerbose)
@@ -184,24 +222,25 @@ bool DiscCodec::read(string discPath, Disc& disc)
         if (mVerbose)
             cout << "No of sectors for volume '" << discSide.discTitle << "': " << (int)discSide.discSize << "\n";
 
-        // Jump back to Sector 0, Block 1
-        image_bytes_iter = image_bytes.begin() + block_size;
-
-        // Read the name and directory belonging of each file stored 
+        // Read the name and directory belonging of each file stored (from Sector 0, Block 1)
         for (int file_no = 0; file_no < discSide.nFiles; file_no++) {
 
+            size_t entry_pos = block_size * (1 + file_no);
+
             Byte file_name[7];
-            if (!Utility::readBytes(image_bytes_iter, image_bytes, &file_name[0], 7)) {
+            if (!available(entry_pos, 7)) {
                 cout << "Failed to read file name\n";
                 return false;
             }
+            image.copy(side_no, entry_pos, 7, &file_name[0]);
             DiscFile file;
             file.name = Utility::paddedByteArray2String(file_name, 7);
             Byte dir_name;
-            if (!Utility::readBytes(image_bytes_iter, image_bytes, &dir_name, 1)) {
+            if (!available(entry_pos + 7, 1)) {
                 cout << "Failed to read directory name for file '" << file.name << "\n";
                 return false;
             }
+            image.copy(side_no, entry_pos + 7, 1, &dir_name);
             DiscDirectory d;
             d.name = (char) (dir_name & 0x7f);
             file.dir = d.name;
@@ -215,17 +254,19 @@ bool DiscCodec::read(string discPath, Disc& disc)
         // Read remaining information about each file stored on the track
         for (int file_no = 0; file_no < discSide.nFiles; file_no++) {
 
-            // Jump to Sector 1, Block (1 + file_no)
-            if (image_bytes.begin() + sector_size + block_size * (1 + file_no) >= image_bytes.end())
+            // Sector 1, Block (1 + file_no)
+            size_t info_pos = sector_size + block_size * (1 + file_no);
+            if (info_pos >= side_size)
                 return false;
-            image_bytes_iter = image_bytes.begin() + sector_size + block_size * (1 + file_no);
 
             Byte file_info[8];
             DiscFile &file = discSide.files[file_no];
-            if (!Utility::readBytes(image_bytes_iter, image_bytes, &file_info[0], 8)) {
+            if (!available(info_pos, 8)) {
                 cout << "Failed to read information about file " << file.name << "\n";
                 return false;
             }
+            image.copy(side_no, info_pos, 8, &file_info[0]);
+
             // Load adress: Sector 1 b15:0 in byte 8-9 + b17:16 in b3b2 of sector 1 byte 14
             file.loadAdr = Utility::bytes2uint(&file_info[0], 2, true) + (((file_info[6] >> 2) & 0x3) << 16);
             // Exec adress: Sector 1 b15:0 in byte 10-11 + b17:16 in b7b6 of sector 1 byte 14
@@ -247,18 +288,23 @@ bool DiscCodec::read(string discPath, Disc& disc)
                     "\n";
             }
 
-            // Jump to start sector for file
-            if (image_bytes.begin() + file.startSector * sector_size >= image_bytes.end())
+            // Refer to the file's data at its start sector (or copy it if it isn't contiguous in the image)
+            size_t data_pos = (size_t) file.startSector * sector_size;
+            if (data_pos >= side_size)
                 return false;
-            image_bytes_iter = image_bytes.begin() + file.startSector * sector_size;
-
-            if (!Utility::readBytes(image_bytes_iter, image_bytes, file.data, file.size)) {
+            if (!available(data_pos, file.size)) {
                 cout << "Failed to read data for file!\n";
                 return false;
             }
+            if (image.contiguous(side_no, data_pos, file.size))
+                file.image = image.bytes(side_no, data_pos);
+            else {
+                file.data.resize(file.size);
+                image.copy(side_no, data_pos, file.size, file.data.data());
+            }
 
             if (mVerbose)
-                cout << "Read " << file.data.size() << " bytes out of expected " << file.size << " for file '" << file.name << "'\n";
+                cout << "Read " << file.nBytes() << " bytes out of expected " << file.size << " for file '" << file.name << "'\n";
    
          }
 
@@ -275,29 +321,30 @@ bool DiscCodec::write(string title, string discPath, vector<TapeFile> &tapeFiles
     }
 
     // Skip empty files and make sure file names become unique and are valid disc file names
-    vector<TapeFile> tapeFiles;
-    map<string, TapeFile> fileNames;
+    // (the files are renamed in place rather than copied)
+    vector<TapeFile*> tapeFiles;
+    set<string> fileNames;
     for (int f = 0; f < tapeFilesIn.size(); f++) {
         if (tapeFilesIn[f].blocks.size() == 0) {
             if (mVerbose)
                 cout << "File '" << tapeFilesIn[f].header.name << "' was empty - skipping it for the disc image!\n";
         }
         else {
-            TapeFile file = tapeFilesIn[f];
+            TapeFile& file = tapeFilesIn[f];
             string disc_filename = tapeFilesIn[f].crValidDiscFilename(tapeFilesIn[f].header.name);
             int no_of_files = (int) tapeFilesIn.size();
             int n = 0;
             for (; fileNames.find(disc_filename) != fileNames.end() && n < no_of_files; n++) {
                 disc_filename = disc_filename.substr(0, disc_filename.length() - 1) + to_string(n % 10);
             }
-            fileNames[disc_filename] = file;
+            fileNames.insert(disc_filename);
             if (n == no_of_files) {
                 cout << "Failed to generate unique disc file names!\n";
                 return false;
             }
             file.header.name = disc_filename;
             file.logFileHdr();
-            tapeFiles.push_back(file);
+            tapeFiles.push_back(&file);
         }
     }
 
@@ -377,9 +424,9 @@ bool DiscCodec::write(string title, string discPath, vector<TapeFile> &tapeFiles
 
         // Write file names and their directories (in Sector 0)
         for (int f = first_file_no; f < first_file_no+n_files_side; f++) {
-            string disc_filename = tapeFiles[f].header.name;
+            string disc_filename = tapeFiles[f]->header.name;
             if (mVerbose)
-                cout << "File #" << f << " '" << tapeFiles[f].header.name << "' (stored as disc file '" << disc_filename << "')\n";
+                cout << "File #" << f << " '" << tapeFiles[f]->header.name << "' (stored as disc file '" << disc_filename << "')\n";
             for (int i = 0; i < 7; i++) {
                 Byte c = 0x20;
                 if (i < disc_filename.size())
@@ -388,7 +435,7 @@ bool DiscCodec::write(string title, string discPath, vector<TapeFile> &tapeFiles
 
             }
             // Set directory name ('+') and locked status
-            Byte d = (Byte) '+' | (tapeFiles[f].header.locked?0x80:0x00);
+            Byte d = (Byte) '+' | (tapeFiles[f]->header.locked?0x80:0x00);
             side_image_bytes[side].push_back(d);
         }
 
@@ -429,25 +476,25 @@ bool DiscCodec::write(string title, string discPath, vector<TapeFile> &tapeFiles
         // Write remaining file information (in Sector 1)
         uint32_t next_available_sector = 2;
         for (int f = first_file_no; f < first_file_no+n_files_side; f++) {
-            FileBlock& first_block = tapeFiles[f].blocks[0];
+            FileBlock& first_block = tapeFiles[f]->blocks[0];
             Byte file_info[8];
             uint32_t start_sector = next_available_sector;
-            next_available_sector += (int)ceil((double)tapeFiles[f].header.size / sector_size);
+            next_available_sector += (int)ceil((double)tapeFiles[f]->header.size / sector_size);
 
             if (mVerbose)
                 cout << "Program " << first_block.name << " starts at Sector " << start_sector << " and occupies " <<
                 next_available_sector - start_sector << " sectors\n";
 
-            Byte load_adr_b9b10 = (tapeFiles[f].header.loadAdr >> (32 - 2)) & 0xc0;
-            Byte exec_adr_b9b10 = (tapeFiles[f].header.execAdr >> (32 - 6)) & 0xc0;
+            Byte load_adr_b9b10 = (tapeFiles[f]->header.loadAdr >> (32 - 2)) & 0xc0;
+            Byte exec_adr_b9b10 = (tapeFiles[f]->header.execAdr >> (32 - 6)) & 0xc0;
             Byte start_sector_b8b9 = (start_sector >> 8) & 0x3;
 
-            file_info[0] = tapeFiles[f].header.loadAdr & 0xff;
-            file_info[1] = (tapeFiles[f].header.loadAdr >> 8) & 0xff;
-            file_info[2] = tapeFiles[f].header.execAdr & 0xff;
-            file_info[3] = (tapeFiles[f].header.execAdr >> 8) & 0xff;
-            file_info[4] = tapeFiles[f].header.size & 0xff;
-            file_info[5] = (tapeFiles[f].header.size >> 8) & 0xff;
+            file_info[0] = tapeFiles[f]->header.loadAdr & 0xff;
+            file_info[1] = (tapeFiles[f]->header.loadAdr >> 8) & 0xff;
+            file_info[2] = tapeFiles[f]->header.execAdr & 0xff;
+            file_info[3] = (tapeFiles[f]->header.execAdr >> 8) & 0xff;
+            file_info[4] = tapeFiles[f]->header.size & 0xff;
+            file_info[5] = (tapeFiles[f]->header.size >> 8) & 0xff;
             file_info[6] = load_adr_b9b10 | exec_adr_b9b10 | start_sector_b8b9;
             file_info[7] = start_sector & 0xff;
 
@@ -467,10 +514,10 @@ bool DiscCodec::write(string title, string discPath, vector<TapeFile> &tapeFiles
         // Write the file data
         for (int f = first_file_no; f < first_file_no+n_files_side; f++) {
 
-            vector<FileBlock>& blocks = tapeFiles[f].blocks;
+            vector<FileBlock>& blocks = tapeFiles[f]->blocks;
 
             if (mVerbose)
-                cout << "Writing block data for program " << tapeFiles[f].header.name << " with #" << blocks.size() << " blocks\n";
+                cout << "Writing block data for program " << tapeFiles[f]->header.name << " with #" << blocks.size() << " blocks\n";
 
             int data_sz = 0;
             for (int b = 0; b < blocks.size(); b++) {
@@ -3,10 +3,12 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include "CommonTypes.h"
 #include "Logging.h"
 #include <sstream>
 #include "FileBlock.h"
+#include "MappedFile.h"
 
 //
 // Codec for Acorn DFS discs (SSD)
@@ -39,6 +41,54 @@ public:
 	int nTracks = 40;
 };
 
+//
+// A view of a disc image (SSD or DSD) - either a memory-mapped disc image file or a disc image
+// already in memory (e.g., a disc slot of a memory-mapped MMB file).
+//
+// The sides of a DSD image are not de-interleaved into separate copies. Instead, a position
+// on a side is translated into an image offset (track t of side s is track 2t + s of the image).
+//
+// No more than 80 tracks per side are used. The image may be incomplete (sectors without data are
+// sometimes not stored in the image) and a side then ends where the image ends.
+//
+class DiscImage {
+
+private:
+
+	MappedFile mFile;
+	const Byte* mImage = NULL;
+	size_t mImageSize = 0;
+	bool mInterleaved = false;
+
+	// Offset in the image of a position on a side
+	size_t imagePos(int side, size_t pos);
+
+public:
+
+	// Map a disc image file (DSD if interleaved)
+	bool open(string discPath, bool interleaved);
+
+	// Use a disc image already in memory (that must remain valid as long as the view is used)
+	void assign(const Byte* image, size_t imageSize, bool interleaved);
+
+	int nSides() { return (mInterleaved ? 2 : 1); }
+
+	// No of (complete or incomplete) tracks in the image
+	int nTracks();
+
+	// No of bytes stored for a side
+	size_t sideSize(int side);
+
+	// Pointer to the byte at a position on a side
+	const Byte* bytes(int side, size_t pos) { return mImage + imagePos(side, pos); }
+
+	// Are n bytes from a position on a side stored contiguously in the image?
+	bool contiguous(int side, size_t pos, size_t n);
+
+	// Copy n bytes from a position on a side
+	void copy(int side, size_t pos, size_t n, Byte* dst);
+};
+
 class DiscFile {
 public:
 	string name;
@@ -46,9 +96,14 @@ public:
 	int loadAdr; // 18 bits
 	int execAdr; // 18 bits
 	int size; // 18 bits
-	Bytes data;
+	const Byte* image = NULL; // The file's data in the disc image (if stored contiguously in it)
+	Bytes data; // A copy of the file's data (only if not stored contiguously in the disc image)
 	int startSector;
 	bool locked = false;
+
+	// The file's data (without copying it from the disc image if possible)
+	const Byte* bytes() { return (image != NULL ? image : data.data()); }
+	size_t nBytes() { return (image != NULL ? (size_t) size : data.size()); }
 };
 
 class DiscDirectory {
@@ -81,6 +136,7 @@ public:
 class Disc {
 public:
 	vector<DiscSide> side;
+	shared_ptr<DiscImage> image; // The disc image that the files' data refer to
 };
 
 class DiscPos {
@@ -103,19 +159,25 @@ class DiscCodec {
 private:
 
 	bool mVerbose = false;
-	ifstream *mFin_p = NULL;
 	DiscPos mDiscPos;
-	Disc *mDisc_p = NULL;
 
 protected:
-	
-	bool openDiscFile(string discPath, Disc& disc);
-	bool closeDiscFile();
+
+	// Read the catalogue and files of the disc image's side(s)
+	bool readSides(Disc& disc);
 
 public:
 
 	DiscCodec(Logging logging);
+
+	// Read a disc image file (SSD or DSD) - the file is memory-mapped for as long as the disc exists
 	bool read(string discPath, Disc & disc);
+
+	// Read a disc image already in memory (SSD or, if interleaved, DSD) - the image must
+	// remain valid for as long as the disc's file data is used
+	bool read(const Byte* image, size_t imageSize, bool interleaved, Disc& disc);
+
+	// Write Tape Files to a disc image file (SSD or DSD) - the files are renamed to their (unique) disc file names
 	bool write(string title, string discPath, vector<TapeFile> &tapeFiles);
 };
 
@@ -167,6 +167,7 @@ bool FileBlock::init()
     this->no = 0x0;
     this->locked = false;
     this->nextAdr = 0x0;
+    this->corrupted = false;
 
     return true;
 }
@@ -33,7 +33,7 @@ public:
 	FileHeader(string n, uint32_t LA, uint32_t EA, uint32_t sz, TargetMachine t, bool l) :
 		name(n), loadAdr(LA), execAdr(EA), targetMachine(t), size(sz), locked(l) {}
 
-	FileHeader(TargetMachine tm, string program) : targetMachine(tm), name(program) {
+	FileHeader(TargetMachine tm, string program) : targetMachine(tm), name(program), size(0) {
 		if (targetMachine <= BBC_MASTER) {
 			loadAdr = 0xffff0e00;
 			execAdr = 0xffff0e00;
@@ -73,6 +73,7 @@ public:
 	// Block's correctness status (when read from tape)
 	bool completeHdr = true;
 	bool completeData = true;
+	bool corrupted = false; // true if the block could be corrupted (incorrect CRC or not all data read)
 
 	// Overall block timing (when read from tape)
 	double tapeStartTime = -1; // start of block
@@ -179,6 +180,11 @@ public:
 	TapeFile(FileHeader h) { header = h; }
 	TapeFile() : header("???", 0x0, 0x0, 0x0, TargetMachine::UNKNOWN_TARGET) {}
 
+	TapeFile(TapeFile&&) = default;
+	TapeFile& operator=(TapeFile&&) = default;
+	TapeFile(const TapeFile&) = delete;
+	TapeFile& operator=(const TapeFile&) = delete;
+
 	void logFileHdr(ostream* fout);
 	void logFileHdr();
 	void init();
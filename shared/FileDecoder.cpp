@@ -1,5 +1,6 @@
 #include "FileDecoder.h"
 #include "BlockDecoder.h"
+#include "DecoderChain.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -17,8 +18,8 @@ using namespace std;
 
 
 
-FileDecoder::FileDecoder(
-    BlockDecoder& blockDecoder,
+template <class BD> FileDecoderT<BD>::FileDecoderT(
+    BD& blockDecoder,
     Logging logging, TargetMachine targetMachine, TapeProperties tapeTiming, bool catOnly
 ) : mDebugInfo(logging), mBlockDecoder(blockDecoder), mCat(catOnly), mTarget(targetMachine),
 mTapeTiming(tapeTiming)
@@ -31,7 +32,7 @@ mTapeTiming(tapeTiming)
 }
 
 
-string FileDecoder::timeToStr(double t) {
+template <class BD> string FileDecoderT<BD>::timeToStr(double t) {
     char t_str[64];
     int t_h = (int)trunc(t / 3600);
     int t_m = (int)trunc((t - t_h) / 60);
@@ -40,7 +41,7 @@ string FileDecoder::timeToStr(double t) {
     return string(t_str);
 }
 
-bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchName, FileReadStatus &readStatus)
+template <class BD> bool FileDecoderT<BD>::readFile(ostream& logFile, TapeFile& tapFile, string searchName, FileReadStatus &readStatus)
 {
 
     readStatus = FileReadStatus::OK;
@@ -216,8 +217,7 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
 
 
                 // Fill incompleted part of block with zeros...
-                for (int i = 0; i < block_sz - mBlockDecoder.nReadBytes; i++)
-                    read_block.data.push_back(0x0);
+                read_block.data.insert(read_block.data.end(), block_sz - mBlockDecoder.nReadBytes, 0x0);
 
             }
 
@@ -233,7 +233,6 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
 
             last_block = (read_block.blockType == Single || read_block.blockType == Last);
 
-            tapFile.blocks.push_back(read_block);
             n_blocks++;
 
             if (block_no != expected_block_no) {
@@ -298,7 +297,8 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
                 if (mDebugInfo.verbose)
                     cout << " ";
             }
-            if (file_selected && !mCat)
+            // Only format the block header when it can be written (the formatting allocates strings)
+            if (file_selected && !mCat && logFile.good())
                 read_block.logFileBlockHdr(&logFile);
 
             if (mDebugInfo.verbose && file_selected)
@@ -307,6 +307,11 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
 
             adr_offset += block_sz;
 
+            read_block.corrupted = incomplete_block || corrupted_block;
+
+            // Store the block (moved as it isn't used anymore)
+            tapFile.blocks.push_back(move(read_block));
+
         }
 
         //
@@ -338,7 +343,7 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
                 tapFile.corrupted = true;
             if (file_selected && !mCat) {
                 stringstream s;
-                s << FileDecoder::readFileStatus(readStatus) << " for file '" << tapFile.header.name << "' [" <<
+                s << readFileStatus(readStatus) << " for file '" << tapFile.header.name << "' [" <<
                     Utility::encodeTime(tapFile.blocks[0].tapeStartTime) << "," <<
                     Utility::encodeTime(tapFile.blocks[n_blocks - 1].tapeEndTime) << "]";
                 cout << s.str() << "\n";
@@ -362,7 +367,7 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
             tapFile.header.locked = tapFile.header.locked || tapFile.blocks[i].locked;
         }
 
-        if (file_selected && !mCat) {
+        if (file_selected && !mCat && logFile.good()) {
             logFile << "\n";
             tapFile.logFileHdr(&logFile);
             logFile << "\n\n";
@@ -382,3 +387,11 @@ bool FileDecoder::readFile(ostream& logFile, TapeFile& tapFile, string searchNam
 
 }
 
+// Polymorphic file decoder (any tape reader)
+template class FileDecoderT<BlockDecoder>;
+
+// File decoders with the block decoder resolved at compile time
+template class FileDecoderT<WavSampleBlockDecoder>;
+template class FileDecoderT<FSKSampleBlockDecoder>;
+template class FileDecoderT<CSWPulseBlockDecoder>;
+template class FileDecoderT<UEFBlockDecoder>;
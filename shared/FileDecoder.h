@@ -16,7 +16,14 @@ enum FileReadStatus {
 	CORRUPTED_BLOCKS = 0x4, END_OF_TAPE = 0x8
 };
 
-class FileDecoder
+//
+// File decoder reading complete files using a block decoder.
+//
+// The type of block decoder is a template parameter - see DecoderChain.h for the
+// decoder chains composed at compile time. The supported instantiations are made
+// in FileDecoder.cpp.
+//
+template <class BD> class FileDecoderT
 {
 
 
@@ -27,7 +34,7 @@ protected:
 	TapeProperties mTapeTiming;
 
 	TargetMachine mTarget;
-	BlockDecoder mBlockDecoder;
+	BD mBlockDecoder;
 
 	string timeToStr(double t);
 
@@ -52,8 +59,8 @@ public:
 		return s.str();
 	}
 
-	FileDecoder(
-		BlockDecoder& blockDecoder,
+	FileDecoderT(
+		BD& blockDecoder,
 		Logging logging, TargetMachine targetMachine, TapeProperties tapeTiming, bool catOnly = false
 	);
 
@@ -64,4 +71,8 @@ public:
 
 };
 
+// File decoder for any type of tape reader
+typedef FileDecoderT<BlockDecoder> FileDecoder;
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "CommonTypes.h"
+#include "GoertzelCycleDecoder.h"
+#include "Logging.h"
+#include "WaveSampleTypes.h"
+#include "Utility.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+// Constructor
+GoertzelCycleDecoder::GoertzelCycleDecoder(
+	int sampleFreq, Samples& samples, double startTime, double freqThreshold, Logging logging
+) : CycleDecoder(sampleFreq, freqThreshold, logging)
+{
+
+	mHalfCycle = { Frequency::NoCarrierFrequency, Level::NoCarrierLevel, 0, 0 };
+
+	// The regenerated 1/2 cycles are spread evenly over each tone run so their durations follow the
+	// lengths of the runs rather than the carrier - tracking them would only bias the carrier estimate
+	mTrackCarrier = false;
+
+	vector<uint8_t> tones;
+	demodulate(samples, tones);
+	regenerateLevels(tones);
+
+	// Advance to time startTime before searching for data
+	if (startTime > 0)
+		mSampleIndex = (int) min((double) mLevels.size(), ceil(startTime * mCT.fS));
+
+}
+
+//
+// Demodulate all samples into tones.
+//
+// The energy of a tone at a sample is the squared magnitude of the tone's DFT bin for a window
+// of one F1 cycle centred around the sample. The samples are processed in blocks and for each block
+// the samples are first mixed with the tones (a loop the compiler vectorises) and then the mixed samples
+// are summed over a sliding window. The phase of the tones is relative the start of each block which
+// is fine as only the energy (and not the phase) of a tone is used.
+//
+void GoertzelCycleDecoder::demodulate(Samples& samples, vector<uint8_t>& tones)
+{
+	const int n_samples = (int) samples.size();
+	tones.assign(n_samples, NO_TONE);
+
+	const int window = max(2, (int) round(mCT.fS / (double) F1_FREQ));
+	const int half_window = window / 2;
+	const int table_size = mBlockSize + window;
+
+	// Tone tables for one block
+	vector<float> cos_f1(table_size), sin_f1(table_size), cos_f2(table_size), sin_f2(table_size);
+	const double PI = 3.14159265358979323846;
+	const double w_f1 = 2 * PI * F1_FREQ / mCT.fS;
+	const double w_f2 = 2 * PI * F2_FREQ / mCT.fS;
+	for (int j = 0; j < table_size; j++) {
+		cos_f1[j] = (float) cos(w_f1 * j);
+		sin_f1[j] = (float) sin(w_f1 * j);
+		cos_f2[j] = (float) cos(w_f2 * j);
+		sin_f2[j] = (float) sin(w_f2 * j);
+	}
+
+	vector<float> x(table_size), x_cos_f1(table_size), x_sin_f1(table_size), x_cos_f2(table_size), x_sin_f2(table_size);
+
+	const double min_amplitude = mMinAmplitude * SAMPLE_HIGH_MAX;
+	const double decay = exp(-1.0 / (mAmplitudeDecayTime * mCT.fS));
+	double max_amplitude = 0;
+
+	for (int block_start = 0; block_start < n_samples; block_start += mBlockSize) {
+
+		const int block_len = (n_samples - block_start < mBlockSize ? n_samples - block_start : mBlockSize);
+		const int first = block_start - half_window; // first sample of the first window
+		const int n = block_len + window - 1; // no of samples in all the block's windows
+
+		// Get the samples (that are zero outside the tape)
+		for (int j = 0; j < n; j++) {
+			int i = first + j;
+			x[j] = (i >= 0 && i < n_samples ? samples[i] : 0);
+		}
+
+		// Mix the samples with the tones
+		for (int j = 0; j < n; j++) {
+			x_cos_f1[j] = x[j] * cos_f1[j];
+			x_sin_f1[j] = x[j] * sin_f1[j];
+			x_cos_f2[j] = x[j] * cos_f2[j];
+			x_sin_f2[j] = x[j] * sin_f2[j];
+		}
+
+		// Sum the mixed samples over a sliding window and select the strongest tone
+		double c_f1 = 0, s_f1 = 0, c_f2 = 0, s_f2 = 0;
+		for (int j = 0; j < window - 1; j++) {
+			c_f1 += x_cos_f1[j]; s_f1 += x_sin_f1[j]; c_f2 += x_cos_f2[j]; s_f2 += x_sin_f2[j];
+		}
+		for (int k = 0; k < block_len; k++) {
+			int j = k + window - 1;
+			c_f1 += x_cos_f1[j]; s_f1 += x_sin_f1[j]; c_f2 += x_cos_f2[j]; s_f2 += x_sin_f2[j];
+
+			double e_f1 = c_f1 * c_f1 + s_f1 * s_f1;
+			double e_f2 = c_f2 * c_f2 + s_f2 * s_f2;
+			double amplitude = 2 * sqrt(max(e_f1, e_f2)) / window;
+			max_amplitude = max(amplitude, max_amplitude * decay);
+			if (amplitude >= min_amplitude && amplitude >= mMinRelativeAmplitude * max_amplitude)
+				tones[block_start + k] = (e_f1 > e_f2 ? F1_TONE : F2_TONE);
+
+			c_f1 -= x_cos_f1[k]; s_f1 -= x_sin_f1[k]; c_f2 -= x_cos_f2[k]; s_f2 -= x_sin_f2[k];
+		}
+	}
+}
+
+//
+// Regenerate the levels from the tones.
+//
+// A run of the same tone that is too short to be a tone (noise) is first merged into the preceeding run.
+// Each run is then filled with as many (equally long) 1/2 cycles of the tone as fit into it. The level
+// alternates between high and low also across tone changes and restarts with a high level after no carrier.
+//
+void GoertzelCycleDecoder::regenerateLevels(vector<uint8_t>& tones)
+{
+	const int n_samples = (int) tones.size();
+	mLevels.assign(n_samples, NoCarrierLevel);
+
+	// Merge too short runs into the preceeding run
+	const int min_run_len = (int) round(mMinRunCycles * mCT.fS / F2_FREQ);
+	for (int start = 0; start < n_samples;) {
+		int end = start + 1;
+		while (end < n_samples && tones[end] == tones[start])
+			end++;
+		if (start > 0 && end - start < min_run_len) {
+			for (int i = start; i < end; i++)
+				tones[i] = tones[start - 1];
+		}
+		start = end;
+	}
+
+	// Fill each run with 1/2 cycles
+	Level level = HighLevel;
+	for (int start = 0; start < n_samples;) {
+		int end = start + 1;
+		while (end < n_samples && tones[end] == tones[start])
+			end++;
+		int run_len = end - start;
+
+		if (tones[start] == NO_TONE)
+			level = HighLevel;
+		else {
+			double f = (tones[start] == F1_TONE ? F1_FREQ : F2_FREQ);
+			int n_half_cycles = max(1, (int) round(run_len * 2 * f / mCT.fS));
+			for (int h = 0; h < n_half_cycles; h++) {
+				int hc_start = start + (int) ((long long) run_len * h / n_half_cycles);
+				int hc_end = start + (int) ((long long) run_len * (h + 1) / n_half_cycles);
+				for (int i = hc_start; i < hc_end; i++)
+					mLevels[i] = level;
+				level = (level == HighLevel ? LowLevel : HighLevel);
+			}
+		}
+
+		start = end;
+	}
+}
+
+// Save the current cycle
+bool GoertzelCycleDecoder::checkpoint()
+{
+	mHalfCycleCheckpoints.push_back(mHalfCycle);
+	mSampleIndexCheckpoints.push_back(mSampleIndex);
+	return true;
+}
+
+// Roll back to a previously saved cycle
+bool GoertzelCycleDecoder::rollback()
+{
+
+	if (mHalfCycleCheckpoints.size() == 0)
+		return false;
+
+	mHalfCycle = mHalfCycleCheckpoints.back();
+	mHalfCycleCheckpoints.pop_back();
+	mSampleIndex = mSampleIndexCheckpoints.back();
+	mSampleIndexCheckpoints.pop_back();
+	return true;
+
+}
+
+// Remove checkpoint (without rolling back)
+bool GoertzelCycleDecoder::regretCheckpoint()
+{
+	if (mHalfCycleCheckpoints.size() == 0)
+		return false;
+
+	(void) mHalfCycleCheckpoints.pop_back();
+	(void) mSampleIndexCheckpoints.pop_back();
+	return true;
+}
+
+// Collect as many samples as possible of the same level (High or Low)
+bool GoertzelCycleDecoder::advanceHalfCycle() {
+
+	bool transition = false;
+
+	for (; !transition && !endOfSamples(); ) {
+		if (!getNextSample(transition)) // can only fail for end of samples
+			return false;
+	}
+
+	return transition;
+}
+
+// Get next sample and update 1/2 cycle info based on it
+bool GoertzelCycleDecoder::getNextSample(bool& transition)
+{
+	transition = false;
+
+	if (endOfSamples())
+		return false;
+
+	int sample_no = mSampleIndex++;
+	Level level_p = (sample_no > 0 ? (Level) mLevels[sample_no - 1] : NoCarrierLevel);
+	Level level = (Level) mLevels[sample_no];
+
+	// Update 1/2 cycle info for a transition
+	if (level != level_p && sample_no > 0) {
+		updateHalfCycleFreq(mHalfCycle.nSamples, level_p);
+		mHalfCycle.nSamples = 1; // Also count the sample that just was read above
+		transition = true;
+	}
+	else
+		mHalfCycle.nSamples++;
+
+	return true;
+}
+
+// Get tape time
+double GoertzelCycleDecoder::getTime()
+{
+	return mSampleIndex * mCT.tS;
+}
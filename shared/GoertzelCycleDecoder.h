@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef GOERTZEL_CYCLE_DECODER_H
+#define GOERTZEL_CYCLE_DECODER_H
+
+#include <vector>
+#include <cstdint>
+#include "CycleDecoder.h"
+#include "WaveSampleTypes.h"
+
+
+//
+// Cycle Decoder that demodulates the FSK tones instead of detecting levels with a Schmitt-trigger.
+//
+// For each sample, the energy of the F1 and F2 tones within a window of one F1 cycle (centred around
+// the sample) is measured with a sliding DFT (i.e., a Goertzel filter per tone). The stronger tone
+// decides the frequency at the sample (or no carrier if the tone is too weak). The levels are then
+// regenerated from runs of the same tone: each run is filled with as many 1/2 cycles of the tone as fit
+// into it, i.e. the 1/2 cycles are aligned with the tone changes (and thereby with the data bits) as for
+// a clean tape. As noise and low amplitudes affect the tone energies much less than the zero crossings
+// of the signal, this makes it possible to decode noisy tapes without filtering them first.
+//
+class GoertzelCycleDecoder final : public CycleDecoder
+{
+
+private:
+
+	enum Tone { NO_TONE = 0, F1_TONE = 1, F2_TONE = 2 };
+
+	// Regenerated level (Level) for each sample
+	vector<uint8_t> mLevels;
+
+	// No of samples demodulated at once (with the tone tables below)
+	static const int mBlockSize = 4096;
+
+	// Min amplitude (relative the max amplitude) of a tone for it to be considered a carrier
+	const double mMinRelativeAmplitude = 0.25;
+
+	// Min amplitude (relative full scale) of a tone for it to be considered a carrier
+	const double mMinAmplitude = 0.002;
+
+	// Time constant [s] of the decay of the max amplitude
+	const double mAmplitudeDecayTime = 0.5;
+
+	// Min duration (in F2 cycles) of a run of the same tone - shorter runs are considered to be noise
+	const double mMinRunCycles = 1.0;
+
+	// Sample index - saved when creating a checkpoint
+	int mSampleIndex = 0;
+	vector<int> mSampleIndexCheckpoints;
+
+	// Demodulate all samples into tones
+	void demodulate(Samples& samples, vector<uint8_t>& tones);
+
+	// Regenerate the levels from the tones
+	void regenerateLevels(vector<uint8_t>& tones);
+
+	// Get next sample and update 1/2 cycle info for a transition
+	bool getNextSample(bool& transition);
+
+	bool endOfSamples() { return mSampleIndex >= mLevels.size(); }
+
+public:
+
+	GoertzelCycleDecoder(
+		int sampleFreq, Samples& samples, double startTime, double freqThreshold, Logging logging
+	);
+
+	// Get the next 1/2 cycle (F1, F2 or unknown)
+	bool advanceHalfCycle();
+
+	// Get tape time
+	double getTime();
+
+	// Save the current cycle
+	bool checkpoint();
+
+	// Roll back to a previously saved cycle
+	bool rollback();
+
+	// Remove checkpoint (without rolling back)
+	bool regretCheckpoint();
+
+};
+
+#endif
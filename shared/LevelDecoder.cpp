@@ -46,8 +46,10 @@ bool LevelDecoder::regretCheckpoint()
 }
 
 LevelDecoder::LevelDecoder(
-	int sampleFreq, Samples &samples, double startTime, double freqThreshold, double levelThreshold, Logging logging
-): mSamples(samples), mDebugInfo(logging) { // A reference can only be initialised this way!
+	int sampleFreq, Samples &samples, double startTime, double freqThreshold, double levelThreshold, Logging logging,
+	bool pipelined
+): mSamples(samples), mDebugInfo(logging), mCarrierMap(sampleFreq, samples, freqThreshold, logging),
+	mPipelined(pipelined), mLevelChangeQueue(pipelined ? 16 * mLevelChangeBatch : 1) { // A reference can only be initialised this way!
 
 	mHighThreshold = (int) round(levelThreshold * SAMPLE_HIGH_MAX);
 	mLowThreshold = (int) round(levelThreshold * SAMPLE_LOW_MIN);
@@ -65,49 +67,244 @@ LevelDecoder::LevelDecoder(
 	if (startTime > 0)
 		while (mLevelInfo.sampleIndex < mSamples.size() && (mLevelInfo.sampleIndex * mTS < startTime)) mLevelInfo.sampleIndex++;
 
+	// Start extracting the levels in parallel with the decoding of them
+	if (mPipelined)
+		mExtractionThread = thread(&LevelDecoder::extractLevelChanges, this, mLevelInfo.sampleIndex);
 	
 }
 
+LevelDecoder::~LevelDecoder()
+{
+	if (mExtractionThread.joinable()) {
+		mStopExtraction = true;
+		mLevelChangeQueue.cancel();
+		mExtractionThread.join();
+	}
+}
 
-bool LevelDecoder::getNextSample(Level& level, int& sampleNo) {
-
-	if (mLevelInfo.sampleIndex == mSamples.size())
-		return false;
-
-	sampleNo = mLevelInfo.sampleIndex;
-	Sample sample = mSamples[mLevelInfo.sampleIndex++];
-
-	if ((mLevelInfo.state == NoCarrierLevel || mLevelInfo.state == LowLevel) && sample >= mHighThreshold) {
+//
+// Update the level with the next sample (Schmitt-trigger)
+//
+Level LevelDecoder::updateLevel(LevelInfo& levelInfo, Sample sample)
+{
+	if ((levelInfo.state == NoCarrierLevel || levelInfo.state == LowLevel) && sample >= mHighThreshold) {
 		// >= in case mHighThreshold = mLowThreshold = 0 to secure that HIGH includes sampled value '0'
-		mLevelInfo.state = HighLevel;
-		mLevelInfo.nSamplesLow = 0;
+		levelInfo.state = HighLevel;
+		levelInfo.nSamplesLow = 0;
 	}
-	else if ((mLevelInfo.state == NoCarrierLevel || mLevelInfo.state == HighLevel) && sample < mLowThreshold) {
+	else if ((levelInfo.state == NoCarrierLevel || levelInfo.state == HighLevel) && sample < mLowThreshold) {
 		// < in case mHighThreshold = mLowThreshold = 0 to secure that LOW excludes sampled value '0'
-		mLevelInfo.state = LowLevel;
-		mLevelInfo.nSamplesHigh = 0;
+		levelInfo.state = LowLevel;
+		levelInfo.nSamplesHigh = 0;
 	}
 	else if (
-			(mLevelInfo.state == LowLevel && mLevelInfo.nSamplesLow > mNLevelSamplesMax) ||
-			(mLevelInfo.state == HighLevel && mLevelInfo.nSamplesHigh > mNLevelSamplesMax)
+			(levelInfo.state == LowLevel && levelInfo.nSamplesLow > mNLevelSamplesMax) ||
+			(levelInfo.state == HighLevel && levelInfo.nSamplesHigh > mNLevelSamplesMax)
 		) {
-		mLevelInfo.state = NoCarrierLevel;
-		mLevelInfo.nSamplesLow = 0;
-		mLevelInfo.nSamplesHigh = 0;
-	} else if (mLevelInfo.state == LowLevel) { // Unchanged level => measure time staying at same level
-		mLevelInfo.nSamplesLow++;
+		levelInfo.state = NoCarrierLevel;
+		levelInfo.nSamplesLow = 0;
+		levelInfo.nSamplesHigh = 0;
+	} else if (levelInfo.state == LowLevel) { // Unchanged level => measure time staying at same level
+		levelInfo.nSamplesLow++;
 	}
-	else { // mLevelInfo.state == High
-		mLevelInfo.nSamplesHigh++;
+	else { // levelInfo.state == High
+		levelInfo.nSamplesHigh++;
 	}
 
+	return levelInfo.state;
+}
+
+bool LevelDecoder::getNextSample(Level& level, int& sampleNo) {
+
+	if (mLevelInfo.sampleIndex == mSamples.size())
+		return false;
+
+	sampleNo = mLevelInfo.sampleIndex++;
+
+	if (mPipelined) {
+		// Take the level from the next level change if it starts with this sample
+		LevelChange* change = getLevelChange(mLevelInfo.levelChangeIndex);
+		if (change != NULL && change->sampleNo == sampleNo) {
+			mLevelInfo.state = change->level;
+			mLevelInfo.levelChangeIndex++;
+		}
+	}
+	else
+		(void) updateLevel(mLevelInfo, mSamples[sampleNo]);
 
 	level = mLevelInfo.state;
 
 	return true;
 }
 
+//
+// Extract the level changes from sample startSample and onwards (the extraction thread).
+//
+// The levels are extracted exactly as getNextSample would do it and each level change is passed
+// (in batches) to the decoding thread.
+//
+void LevelDecoder::extractLevelChanges(int startSample)
+{
+	LevelInfo level_info;
+	LevelChange batch[mLevelChangeBatch];
+	int n_batch = 0;
+	int n_samples = (int) mSamples.size();
+
+	for (int i = startSample; i <= n_samples && !mStopExtraction; i++) {
+
+		if (i < n_samples) {
+			Level prev_level = level_info.state;
+			Level level = updateLevel(level_info, mSamples[i]);
+			if (level != prev_level)
+				batch[n_batch++] = { i, level, transitionPos(i, level) };
+		}
+
+		// Pass a full batch (or the last level changes) to the decoding thread
+		if (n_batch == mLevelChangeBatch || (i == n_samples && n_batch > 0)) {
+			int n_pushed = 0;
+			while (n_pushed < n_batch && !mStopExtraction) {
+				size_t n = mLevelChangeQueue.push(batch + n_pushed, n_batch - n_pushed);
+				if (n == 0)
+					mLevelChangeQueue.waitForSpace();
+				n_pushed += (int) n;
+			}
+			n_batch = 0;
+		}
+	}
+
+	mLevelChangeQueue.close();
+}
+
+//
+// Get level change levelChangeIndex (waits for the extraction thread if needed - NULL if there is no such change).
+//
+// When there are no checkpoints, the level changes before the last consumed one can no longer be
+// needed and are then discarded (once there are many of them).
+//
+LevelDecoder::LevelChange* LevelDecoder::getLevelChange(int levelChangeIndex)
+{
+	while (levelChangeIndex - mFirstLevelChange >= (int) mLevelChanges.size()) {
+
+		if (mAllLevelChangesReceived)
+			return NULL;
+
+		// Discard the level changes that are no longer needed
+		int n_consumed = mLevelInfo.levelChangeIndex - 1 - mFirstLevelChange;
+		if (mCheckPoints.size() == 0 && n_consumed > mMaxConsumedLevelChanges) {
+			mLevelChanges.erase(mLevelChanges.begin(), mLevelChanges.begin() + n_consumed);
+			mFirstLevelChange += n_consumed;
+		}
+
+		// Receive the next batch of level changes
+		bool closed = mLevelChangeQueue.closed();
+		LevelChange batch[mLevelChangeBatch];
+		size_t n = mLevelChangeQueue.pop(batch, mLevelChangeBatch);
+		mLevelChanges.insert(mLevelChanges.end(), batch, batch + n);
+		if (n == 0 && closed)
+			mAllLevelChangesReceived = true;
+		else if (n == 0)
+			mLevelChangeQueue.waitForItems();
+	}
 
+	return &mLevelChanges[levelChangeIndex - mFirstLevelChange];
+}
+
+//
+// Skip the samples up to the next level change (if known without reading them) and return the no of skipped samples.
+//
+// Only when pipelined are the level changes known in advance. Otherwise no samples are skipped.
+//
+int LevelDecoder::skipToLevelChange()
+{
+	if (!mPipelined)
+		return 0;
+
+	LevelChange* change = getLevelChange(mLevelInfo.levelChangeIndex);
+	int next_change_sample = (change != NULL ? change->sampleNo : (int) mSamples.size());
+	int n_skipped = next_change_sample - mLevelInfo.sampleIndex;
+	if (n_skipped <= 0)
+		return 0;
+
+	mLevelInfo.sampleIndex = next_change_sample;
+
+	return n_skipped;
+}
+
+//
+// Get the (interpolated) sample position where the signal crossed the threshold of
+// the level that started with sample sampleNo.
+//
+double LevelDecoder::getTransitionPos(int sampleNo)
+{
+	if (mPipelined) {
+		// The crossing of the last consumed level change
+		int last_change_index = mLevelInfo.levelChangeIndex - 1;
+		if (last_change_index >= mFirstLevelChange) {
+			LevelChange* change = getLevelChange(last_change_index);
+			if (change != NULL && change->sampleNo == sampleNo)
+				return change->transitionPos;
+		}
+		return sampleNo;
+	}
+
+	return transitionPos(sampleNo, mLevelInfo.state);
+}
+
+//
+// Get the (interpolated) position of the threshold crossing for a new level that started with sample sampleNo.
+//
+// The crossing is linearly interpolated between sample sampleNo - 1 and sampleNo. If the
+// level didn't start with a crossing (i.e., it is 'no carrier' or follows upon 'no carrier'
+// without crossing the threshold) then it is the position of the sample itself.
+//
+double LevelDecoder::transitionPos(int sampleNo, Level level)
+{
+	if (sampleNo <= 0 || sampleNo >= mSamples.size())
+		return sampleNo;
+
+	double s0 = mSamples[sampleNo - 1];
+	double s1 = mSamples[sampleNo];
+	double threshold;
+	if (level == HighLevel && s0 < mHighThreshold && s1 >= mHighThreshold)
+		threshold = mHighThreshold;
+	else if (level == LowLevel && s0 >= mLowThreshold && s1 < mLowThreshold)
+		threshold = mLowThreshold;
+	else
+		return sampleNo;
+
+	return sampleNo - 1 + (threshold - s0) / (s1 - s0);
+}
+
+//
+// Skip silence and noise up to shortly before the next possible carrier.
+//
+// The level is reset to 'no carrier' as the skipped samples can't contain any 1/2 cycles. When pipelined,
+// the level changes of the skipped samples are instead consumed (as they have already been extracted)
+// so that the level continues from the extracted level.
+//
+bool LevelDecoder::skipToCarrier()
+{
+	int skip_to = mCarrierMap.skipTo(mLevelInfo.sampleIndex);
+	if (skip_to <= mLevelInfo.sampleIndex)
+		return false;
+
+	mLevelInfo.sampleIndex = skip_to;
+
+	if (mPipelined) {
+		LevelChange* change;
+		while ((change = getLevelChange(mLevelInfo.levelChangeIndex)) != NULL && change->sampleNo < skip_to) {
+			mLevelInfo.state = change->level;
+			mLevelInfo.levelChangeIndex++;
+		}
+		return true;
+	}
+
+	mLevelInfo.state = NoCarrierLevel;
+	mLevelInfo.nSamplesLow = 0;
+	mLevelInfo.nSamplesHigh = 0;
+
+	return true;
+}
 
 bool LevelDecoder::endOfSamples() { return (mLevelInfo.sampleIndex == mSamples.size()); }
 
@@ -3,8 +3,12 @@
 #ifndef LEVEL_DECODER_H
 #define LEVEL_DECODER_H
 
+#include <thread>
+#include <atomic>
 #include "WaveSampleTypes.h"
 #include "Logging.h"
+#include "CarrierMap.h"
+#include "SpscQueue.h"
 
 
 class LevelDecoder {
@@ -38,19 +42,72 @@ private:
 		int nSamplesHigh = 0;
 		int sampleIndex = 0;
 		Level state = NoCarrierLevel;
+		int levelChangeIndex = 0; // index of the next level change to consume (only used when pipelined)
 	} ;
 
 	LevelInfo mLevelInfo = { 0, 0, 0, NoCarrierLevel };
 
 	vector<LevelInfo> mCheckPoints;
+
+	// Map of the regions that could contain a carrier (to skip silence and noise when waiting for a carrier)
+	CarrierMap mCarrierMap;
+
+	//
+	// Pipelined mode - the levels are extracted from the samples by a thread of its own and passed
+	// as level changes over a lock-free queue to the thread decoding the levels (i.e., the thread
+	// calling getNextSample). The level changes are kept until no checkpoint can roll back to them.
+	//
+	class LevelChange
+	{
+	public:
+		int sampleNo; // sample that the new level starts with
+		Level level;
+		double transitionPos; // (interpolated) sample position of the threshold crossing
+	};
+
+	bool mPipelined = false;
+	SpscQueue<LevelChange> mLevelChangeQueue;
+	thread mExtractionThread;
+	atomic<bool> mStopExtraction { false };
+	vector<LevelChange> mLevelChanges; // received level changes (that can still be needed)
+	int mFirstLevelChange = 0; // index of mLevelChanges[0]
+	bool mAllLevelChangesReceived = false;
+
+	// No of level changes passed over the queue at once
+	static constexpr int mLevelChangeBatch = 256;
+
+	// No of consumed level changes to keep before the ones no longer needed are discarded
+	static constexpr int mMaxConsumedLevelChanges = 65536;
+
+	// Update the level with the next sample (Schmitt-trigger)
+	Level updateLevel(LevelInfo& levelInfo, Sample sample);
+
+	// Get the (interpolated) position of the threshold crossing for a new level
+	double transitionPos(int sampleNo, Level level);
+
+	// Extract the level changes from sample startSample and onwards (the extraction thread)
+	void extractLevelChanges(int startSample);
+
+	// Get level change levelChangeIndex (waits for the extraction thread if needed - NULL if there is no such change)
+	LevelChange* getLevelChange(int levelChangeIndex);
 	
 
 public:
 
-	LevelDecoder(int sampleFreq, Samples& samples, double startTime, double freqThreshold, double levelThreshold, Logging logging);
+	LevelDecoder(
+		int sampleFreq, Samples& samples, double startTime, double freqThreshold, double levelThreshold, Logging logging,
+		bool pipelined = false
+	);
+
+	// Stop any extraction thread
+	~LevelDecoder();
 
 	bool getNextSample(Level &level, int &sampleNo);
 
+	// Get the (interpolated) sample position where the signal crossed the threshold of
+	// the level that started with sample sampleNo
+	double getTransitionPos(int sampleNo);
+
 	Level getLevel();
 
 	bool endOfSamples();
@@ -59,6 +116,15 @@ public:
 
 	double getTime();
 
+	// Skip silence and noise up to shortly before the next possible carrier (returns false if nothing was skipped)
+	bool skipToCarrier();
+
+	// Are the level changes extracted (and thereby known in advance) by a thread of its own?
+	bool pipelined() { return mPipelined; }
+
+	// Skip the samples up to the next level change (if known without reading them) and return the no of skipped samples
+	int skipToLevelChange();
+
 	// Save the current file position
 	bool checkpoint();
 
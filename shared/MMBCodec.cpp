@@ -2,7 +2,12 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <sstream>
+#include <algorithm>
 #include "Utility.h"
+#include "DiscCodec.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
 #include <sys/stat.h> 
 
 namespace fs = std::filesystem;
@@ -38,10 +43,14 @@ namespace fs = std::filesystem;
 //
 // where NN is the no of chunks,n , encoded as '0xa0 | n'
 //
-bool MMBCodec::encode(string &discDir, string &MMBFile)
+//
+// The SSD files are read, validated and padded to the slot size in parallel and written with positioned
+// writes at their (precomputed) slot positions. The SSD files are included in file name order which makes
+// the MMB file independent of both the directory order and the no of threads. Unused slots are marked
+// as unformatted (and the MMB file ends after the last used slot).
+//
+bool MMBCodec::encode(string &discDir, string &MMBFile, int nThreads)
 {
-	vector<vector<string>> MMB_files;
-
 	// This structure would distinguish a file from a
 	// directory
 	struct stat sb;
@@ -51,51 +60,27 @@ bool MMBCodec::encode(string &discDir, string &MMBFile)
 		return false;
 	}
 
-	string fout_name = MMBFile;
-	ofstream fout(fout_name, ios::out | ios::binary | ios::ate);
-	if (!fout) {
-		cout << "can't write to file " << fout_name << "\n";
-		return false;
-	}
-
-	if (mLogging.verbose)
-		cout << "Creating MMB file '" << fout_name << "'\n";
-
-	// Count the no of valid SSD files
-	int n_MMB_chunks = 0;
-	int n_SSD_files = 0;
+	// Collect the SSD files (in file name order)
 	vector<string> SSD_files;
 	for (const auto& entry : fs::directory_iterator(discDir)) {
-
 		fs::path file_path = entry.path();
-		if (fs::is_regular_file(fs::status(file_path.c_str())) && file_path.extension() == ".ssd") {
-
-			if (n_SSD_files < 511 * 16) {
-
-				SSD_files.push_back(file_path.string());
-
-				if (n_SSD_files % 511 == 0)
-					n_MMB_chunks++;
-				n_SSD_files++;
-
-				if (n_SSD_files % 511 == 0) {
-					MMB_files.push_back(SSD_files);
-					SSD_files.clear();
-				}
-			}
-		}
+		if (fs::is_regular_file(fs::status(file_path.c_str())) && file_path.extension() == ".ssd")
+			SSD_files.push_back(file_path.string());
 	}
-	if (n_SSD_files > 0 && n_SSD_files % 511 != 0)
-		MMB_files.push_back(SSD_files);
+	sort(SSD_files.begin(), SSD_files.end());
 
-	if (n_MMB_chunks == 0) {
+	int n_SSD_files = (int) SSD_files.size();
+	if (n_SSD_files == 0) {
 		cout << "No SSD files found => quitting...\n";
+		return false;
 	}
-	else if (n_MMB_chunks > 15) {
-		cout << "Too many SSD files (" << dec << n_SSD_files << ") found. Only " << 16 * 511 <<
-			" files can fit in the max no of MMB chunks (15) => will not be able to include all SSD files!\n";
-		n_MMB_chunks = 15;
+	if (n_SSD_files > MMB_MAX_CHUNKS * MMB_SLOTS_PER_CHUNK) {
+		cout << "Too many SSD files (" << dec << n_SSD_files << ") found. Only " << MMB_MAX_CHUNKS * MMB_SLOTS_PER_CHUNK <<
+			" files can fit in the max no of MMB chunks (" << MMB_MAX_CHUNKS << ") => will not be able to include all SSD files!\n";
+		n_SSD_files = MMB_MAX_CHUNKS * MMB_SLOTS_PER_CHUNK;
+		SSD_files.resize(n_SSD_files);
 	}
+	int n_MMB_chunks = (n_SSD_files + MMB_SLOTS_PER_CHUNK - 1) / MMB_SLOTS_PER_CHUNK;
 
 	if (mLogging.verbose) {
 		if (n_MMB_chunks > 1)
@@ -104,268 +89,273 @@ bool MMBCodec::encode(string &discDir, string &MMBFile)
 			cout << dec << n_SSD_files << " SSD files found. They will be put into one standard MMB file\n";
 	}
 
-	// Write MMB chunks
-	int n_titles = 0;
-	const char *empty_title = "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
-	for (int m = 0; m < MMB_files.size(); m++) {
-
-		// Write MMB chunk header
-
-		// Write MMB signature (with status byte 0x0f <=> R/W and boot time images 0, 1, 2 & 3)
-		vector<uint8_t> signature(16, 0x0);
-		uint16_t boot_image_adr[4];
-		boot_image_adr[0] = 0x0;
-		boot_image_adr[1] = 0x1;
-		boot_image_adr[2] = 0x2;
-		boot_image_adr[3] = 0x3;
-		for (int i = 0; i < 4; i++) {
-			signature[i] = boot_image_adr[i] & 0xf;
-			signature[i + 4] = boot_image_adr[i] >> 8;
+	// Create the (empty) MMB file and open it for positioned writes
+	{
+		ofstream fout(MMBFile, ios::out | ios::binary | ios::trunc);
+		if (!fout) {
+			cout << "can't write to file " << MMBFile << "\n";
+			return false;
 		}
-		signature[8] = 0xa0 | (n_MMB_chunks-m-1);
-		for (int i = 0; i < 16; i++)
-			fout.write((char*)&signature[i], 1);
+	}
+	MappedFile MMB_file;
+	if (!MMB_file.open(MMBFile, true))
+		return false;
 
-		// Write disc titles 
-		vector<string>& SSD_files = MMB_files[m];
-		vector<string> disc_titles;
+	if (mLogging.verbose)
+		cout << "Creating MMB file '" << MMBFile << "'\n";
 
-		for (int t = 0; t < 511; t++) {
+	// Write MMB chunk headers
+	for (int m = 0; m < n_MMB_chunks; m++) {
 
-			if (t < SSD_files.size()) {
+		Bytes header(MMB_HEADER_SIZE, 0x0);
 
-				fs::path file_path = SSD_files[t];
+		// MMB signature (with boot time images 0, 1, 2 & 3)
+		uint16_t boot_image_adr[4] = { 0x0, 0x1, 0x2, 0x3 };
+		for (int i = 0; i < 4; i++) {
+			header[i] = boot_image_adr[i] & 0xf;
+			header[i + 4] = boot_image_adr[i] >> 8;
+		}
+		header[8] = 0xa0 | (n_MMB_chunks - m - 1);
+
+		// Disc titles (file name right-padded with zeroes) with status R/W - or unformatted for unused slots
+		for (int t = 0; t < MMB_SLOTS_PER_CHUNK; t++) {
+			Byte* title_entry = &header[(t + 1) * MMB_TITLE_ENTRY_SIZE];
+			int f = m * MMB_SLOTS_PER_CHUNK + t;
+			if (f < n_SSD_files) {
+				string disc_title = fs::path(SSD_files[f]).stem().string();
+				for (int i = 0; i < MMB_TITLE_LEN && i < disc_title.size(); i++)
+					title_entry[i] = (Byte) disc_title[i];
+				title_entry[MMB_TITLE_ENTRY_SIZE - 1] = MMB_RW;
+			}
+			else
+				title_entry[MMB_TITLE_ENTRY_SIZE - 1] = MMB_UNFORMATTED;
+		}
 
-				// Create disc title right-padded with zeroes
-				string disc_title = file_path.stem().string();
+		if (!MMB_file.write(m * MMB_CHUNK_SIZE, header.data(), header.size()))
+			return false;
+	}
 
-				// Pull-padded title
-				if (disc_title.size() > 12)
-					disc_title = disc_title.substr(0, 12);
-				else if (disc_title.size() < 12)
-					disc_title.insert(disc_title.size(), 12 - disc_title.size(), '\0');
-				disc_titles.push_back(disc_title);
+	// Read, validate & pad the SSD files and write them into their slots
+	vector<char> written(n_SSD_files, false);
+	vector<stringstream> logs(n_SSD_files);
+	{
+		WorkerPool pool(min(nThreads <= 0 ? WorkerPool::defaultThreads() : nThreads, n_SSD_files));
+		for (int f = 0; f < n_SSD_files; f++) {
+			pool.submit([this, f, &SSD_files, &MMB_file, &written, &logs] {
+				Bytes image;
+				string title;
+				if (!readSSDFile(SSD_files[f], image, title, logs[f]))
+					return;
+				image.resize(MMB_SLOT_SIZE, 0x0);
+				if (mLogging.verbose)
+					logs[f] << "Adding chunk #" << f / MMB_SLOTS_PER_CHUNK << ", disc #" << f % MMB_SLOTS_PER_CHUNK << " '" << title <<
+					"' content from file '" << SSD_files[f] << "'\n";
+				written[f] = MMB_file.write(MMBView::imagePos(f), image.data(), image.size());
+			});
+		}
+		pool.wait();
+	}
 
-				// Title suffix
-				disc_title = disc_title + "\x00\x00\x00\x0f"s;
+	bool success = true;
+	for (int f = 0; f < n_SSD_files; f++) {
+		cout << logs[f].str();
+		success = success && written[f];
+	}
 
-				fout.write(disc_title.c_str(), 16);
+	if (!MMB_file.sync())
+		return false;
 
-			} else
+	if (!success)
+		cout << "Failed to include all SSD files in MMB file '" << MMBFile << "'\n";
 
-				fout.write(empty_title, 16);
-		}
+	return success;
+}
 
-		// Write disc images
-		for (int t = 0; t < SSD_files.size(); t++) {
+//
+// Decode an MMB file and extract the single-density Acorn DFS 200K SSD disc images it contains
+//
+// The discs are extracted in parallel directly from the mapped MMB file with one SSD file per slot (except for the
+// unformatted slots without a disc image that end an MMB file encoded by encode). In verbose mode,
+// each disc's DFS catalogue is also parsed (to show its title and no of files). All output is made in slot order.
+//
+bool MMBCodec::decode(string& MMBFileName, string& discDir, bool catOnly, int nThreads)
+{
+	// Map the MMB file and index its disc slots
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName))
+		return false;
 
-			ifstream fin(SSD_files[t], ios::in | ios::binary | ios::ate);
+	// Unused slots without a disc image at the end of the file are expected (and not extracted)
+	int n_stored_slots = MMB_view.nStoredSlots();
 
-			if (!fin) {
-				cout << "Failed to open SSD file '" << SSD_files[t] << "' - qutting\n";
-				fout.close();
+	// Only output a catalogue
+	if (catOnly) {
+		for (int s = 0; s < MMB_view.nSlots(); s++) {
+			MMBSlot& slot = MMB_view.slot(s);
+			if (s < n_stored_slots && !slot.complete()) {
+				cout << "Premature ending of MMB file " << MMBFileName << "'s discs at chunk #" << dec << slot.chunk << " and disc # " << slot.disc << "...\n";
 				return false;
 			}
-
-			fin.seekg(0);
-
-			if (mLogging.verbose)
-				cout << "Adding chunk #" << m << ", disc #" << t << " '" << disc_titles[t] << "' content from file '" << SSD_files[t] << "'\n";
-			char c;
-			while (fin.read(&c, 1))
-				fout.put(c);
-			fin.close();
+			MMB_view.logSlot(slot);
 		}
+		return true;
+	}
 
-
+	// Extract the SSD disc images - up to (and including) the first incomplete one
+	int n_slots = 0;
+	while (n_slots < n_stored_slots && MMB_view.slot(n_slots++).complete());
+	vector<char> extracted(n_slots, false);
+	vector<stringstream> logs(n_slots);
+	{
+		WorkerPool pool(min(nThreads <= 0 ? WorkerPool::defaultThreads() : nThreads, n_slots));
+		for (int s = 0; s < n_slots; s++) {
+			pool.submit([this, s, &discDir, &MMB_view, &extracted, &logs] {
+				MMBSlot& slot = MMB_view.slot(s);
+				fs::path file_path = fs::path(discDir) / (Utility::crValidHostFileName(slot.uniqueTitle) + ".ssd");
+				extracted[s] = MMB_view.extractSlot(s, file_path.string(), logs[s]);
+				if (extracted[s] && mLogging.verbose && (slot.status == MMB_RW || slot.status == MMB_LOCKED)) {
+					Logging no_logging;
+					DiscCodec disc_codec(no_logging);
+					Disc disc;
+					if (disc_codec.read(slot.image, slot.imageSize, false, disc) && disc.side.size() > 0)
+						logs[s] << "Disc #" << dec << s << " has DFS title '" << disc.side[0].discTitle << "' and " << (int)disc.side[0].nFiles << " files\n";
+					else
+						logs[s] << "Disc #" << dec << s << " doesn't have a valid DFS catalogue\n";
+				}
+			});
+		}
+		pool.wait();
 	}
 
-	fout.close();
+	// Report (in slot order) and stop at the first slot that failed (as for a sequential extraction)
+	for (int s = 0; s < n_slots; s++) {
+		cout << logs[s].str();
+		if (!extracted[s])
+			return false;
+	}
 
 	return true;
 }
 
-// Decode an MMB file and extract the single-density Acorn DFS 200K SSD disc images it contains
-bool MMBCodec::decode(string& MMBFileName, string& discDir, bool catOnly)
+// Extract one single-density Acorn DFS 200K SSD disc image (identified by title or slot no) from an MMB file
+bool MMBCodec::extract(string& MMBFileName, string titleOrSlotNo, string SSDFileName)
 {
-	ifstream MMB_file(MMBFileName, ios::in | ios::binary | ios::ate);
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName))
+		return false;
 
-	if (!MMB_file) {
-		cout << "couldn't open MMB File '" << MMBFileName << "'\n";
+	int slot_no;
+	if (!MMB_view.findSlot(titleOrSlotNo, slot_no)) {
+		cout << "No disc '" << titleOrSlotNo << "' in MMB file '" << MMBFileName << "'\n";
 		return false;
 	}
 
-	// Get file size
-	MMB_file.seekg(0, ios::end);
-	streamsize file_sz = MMB_file.tellg();
-	MMB_file.seekg(0);
+	string SSD_file_name = SSDFileName;
+	if (SSD_file_name == "")
+		SSD_file_name = Utility::crValidHostFileName(MMB_view.slot(slot_no).uniqueTitle) + ".ssd";
 
-	if (mLogging.verbose)
-		cout << "Decode file '" << MMBFileName << "' of size " << dec << file_sz << "\n";
+	return MMB_view.extractSlot(slot_no, SSD_file_name);
+}
 
-	// Read header
-	char header[16];
-	if (!MMB_file.read(&header[0], 16)) {
-		cout << "File '" << MMBFileName << "' is not a valid MMB file!\n";
-		MMB_file.close();
+// Read an SSD disc image (and create an MMB disc title from its file name)
+bool MMBCodec::readSSDFile(string& SSDFileName, Bytes& image, string& title, ostream& log)
+{
+	ifstream fin(SSDFileName, ios::in | ios::binary | ios::ate);
+	if (!fin) {
+		log << "Failed to open SSD file '" << SSDFileName << "'\n";
 		return false;
 	}
-
-	uint16_t boot_image_0 = header[0] | (header[4] << 8);
-	uint16_t boot_image_1 = header[1] | (header[5] << 8);
-	uint16_t boot_image_2 = header[2] | (header[6] << 8);
-	uint16_t boot_image_3 = header[3] | (header[7] << 8);
-	uint8_t MMB_ext = header[8];
-	uint8_t MMB_chunks = 1;
-	if ((MMB_ext & 0xa0) == 0xa0) {
-		MMB_chunks = (MMB_ext & 0xf) + 1;
+	streamsize file_sz = fin.tellg();
+	if (file_sz > MMB_SLOT_SIZE) {
+		log << "SSD file '" << SSDFileName << "' is too large (" << dec << file_sz << " bytes) to fit in an MMB slot!\n";
+		return false;
 	}
-
-	uint16_t boot_image[4];
-	for (int i = 0; i < 4; i++)
-		boot_image[i] = header[i] | (header[i + 4] << 8);
-
-	if (mLogging.verbose) {
-		if (MMB_chunks > 1)
-			cout << "MMB is an extended MMB with " << (int)MMB_chunks << " MMB chunks...\n";
-		else
-			cout << "MMB is a standard MMB\n";
-		cout << "Boot time images are: ";
-		for (int i = 0; i < 4; i++)
-			cout << hex << "0x" << setw(4) << setfill('0') << boot_image[i] << " ";
-		cout << "\n";
+	fin.seekg(0);
+	image.resize(file_sz);
+	if (file_sz > 0 && !fin.read((char*)image.data(), file_sz)) {
+		log << "Failed to read SSD file '" << SSDFileName << "'\n";
+		return false;
 	}
 
-	int null_title_index = 0;
-	map<string, string> titles_m;
-	for (int chunk = 0; chunk < MMB_chunks; chunk++) {
-
-		if (chunk > 0) {
+	// Disc title is the file name (without extension) truncated to 12 characters (as when encoding an MMB file)
+	title = fs::path(SSDFileName).stem().string();
+	if (title.size() > MMB_TITLE_LEN)
+		title = title.substr(0, MMB_TITLE_LEN);
 
-			// Read header (not for the first chunk as that one was already read earlier)
-			char header[16];
-			if (!MMB_file.read(&header[0], 16)) {
-				cout << "Header missing for the " << dec << chunk << " chunk!\n";
-				MMB_file.close();
-				return false;
-			}
-		}
+	return true;
+}
 
-		// Read disc titles
-		vector<string> titles;
-		vector<string> access;
-		for (int i = 0; i < 511; i++) {
-			char title_a[16];
-			if (!MMB_file.read(&title_a[0], 16)) {
-				cout << "Premature ending of MMB file '" << MMBFileName << "''s disc titles\n";
-				MMB_file.close();
-				return false;
-			}
-			string title = title_a;
-			while (title.size() > 0 && title[title.size() - 1] == ' ')
-				title = title.substr(0, title.size() - 1);
-			string title_suffix;
-			for (int j = 12; j < 16; title_suffix += title_a[j++]);
-
-			// If the title is empty, then generate a unique title NULL_<no>
-			if (title == "") {
-				title += "NULL_" + to_string(null_title_index++);
-				cout << "Warning - a 'null' disc title encountered. A unique disc title '" << title << "' is created to make further processing possible...\n";
-			}
+// Replace a disc (identified by title or slot no) with an SSD disc image
+bool MMBCodec::replaceDisc(string& MMBFileName, string titleOrSlotNo, string& SSDFileName)
+{
+	Bytes image;
+	string title;
+	if (!readSSDFile(SSDFileName, image, title, cout))
+		return false;
 
-			// Store title and access status (locked, unformatted, invalid or ???)
-			int n = 0;
-			string t = title;
-			while (titles_m.find(title) != titles_m.end() && n < 1000) {
-				n++; // ensure first title will have index 1 (as there is already an identical title without an index)
-				string n_s = to_string(n);
-				int num_pos = 12 - n_s.size();
-				if (t.size() < 12)
-					num_pos = t.size() + 1 - n_s.size();
-				title = t.substr(0, num_pos) + n_s;
-			}
-			if (n >= 1000) {
-				cout << "Failed to create a unique disc title from title '" << t << "'!\n";
-				return false;
-			}
-			if (n > 0) {
-				cout << "Warning - a non-unique disc title '" << t << "' encountered. A unique title '" << title << "' will replace it to make further processing possible...\n";
-			}
-			titles_m[title] = title;
-			titles.push_back(title);
-			access.push_back(_TITLE_ACCESS(title_suffix[3]));
-
-			if (mLogging.verbose) {
-				if (MMB_chunks > 1)
-					cout << "MMB #" << dec << chunk << ", disk #" << i << " title '" << title << "' with status " << _TITLE_ACCESS(title_suffix[3]) << "\n";
-				else
-					cout << "Disk #" << dec << i << " title '" << title << "' with status " << _TITLE_ACCESS(title_suffix[3]) << "\n";
-			}
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName, true))
+		return false;
 
-		}
+	int slot_no;
+	if (!MMB_view.findSlot(titleOrSlotNo, slot_no)) {
+		cout << "No disc '" << titleOrSlotNo << "' in MMB file '" << MMBFileName << "'\n";
+		return false;
+	}
 
-		// Read SSD disc images (if not only a catalogue shall be output)
+	return MMB_view.replaceSlot(slot_no, image, title);
+}
 
-		for (int i = 0; i < titles.size(); i++) {
-			string& title = titles[i];
-			string& acc = access[i];
+// Add an SSD disc image in the first unformatted slot
+bool MMBCodec::addDisc(string& MMBFileName, string& SSDFileName)
+{
+	Bytes image;
+	string title;
+	if (!readSSDFile(SSDFileName, image, title, cout))
+		return false;
 
-			if (!catOnly) {
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName, true))
+		return false;
 
-				// Create SSD file
-				fs::path dir_path = discDir;
-				fs::path file_path = dir_path / (Utility::crValidHostFileName(title) + ".ssd");
-				string fout_name = file_path.string();
-				ofstream fout(fout_name, ios::out | ios::binary);
-				if (!fout) {
-					cout << "can't write to file " << fout_name << "\n";
-					return false;
-				}
+	int slot_no;
+	if (!MMB_view.addSlot(image, title, slot_no))
+		return false;
 
-				if (mLogging.verbose) {
-					cout << "Creating SSD file #" << dec << i << " '" << fout_name << " for disc title '" << title << "' (" << title.size() << ")\n";
-				}
+	if (mLogging.verbose)
+		cout << "Disc '" << title << "' added as disc #" << dec << slot_no << "\n";
 
-				// Fill the SSD file with content from the MMB file
-				for (int b = 0; b < 200 * 1024; b++) {
-					char c;
-					if (!MMB_file.read(&c, 1) || !fout.write(&c, 1)) {
-						cout << "Premature ending of MMB file " << MMBFileName << "'s discs at chunk #" << dec << chunk << " and disc # " << i <<
-							" will quit and the last SDD disc file '" << fout_name << "' will be empty...\n";
-						MMB_file.close();
-						fout.close();
-						return false;
-					}
-				}
-			}
+	return true;
+}
 
-			else {
+// Lock or unlock a disc (identified by title or slot no)
+bool MMBCodec::lockDisc(string& MMBFileName, string titleOrSlotNo, bool lock)
+{
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName, true))
+		return false;
 
-				for (int b = 0; b < 200 * 1024; b++) {
-					char c;
-					if (!MMB_file.read(&c, 1)) {
-						cout << "Premature ending of MMB file " << MMBFileName << "'s discs at chunk #" << dec << chunk << " and disc # " << i << "...\n";
-						MMB_file.close();
-						return false;
-					}
-				}
-				if (MMB_chunks > 1)
-					cout << setw(2) << dec << chunk << " " << setw(3) << i << " " << setw(12) << setfill(' ') << title << " " << acc << "\n";
-				else
-					cout << dec << setw(3) << i << " " << setw(12) << title << " " << acc << "\n";
-			}
+	int slot_no;
+	if (!MMB_view.findSlot(titleOrSlotNo, slot_no)) {
+		cout << "No disc '" << titleOrSlotNo << "' in MMB file '" << MMBFileName << "'\n";
+		return false;
+	}
 
-		}
+	return MMB_view.lockSlot(slot_no, lock);
+}
 
-		if (mLogging.verbose) {
-			cout << "MMB file pos after read disc is: 0x" << hex << MMB_file.tellg() << "\n";
-		}
+// Blank a disc (identified by title or slot no)
+bool MMBCodec::blankDisc(string& MMBFileName, string titleOrSlotNo)
+{
+	MMBView MMB_view(mLogging);
+	if (!MMB_view.open(MMBFileName, true))
+		return false;
 
+	int slot_no;
+	if (!MMB_view.findSlot(titleOrSlotNo, slot_no)) {
+		cout << "No disc '" << titleOrSlotNo << "' in MMB file '" << MMBFileName << "'\n";
+		return false;
 	}
 
-
-	
-	MMB_file.close();
-
-	return true;
+	return MMB_view.blankSlot(slot_no);
 }
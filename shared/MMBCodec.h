@@ -2,7 +2,9 @@
 #define MMB_CODEC_H
 
 #include <string>
+#include <ostream>
 #include "Logging.h"
+#include "MMBView.h"
 
 
 using namespace std;
@@ -11,18 +13,38 @@ class MMBCodec
 {
 	Logging mLogging;
 
-	enum TitleAccessEnum {MMB_LOCKED = 0x00, MMB_RW = 0x0f, MMB_UNFORMATTED = 0xf0, MMB_INVALID = 0xff};
-#define _TITLE_ACCESS(x) (x==MMB_LOCKED?"Locked":(x==MMB_RW?"R/W":(x==MMB_UNFORMATTED?"Unformatted":(x==MMB_INVALID?"Invalid":"???"))))
+	// Read an SSD disc image (and create an MMB disc title from its file name)
+	bool readSSDFile(string& SSDFileName, Bytes& image, string& title, ostream& log);
 
 public:
 
 	MMBCodec(Logging logging) : mLogging(logging) {};
 
-	// Encode single-density Acorn DFS 200K SSD disc images as an MMB file
-	bool encode(string& discDir, string& MMBFileName);
+	// Encode single-density Acorn DFS 200K SSD disc images as an MMB file using nThreads threads (nThreads <= 0 <=> all cores)
+	bool encode(string& discDir, string& MMBFileName, int nThreads = 0);
 
 	// Decode an MMB file and extract the single-density Acorn DFS 200K SSD disc images it contains
-	bool decode(string& MMBFileName, string& discDir, bool catOnly);
+	// using nThreads threads (nThreads <= 0 <=> all cores)
+	bool decode(string& MMBFileName, string& discDir, bool catOnly, int nThreads = 0);
+
+	// Extract one single-density Acorn DFS 200K SSD disc image (identified by title or slot no) from an MMB file
+	bool extract(string& MMBFileName, string titleOrSlotNo, string SSDFileName);
+
+	//
+	// In-place update of a single disc slot of an MMB file (see MMBView for the crash-safe write ordering)
+	//
+
+	// Replace a disc (identified by title or slot no) with an SSD disc image
+	bool replaceDisc(string& MMBFileName, string titleOrSlotNo, string& SSDFileName);
+
+	// Add an SSD disc image in the first unformatted slot
+	bool addDisc(string& MMBFileName, string& SSDFileName);
+
+	// Lock or unlock a disc (identified by title or slot no)
+	bool lockDisc(string& MMBFileName, string titleOrSlotNo, bool lock);
+
+	// Blank a disc (identified by title or slot no)
+	bool blankDisc(string& MMBFileName, string titleOrSlotNo);
 
 
 };
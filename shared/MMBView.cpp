@@ -0,0 +1,403 @@
+#include "MMBView.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+// Map an MMB file (for update if forUpdate is true) and index its disc slots
+bool MMBView::open(string MMBFileName, bool forUpdate)
+{
+	close();
+
+	mFileName = MMBFileName;
+	mForUpdate = forUpdate;
+
+	if (!mFile.open(MMBFileName, forUpdate)) {
+		cout << "couldn't open MMB File '" << MMBFileName << "'\n";
+		return false;
+	}
+
+	if (mLogging.verbose)
+		cout << "Decode file '" << MMBFileName << "' of size " << dec << mFile.size() << "\n";
+
+	// Read header
+	if (mFile.size() < MMB_TITLE_ENTRY_SIZE) {
+		cout << "File '" << MMBFileName << "' is not a valid MMB file!\n";
+		close();
+		return false;
+	}
+	const Byte* header = mFile.data();
+	for (int i = 0; i < 4; i++)
+		mBootImage[i] = header[i] | (header[i + 4] << 8);
+	Byte MMB_ext = header[8];
+	mChunks = 1;
+	if ((MMB_ext & 0xa0) == 0xa0)
+		mChunks = (MMB_ext & 0xf) + 1;
+
+	if (mLogging.verbose) {
+		if (mChunks > 1)
+			cout << "MMB is an extended MMB with " << mChunks << " MMB chunks...\n";
+		else
+			cout << "MMB is a standard MMB\n";
+		cout << "Boot time images are: ";
+		for (int i = 0; i < 4; i++)
+			cout << hex << "0x" << setw(4) << setfill('0') << mBootImage[i] << " ";
+		cout << setfill(' ') << "\n";
+	}
+
+	// Index the disc slots of all chunks
+	mSlots.reserve(mChunks * MMB_SLOTS_PER_CHUNK);
+	for (int chunk = 0; chunk < mChunks; chunk++) {
+		if (!indexChunk(chunk)) {
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t MMBView::titleEntryPos(int slotNo)
+{
+	int chunk = slotNo / MMB_SLOTS_PER_CHUNK;
+	int disc = slotNo % MMB_SLOTS_PER_CHUNK;
+	return chunk * MMB_CHUNK_SIZE + (size_t) (disc + 1) * MMB_TITLE_ENTRY_SIZE;
+}
+
+size_t MMBView::imagePos(int slotNo)
+{
+	int chunk = slotNo / MMB_SLOTS_PER_CHUNK;
+	int disc = slotNo % MMB_SLOTS_PER_CHUNK;
+	return chunk * MMB_CHUNK_SIZE + MMB_HEADER_SIZE + (size_t) disc * MMB_SLOT_SIZE;
+}
+
+//
+// No of slots excluding the unused slots at the end of the file that have no disc image.
+//
+// An unused slot is either marked as unformatted or, as written by earlier versions of mmbutil,
+// has an empty title (and status 0x00) and a disc image that lies entirely beyond the end of the file.
+//
+int MMBView::nStoredSlots()
+{
+	int n = (int) mSlots.size();
+	for (; n > 0 && !mSlots[n - 1].complete(); n--) {
+		MMBSlot& slot = mSlots[n - 1];
+		if (slot.status != MMB_UNFORMATTED && (slot.title != "" || slot.imageSize > 0))
+			break;
+	}
+	return n;
+}
+
+// Point a slot's disc image into the mapped file (possibly incomplete if the file ends prematurely)
+void MMBView::mapSlotImage(MMBSlot& slot)
+{
+	size_t image_pos = imagePos(slot.no);
+	if (image_pos < mFile.size()) {
+		slot.image = mFile.data() + image_pos;
+		slot.imageSize = min((size_t)MMB_SLOT_SIZE, mFile.size() - image_pos);
+	}
+	else {
+		slot.image = NULL;
+		slot.imageSize = 0;
+	}
+}
+
+//
+// Make a slot's title unique within the MMB file
+//
+// Empty and duplicated titles are replaced by unique titles so that each disc
+// can be identified (and extracted into a file of its own) by its title.
+//
+bool MMBView::crUniqueTitle(MMBSlot& slot, string& uniqueTitle)
+{
+	// If the title is empty, then generate a unique title NULL_<no>
+	// (only unexpected for a formatted disc that is stored in the file)
+	string title = slot.title;
+	if (title == "") {
+		title += "NULL_" + to_string(mNullTitles++);
+		if (slot.status != MMB_UNFORMATTED && slot.imageSize > 0)
+			cout << "Warning - a 'null' disc title encountered. A unique disc title '" << title << "' is created to make further processing possible...\n";
+	}
+
+	// Make the title unique (by replacing its ending with a number)
+	int n = 0;
+	string t = title;
+	while (mTitleIndex.find(title) != mTitleIndex.end() && n < 1000) {
+		n++; // ensure first title will have index 1 (as there is already an identical title without an index)
+		string n_s = to_string(n);
+		int num_pos = MMB_TITLE_LEN - (int)n_s.size();
+		if (t.size() < MMB_TITLE_LEN)
+			num_pos = (int)t.size() + 1 - (int)n_s.size();
+		title = t.substr(0, num_pos) + n_s;
+	}
+	if (n >= 1000) {
+		cout << "Failed to create a unique disc title from title '" << t << "'!\n";
+		return false;
+	}
+	if (n > 0) {
+		cout << "Warning - a non-unique disc title '" << t << "' encountered. A unique title '" << title << "' will replace it to make further processing possible...\n";
+	}
+
+	uniqueTitle = title;
+
+	return true;
+}
+
+//
+// Index the disc slots of one MMB chunk from its title table
+//
+bool MMBView::indexChunk(int chunk)
+{
+	size_t chunk_pos = chunk * MMB_CHUNK_SIZE;
+
+	if (chunk_pos + MMB_TITLE_ENTRY_SIZE > mFile.size()) {
+		cout << "Header missing for the " << dec << chunk << " chunk!\n";
+		return false;
+	}
+	if (chunk_pos + MMB_HEADER_SIZE > mFile.size()) {
+		cout << "Premature ending of MMB file '" << mFileName << "''s disc titles\n";
+		return false;
+	}
+
+	for (int i = 0; i < MMB_SLOTS_PER_CHUNK; i++) {
+
+		MMBSlot slot;
+		slot.no = chunk * MMB_SLOTS_PER_CHUNK + i;
+		slot.chunk = chunk;
+		slot.disc = i;
+
+		const Byte* title_entry = mFile.data() + titleEntryPos(slot.no);
+		slot.status = title_entry[MMB_TITLE_ENTRY_SIZE - 1];
+		for (int j = 0; j < MMB_TITLE_LEN && title_entry[j] != 0; j++)
+			slot.title += (char) title_entry[j];
+		while (slot.title.size() > 0 && slot.title[slot.title.size() - 1] == ' ')
+			slot.title = slot.title.substr(0, slot.title.size() - 1);
+
+		mapSlotImage(slot);
+
+		if (!crUniqueTitle(slot, slot.uniqueTitle))
+			return false;
+		mTitleIndex[slot.uniqueTitle] = slot.no;
+
+		if (mLogging.verbose) {
+			if (mChunks > 1)
+				cout << "MMB #" << dec << chunk << ", disk #" << i << " title '" << slot.uniqueTitle << "' with status " << _TITLE_ACCESS(slot.status) << "\n";
+			else
+				cout << "Disk #" << dec << i << " title '" << slot.uniqueTitle << "' with status " << _TITLE_ACCESS(slot.status) << "\n";
+		}
+
+		mSlots.push_back(slot);
+	}
+
+	return true;
+}
+
+void MMBView::close()
+{
+	mFile.close();
+	mSlots.clear();
+	mTitleIndex.clear();
+	mNullTitles = 0;
+	mChunks = 0;
+}
+
+// Find a slot from its (unique) disc title or slot no
+bool MMBView::findSlot(string titleOrSlotNo, int& slotNo)
+{
+	auto it = mTitleIndex.find(titleOrSlotNo);
+	if (it != mTitleIndex.end()) {
+		slotNo = it->second;
+		return true;
+	}
+
+	// Not a title - try it as a slot no
+	if (titleOrSlotNo.size() > 0 && titleOrSlotNo.size() < 6 && titleOrSlotNo.find_first_not_of("0123456789") == string::npos) {
+		int no = stoi(titleOrSlotNo);
+		if (no < mSlots.size()) {
+			slotNo = no;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Write the disc image of a slot to an SSD file
+bool MMBView::extractSlot(int slotNo, string SSDFileName, ostream& log)
+{
+	MMBSlot& slot = mSlots[slotNo];
+
+	ofstream fout(SSDFileName, ios::out | ios::binary);
+	if (!fout) {
+		log << "can't write to file " << SSDFileName << "\n";
+		return false;
+	}
+
+	if (mLogging.verbose)
+		log << "Creating SSD file #" << dec << slot.disc << " '" << SSDFileName << " for disc title '" << slot.uniqueTitle << "' (" << slot.uniqueTitle.size() << ")\n";
+
+	// Write the disc image directly from the mapped MMB file
+	if (slot.imageSize > 0 && !fout.write((const char*) slot.image, slot.imageSize)) {
+		log << "Failed to write to file " << SSDFileName << "\n";
+		return false;
+	}
+
+	if (!slot.complete()) {
+		log << "Premature ending of MMB file " << mFileName << "'s discs at chunk #" << dec << slot.chunk << " and disc # " << slot.disc <<
+			" will quit and the last SDD disc file '" << SSDFileName << "' will be incomplete...\n";
+		return false;
+	}
+
+	return true;
+}
+
+// Output a catalogue line for a slot
+void MMBView::logSlot(MMBSlot& slot)
+{
+	if (mChunks > 1)
+		cout << setw(2) << dec << slot.chunk << " " << setw(3) << slot.disc << " " << setw(12) << setfill(' ') << slot.uniqueTitle << " " << _TITLE_ACCESS(slot.status) << "\n";
+	else
+		cout << dec << setw(3) << slot.disc << " " << setw(12) << slot.uniqueTitle << " " << _TITLE_ACCESS(slot.status) << "\n";
+}
+
+// Write a slot's title entry (title and status)
+bool MMBView::writeTitleEntry(int slotNo, string title, Byte status)
+{
+	Byte entry[MMB_TITLE_ENTRY_SIZE] = { 0 };
+	for (int i = 0; i < MMB_TITLE_LEN && i < title.size(); i++)
+		entry[i] = (Byte) title[i];
+	entry[MMB_TITLE_ENTRY_SIZE - 1] = status;
+
+	return mFile.write(titleEntryPos(slotNo), entry, MMB_TITLE_ENTRY_SIZE) && mFile.sync();
+}
+
+// Write a slot's status (only)
+bool MMBView::writeStatus(int slotNo, Byte status)
+{
+	return mFile.write(titleEntryPos(slotNo) + MMB_TITLE_ENTRY_SIZE - 1, &status, 1) && mFile.sync();
+}
+
+// Write a slot's disc image (padded with zeroes to the slot size)
+bool MMBView::writeImage(int slotNo, const Bytes& image)
+{
+	if (image.size() > MMB_SLOT_SIZE) {
+		cout << "Disc image of " << dec << image.size() << " bytes is too large for an MMB slot (max " << MMB_SLOT_SIZE << " bytes)!\n";
+		return false;
+	}
+
+	Bytes padding(MMB_SLOT_SIZE - image.size(), 0);
+	size_t pos = imagePos(slotNo);
+	if (
+		(image.size() > 0 && !mFile.write(pos, image.data(), image.size())) ||
+		(padding.size() > 0 && !mFile.write(pos + image.size(), padding.data(), padding.size())) ||
+		!mFile.sync()
+	)
+		return false;
+
+	// If the file was extended, the mapping (and all slot images pointing into it) must be updated
+	if (pos + MMB_SLOT_SIZE > mFile.size()) {
+		if (!mFile.remap())
+			return false;
+		for (int s = 0; s < mSlots.size(); s++)
+			mapSlotImage(mSlots[s]);
+	}
+
+	return true;
+}
+
+// Update the index for a slot with a new title and status
+bool MMBView::updateIndex(int slotNo, string title, Byte status)
+{
+	MMBSlot& slot = mSlots[slotNo];
+
+	mTitleIndex.erase(slot.uniqueTitle);
+	slot.title = title.substr(0, min((size_t) MMB_TITLE_LEN, title.size()));
+	slot.status = status;
+	if (!crUniqueTitle(slot, slot.uniqueTitle))
+		return false;
+	mTitleIndex[slot.uniqueTitle] = slotNo;
+
+	return true;
+}
+
+// Replace the disc image and title of a (not locked) slot
+bool MMBView::replaceSlot(int slotNo, const Bytes& SSDImage, string title)
+{
+	MMBSlot& slot = mSlots[slotNo];
+
+	if (!mForUpdate || slot.status == MMB_LOCKED) {
+		cout << "Disc #" << dec << slotNo << " '" << slot.uniqueTitle << "' can't be replaced as it is " << (mForUpdate ? "locked" : "read-only") << "!\n";
+		return false;
+	}
+
+	if (mLogging.verbose)
+		cout << "Replacing disc #" << dec << slotNo << " '" << slot.uniqueTitle << "' with disc '" << title << "'\n";
+
+	// Invalidate the slot while its disc image is being written
+	if (!writeStatus(slotNo, MMB_INVALID) || !writeImage(slotNo, SSDImage) || !writeTitleEntry(slotNo, title, MMB_RW))
+		return false;
+
+	return updateIndex(slotNo, title, MMB_RW);
+}
+
+// Add a disc image and title to the first unformatted slot
+bool MMBView::addSlot(const Bytes& SSDImage, string title, int& slotNo)
+{
+	int s = 0;
+	for (; s < mSlots.size() && mSlots[s].status != MMB_UNFORMATTED; s++);
+	if (!mForUpdate || s == mSlots.size()) {
+		cout << "Disc '" << title << "' can't be added as " << (mForUpdate ? "there is no unformatted slot left" : "the MMB file is read-only") << "!\n";
+		return false;
+	}
+	slotNo = s;
+
+	if (mLogging.verbose)
+		cout << "Adding disc '" << title << "' as disc #" << dec << slotNo << "\n";
+
+	// The slot remains unformatted until its disc image has been written
+	if (!writeImage(slotNo, SSDImage) || !writeTitleEntry(slotNo, title, MMB_RW))
+		return false;
+
+	return updateIndex(slotNo, title, MMB_RW);
+}
+
+// Lock or unlock a slot
+bool MMBView::lockSlot(int slotNo, bool lock)
+{
+	MMBSlot& slot = mSlots[slotNo];
+
+	if (!mForUpdate || slot.status == MMB_UNFORMATTED || slot.status == MMB_INVALID) {
+		cout << "Disc #" << dec << slotNo << " '" << slot.uniqueTitle << "' can't be " << (lock ? "locked" : "unlocked") << " as it is " <<
+			(mForUpdate ? _TITLE_ACCESS(slot.status) : "read-only") << "!\n";
+		return false;
+	}
+
+	Byte status = (lock ? MMB_LOCKED : MMB_RW);
+	if (!writeStatus(slotNo, status))
+		return false;
+	slot.status = status;
+
+	return true;
+}
+
+// Clear the disc image and title of a (not locked) slot and mark it as unformatted
+bool MMBView::blankSlot(int slotNo)
+{
+	MMBSlot& slot = mSlots[slotNo];
+
+	if (!mForUpdate || slot.status == MMB_LOCKED) {
+		cout << "Disc #" << dec << slotNo << " '" << slot.uniqueTitle << "' can't be blanked as it is " << (mForUpdate ? "locked" : "read-only") << "!\n";
+		return false;
+	}
+
+	if (mLogging.verbose)
+		cout << "Blanking disc #" << dec << slotNo << " '" << slot.uniqueTitle << "'\n";
+
+	// Release the slot before clearing its disc image
+	Bytes no_image;
+	if (!writeTitleEntry(slotNo, "", MMB_UNFORMATTED) || !writeImage(slotNo, no_image))
+		return false;
+
+	return updateIndex(slotNo, "", MMB_UNFORMATTED);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#ifndef MMB_VIEW_H
+#define MMB_VIEW_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "CommonTypes.h"
+#include "MappedFile.h"
+#include "Logging.h"
+
+using namespace std;
+
+// MMB disc title status
+enum TitleAccessEnum { MMB_LOCKED = 0x00, MMB_RW = 0x0f, MMB_UNFORMATTED = 0xf0, MMB_INVALID = 0xff };
+#define _TITLE_ACCESS(x) (x==MMB_LOCKED?"Locked":(x==MMB_RW?"R/W":(x==MMB_UNFORMATTED?"Unformatted":(x==MMB_INVALID?"Invalid":"???"))))
+
+// MMB layout (see MMBCodec.cpp for a description of the format)
+#define MMB_SLOTS_PER_CHUNK 511
+#define MMB_MAX_CHUNKS 16
+#define MMB_TITLE_ENTRY_SIZE 16
+#define MMB_TITLE_LEN 12
+#define MMB_HEADER_SIZE ((MMB_SLOTS_PER_CHUNK + 1) * MMB_TITLE_ENTRY_SIZE)
+#define MMB_SLOT_SIZE (200 * 1024)
+#define MMB_CHUNK_SIZE ((size_t) MMB_HEADER_SIZE + (size_t) MMB_SLOTS_PER_CHUNK * MMB_SLOT_SIZE)
+
+//
+// One disc slot of an MMB file
+//
+class MMBSlot {
+public:
+	int no = 0; // slot no in the MMB file (chunk * 511 + disc)
+	int chunk = 0; // MMB chunk the slot belongs to
+	int disc = 0; // disc no within the chunk
+	string title; // disc title as stored in the MMB file (trailing spaces removed)
+	string uniqueTitle; // non-empty title unique within the MMB file (used to identify and extract the disc)
+	Byte status = MMB_INVALID; // title status (TitleAccessEnum)
+	const Byte* image = NULL; // SSD disc image (pointing into the mapped MMB file - not a copy)
+	size_t imageSize = 0; // less than MMB_SLOT_SIZE if the MMB file ends prematurely
+
+	bool complete() { return imageSize == MMB_SLOT_SIZE; }
+};
+
+//
+// Memory-mapped view of an MMB (or extended MMB) file.
+//
+// The file is mapped once and an index of all disc slots (titles, status and disc image location) is
+// built from the title tables of the MMB chunks. Each slot's disc image is then accessible as a
+// zero-copy SSD image (MMBSlot::image) without unpacking the MMB file. Only the pages actually accessed
+// are read from disc which makes catalogue listing and extraction of single discs cheap also for
+// multi-hundred MB extended MMB files.
+//
+// An MMB file opened for update can have single slots replaced, added, locked/unlocked or blanked
+// with positioned writes of only the affected disc image and title entry. The writes are ordered
+// (and synced to disc in between) so that a crash never leaves a title entry marking a partially
+// written disc image as valid:
+//
+//	replace:	status set to invalid => disc image written => title & status (R/W) written
+//	add:		disc image written to an unformatted slot => title & status (R/W) written
+//	blank:		title cleared & status set to unformatted => disc image cleared
+//	lock/unlock:	status written
+//
+class MMBView
+{
+
+private:
+
+	Logging mLogging;
+
+	MappedFile mFile;
+
+	string mFileName;
+
+	int mChunks = 0;
+
+	Word mBootImage[4] = { 0, 1, 2, 3 };
+
+	vector<MMBSlot> mSlots;
+
+	map<string, int> mTitleIndex; // unique title => slot no
+
+	int mNullTitles = 0; // no of generated titles for discs without a title
+
+	bool mForUpdate = false;
+
+	bool indexChunk(int chunk);
+
+	// Make a title unique within the MMB file (and non-empty)
+	bool crUniqueTitle(MMBSlot& slot, string& uniqueTitle);
+
+	// Point a slot's disc image into the mapped file
+	void mapSlotImage(MMBSlot& slot);
+
+
+	// Write a slot's title entry (title and status)
+	bool writeTitleEntry(int slotNo, string title, Byte status);
+
+	// Write a slot's status (only)
+	bool writeStatus(int slotNo, Byte status);
+
+	// Write a slot's disc image (padded with zeroes to the slot size)
+	bool writeImage(int slotNo, const Bytes& image);
+
+	// Update the index for a slot with a new title and status
+	bool updateIndex(int slotNo, string title, Byte status);
+
+public:
+
+	MMBView(Logging logging) : mLogging(logging) {}
+
+	// Map an MMB file (for update if forUpdate is true) and index its disc slots
+	bool open(string MMBFileName, bool forUpdate = false);
+
+	void close();
+
+	int nChunks() { return mChunks; }
+
+	int nSlots() { return (int) mSlots.size(); }
+
+	// No of slots excluding the unused slots at the end of the file that have no disc image
+	// (an MMB file is encoded without the disc images of its trailing unused slots)
+	int nStoredSlots();
+
+	vector<MMBSlot>& slots() { return mSlots; }
+
+	MMBSlot& slot(int slotNo) { return mSlots[slotNo]; }
+
+	// Disc image to put in drive 0-3 at boot time
+	Word bootImage(int drive) { return mBootImage[drive]; }
+
+	// Find a slot from its (unique) disc title or slot no
+	bool findSlot(string titleOrSlotNo, int& slotNo);
+
+	// Write the disc image of a slot to an SSD file (with any messages to log)
+	bool extractSlot(int slotNo, string SSDFileName, ostream& log = cout);
+
+	// Position of a slot's title entry/disc image in an MMB file
+	static size_t titleEntryPos(int slotNo);
+	static size_t imagePos(int slotNo);
+
+	// Output a catalogue line for a slot
+	void logSlot(MMBSlot& slot);
+
+	// Replace the disc image and title of a (not locked) slot
+	bool replaceSlot(int slotNo, const Bytes& SSDImage, string title);
+
+	// Add a disc image and title to the first unformatted slot
+	bool addSlot(const Bytes& SSDImage, string title, int& slotNo);
+
+	// Lock or unlock a slot
+	bool lockSlot(int slotNo, bool lock);
+
+	// Clear the disc image and title of a (not locked) slot and mark it as unformatted
+	bool blankSlot(int slotNo);
+
+};
+
+#endif
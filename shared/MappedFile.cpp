@@ -0,0 +1,237 @@
+#include "MappedFile.h"
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::isOpen()
+{
+#ifdef _WIN32
+	return mFileHandle != NULL;
+#else
+	return mFd >= 0;
+#endif
+}
+
+// Map the file again (to include any data written beyond the previous end of the file)
+bool MappedFile::remap()
+{
+	if (!isOpen())
+		return false;
+
+	unmap();
+	if (!map()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(string fileName, bool writable)
+{
+	close();
+
+	mFileName = fileName;
+
+	DWORD access = GENERIC_READ | (writable ? GENERIC_WRITE : 0);
+	HANDLE file_handle = CreateFileA(
+		fileName.c_str(), access, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+	);
+	if (file_handle == INVALID_HANDLE_VALUE) {
+		cout << "couldn't open file '" << fileName << "'\n";
+		return false;
+	}
+	mFileHandle = file_handle;
+
+	if (!map()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MappedFile::map()
+{
+	LARGE_INTEGER file_sz;
+	if (!GetFileSizeEx((HANDLE) mFileHandle, &file_sz)) {
+		cout << "couldn't get the size of file '" << mFileName << "'\n";
+		return false;
+	}
+	mSize = (size_t) file_sz.QuadPart;
+
+	// An empty file can't be mapped
+	if (mSize == 0)
+		return true;
+
+	HANDLE mapping_handle = CreateFileMappingA((HANDLE) mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_handle == NULL) {
+		cout << "couldn't map file '" << mFileName << "'\n";
+		return false;
+	}
+	mMappingHandle = mapping_handle;
+
+	mData = (const Byte*) MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (mData == NULL) {
+		cout << "couldn't map file '" << mFileName << "'\n";
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (mData != NULL)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != NULL)
+		CloseHandle((HANDLE) mMappingHandle);
+	mData = NULL;
+	mMappingHandle = NULL;
+	mSize = 0;
+}
+
+void MappedFile::close()
+{
+	unmap();
+	if (mFileHandle != NULL)
+		CloseHandle((HANDLE) mFileHandle);
+	mFileHandle = NULL;
+}
+
+bool MappedFile::write(size_t pos, const Byte* data, size_t n)
+{
+	while (n > 0) {
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD) (pos & 0xffffffff);
+		overlapped.OffsetHigh = (DWORD) ((unsigned long long) pos >> 32);
+		DWORD n_written = 0;
+		DWORD n_chunk = (DWORD) min(n, (size_t) 0x40000000);
+		if (!WriteFile((HANDLE) mFileHandle, data, n_chunk, &n_written, &overlapped) || n_written == 0) {
+			cout << "Failed to write to file '" << mFileName << "'\n";
+			return false;
+		}
+		pos += n_written;
+		data += n_written;
+		n -= n_written;
+	}
+
+	return true;
+}
+
+bool MappedFile::sync()
+{
+	if (!FlushFileBuffers((HANDLE) mFileHandle)) {
+		cout << "Failed to flush file '" << mFileName << "' to disc\n";
+		return false;
+	}
+
+	return true;
+}
+
+#else
+
+bool MappedFile::open(string fileName, bool writable)
+{
+	close();
+
+	mFileName = fileName;
+
+	mFd = ::open(fileName.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (mFd < 0) {
+		cout << "couldn't open file '" << fileName << "'\n";
+		return false;
+	}
+
+	if (!map()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MappedFile::map()
+{
+	struct stat sb;
+	if (fstat(mFd, &sb) != 0) {
+		cout << "couldn't get the size of file '" << mFileName << "'\n";
+		return false;
+	}
+	mSize = (size_t) sb.st_size;
+
+	// An empty file can't be mapped
+	if (mSize == 0)
+		return true;
+
+	void* data = mmap(NULL, mSize, PROT_READ, MAP_SHARED, mFd, 0);
+	if (data == MAP_FAILED) {
+		cout << "couldn't map file '" << mFileName << "'\n";
+		return false;
+	}
+	mData = (const Byte*) data;
+
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (mData != NULL)
+		munmap((void*) mData, mSize);
+	mData = NULL;
+	mSize = 0;
+}
+
+void MappedFile::close()
+{
+	unmap();
+	if (mFd >= 0)
+		::close(mFd);
+	mFd = -1;
+}
+
+bool MappedFile::write(size_t pos, const Byte* data, size_t n)
+{
+	while (n > 0) {
+		ssize_t n_written = pwrite(mFd, data, n, (off_t) pos);
+		if (n_written <= 0) {
+			cout << "Failed to write to file '" << mFileName << "'\n";
+			return false;
+		}
+		pos += n_written;
+		data += n_written;
+		n -= n_written;
+	}
+
+	return true;
+}
+
+bool MappedFile::sync()
+{
+	if (fsync(mFd) != 0) {
+		cout << "Failed to flush file '" << mFileName << "' to disc\n";
+		return false;
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include "CommonTypes.h"
+
+using namespace std;
+
+//
+// A read-only memory mapping of a complete file.
+//
+// Gives direct access to the file's bytes without reading (copying) them into memory first - the
+// pages are loaded by the OS when accessed. Used for large container files (like MMB archives)
+// of which only parts are normally accessed.
+//
+// The mapping (and any pointer into it) is valid until the file is closed, remapped or the MappedFile destroyed.
+//
+// A file opened for update can also be modified with positioned writes. The writes go through the
+// OS's file cache and are therefore directly visible in the mapping. A write beyond the end of the
+// file extends it but the mapping is only extended when the file is remapped.
+//
+class MappedFile
+{
+
+private:
+
+	const Byte* mData = NULL;
+	size_t mSize = 0;
+
+	string mFileName;
+
+#ifdef _WIN32
+	void* mFileHandle = NULL;
+	void* mMappingHandle = NULL;
+#else
+	int mFd = -1;
+#endif
+
+	bool map();
+	void unmap();
+
+public:
+
+	MappedFile() {}
+	~MappedFile();
+
+	// A mapping can't be shared between objects
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map a file (an empty file is mapped without any data) - for update if writable is true
+	bool open(string fileName, bool writable = false);
+
+	// Unmap the file
+	void close();
+
+	// Map the file again (to include any data written beyond the previous end of the file)
+	bool remap();
+
+	// Write n bytes at a position in the file (only if opened for update)
+	bool write(size_t pos, const Byte* data, size_t n);
+
+	// Make sure all writes made so far are stored on disc before continuing
+	bool sync();
+
+	bool isOpen();
+
+	const Byte* data() { return mData; }
+
+	size_t size() { return mSize; }
+
+};
+
+#endif
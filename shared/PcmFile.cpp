@@ -22,139 +22,295 @@ string PcmFile::str4(char c[4])
     return ss.str();
 }
 
-bool PcmFile::readSamples(string fileName, Samples* &samplesP, int& sampleFreq, Logging logging)
+// Wave64 chunk GUIDs - the first four bytes are the chunk name ('riff', 'wave', 'fmt ', 'data', ...)
+// and the remaining twelve bytes are the same for all chunks except the 'riff' chunk
+static const uint8_t W64_RIFF_GUID_TAIL[12] = { 0x2e, 0x91, 0xcf, 0x11, 0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00 };
+static const uint8_t W64_CHUNK_GUID_TAIL[12] = { 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1, 0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a };
+
+// A packed little-endian 24-bit sample
+typedef struct Sample24_struct {
+    uint8_t b[3];
+} Sample24;
+
+//
+// Walk the chunks of a RIFF, RF64 or Wave64 file to get the format and location of its samples.
+//
+// Chunks other than 'fmt ', 'ds64' (RF64) and 'data' (e.g. 'LIST' and 'bext') are skipped. A data size that
+// doesn't fit the file (e.g. of a recording that was never properly closed or of a RIFF file larger than
+// 4 GB) is recalculated from the file size.
+//
+bool PcmFile::readWaveInfo(ifstream& fin, uint64_t fileSize, WaveInfo& info, Logging logging)
 {
+    char id[16];
+    fin.seekg(0);
+    if (!fin.read(id, sizeof(id))) {
+        cout << "Input file is too short to be a Wave file!\n";
+        return false;
+    }
 
-    ifstream fin(fileName, ios::in | ios::binary | ios::ate);
-
-    if (!fin) {
-        cout << "couldn't open file " << fileName << "\n";
+    bool wave64 = false;
+    uint64_t pos; // position of the next chunk
+    if ((memcmp(id, "RIFF", 4) == 0 || memcmp(id, "RF64", 4) == 0) && memcmp(id + 8, "WAVE", 4) == 0) {
+        info.container = string(id, 4);
+        pos = 12;
+    }
+    else if (memcmp(id, "riff", 4) == 0 && memcmp(id + 4, W64_RIFF_GUID_TAIL, 12) == 0) {
+        // 'riff' GUID, 64-bit file size and 'wave' GUID
+        char wave_id[16];
+        fin.seekg(24);
+        if (!fin.read(wave_id, sizeof(wave_id)) || memcmp(wave_id, "wave", 4) != 0 || memcmp(wave_id + 4, W64_CHUNK_GUID_TAIL, 12) != 0) {
+            cout << "Input file is not a valid Wave64 file!\n";
+            return false;
+        }
+        info.container = "Wave64";
+        wave64 = true;
+        pos = 40;
+    }
+    else {
+        cout << "Input file is not a RIFF, RF64 or Wave64 file!\n";
         return false;
     }
 
-    auto fin_sz = fin.tellg();
+    bool fmt_found = false;
+    bool data_found = false;
+    uint64_t ds64_data_size = 0;
+    const int chunk_hdr_size = (wave64 ? 24 : 8);
+    while (!data_found && pos + chunk_hdr_size <= fileSize) {
+        char chunk_hdr[24];
+        fin.seekg(pos);
+        if (!fin.read(chunk_hdr, chunk_hdr_size))
+            break;
+
+        string chunk_id(chunk_hdr, 4);
+        uint64_t chunk_size;
+        if (wave64) {
+            // The size of a Wave64 chunk includes its header
+            memcpy(&chunk_size, chunk_hdr + 16, 8);
+            chunk_size = (chunk_size < 24 ? 0 : chunk_size - 24);
+            if (memcmp(chunk_hdr + 4, W64_CHUNK_GUID_TAIL, 12) != 0)
+                chunk_id = ""; // not a chunk we know of
+        }
+        else {
+            uint32_t chunk_size_32;
+            memcpy(&chunk_size_32, chunk_hdr + 4, 4);
+            chunk_size = chunk_size_32;
+        }
+        uint64_t chunk_start = pos + chunk_hdr_size;
 
+        if (chunk_id == "ds64" && info.container == "RF64") {
+            // 64-bit sizes: RIFF size, data size and sample count
+            uint64_t ds64[3] = { 0, 0, 0 };
+            fin.read((char*)ds64, sizeof(ds64));
+            ds64_data_size = ds64[1];
+        }
+        else if (chunk_id == "fmt ") {
+            uint8_t fmt[26] = { 0 };
+            fin.read((char*)fmt, (streamsize) (chunk_size < sizeof(fmt) ? chunk_size : sizeof(fmt)));
+            memcpy(&info.audioFormat, fmt, 2);
+            memcpy(&info.numChannels, fmt + 2, 2);
+            memcpy(&info.sampleRate, fmt + 4, 4);
+            memcpy(&info.bitsPerSample, fmt + 14, 2);
+            if (info.audioFormat == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 26)
+                memcpy(&info.audioFormat, fmt + 24, 2);
+            fmt_found = true;
+        }
+        else if (chunk_id == "data") {
+            info.dataOffset = chunk_start;
+            info.dataSize = chunk_size;
+            if (info.container == "RF64" && chunk_size == 0xffffffff)
+                info.dataSize = ds64_data_size;
+            data_found = true;
+        }
+        else if (logging.verbose) {
+            cout << "Skipping '" << str4(chunk_hdr) << "' chunk of " << dec << chunk_size << " bytes\n";
+        }
 
-    
-    
-    CommonHeader h_head;
-    
-    fin.seekg(0);
+        // RIFF chunks are padded to an even size and Wave64 chunks to a multiple of eight bytes
+        pos = chunk_start + chunk_size;
+        pos += (wave64 ? (8 - pos % 8) % 8 : pos % 2);
+    }
 
-    // Read first part of WAV header
-    fin.read((char*)&h_head, sizeof(h_head));
+    if (!fmt_found || !data_found) {
+        cout << "Input file has no " << (fmt_found ? "'data'" : "'fmt '") << " chunk!\n";
+        return false;
+    }
 
-    // CheckType of format - should be 1 for PCM
-    if (h_head.audioFormat != 1 /* PCM */ || !(h_head.bitsPerSample == 16 || h_head.bitsPerSample == 8)) {
-        cout << "Input file has no data or is not a valid 8 or 16-bit PCM Wave file!\n";
-        fin.close();
+    bool valid_pcm = info.audioFormat == WAVE_FORMAT_PCM &&
+        (info.bitsPerSample == 8 || info.bitsPerSample == 16 || info.bitsPerSample == 24 || info.bitsPerSample == 32);
+    bool valid_float = info.audioFormat == WAVE_FORMAT_IEEE_FLOAT && (info.bitsPerSample == 32 || info.bitsPerSample == 64);
+    if (!(valid_pcm || valid_float) || info.numChannels == 0) {
+        cout << "Input file has no data or is not a valid 8, 16, 24 or 32-bit PCM or 32 or 64-bit float Wave file!\n";
         return false;
     }
 
-    // Read last part of WAV header
-    HeaderTail h_tail;
-    fin.read((char*)&h_tail, sizeof(h_tail));
+    // Check the data size against the file size
+    uint64_t available_size = fileSize - info.dataOffset;
+    bool wrapped_size = info.container == "RIFF" && available_size > info.dataSize && (available_size - info.dataSize) % 0x100000000 == 0;
+    if (info.dataSize > available_size || info.dataSize == 0 || wrapped_size) {
+        if (logging.verbose)
+            cout << "Size of data samples (" << info.dataSize << ") not consistent with file size (" << fileSize << ")!\n";
 
+        info.dataSize = available_size;
 
-    // Check sub chunk size
-    // ChunkSize = sizeof(CommonHeader) + subChunk2Size = 36 + subChunk2Size = filesize - 8
-    if (h_tail.subchunk2Size != h_head.ChunkSize - 36) {
         if (logging.verbose)
-            cout << "Size of data samples (subchunk2Size = " << h_tail.subchunk2Size <<
-                ") not consistent with file size (ChunkSize + 8 = " << (h_head.ChunkSize + 8) << ")!\n";
-        
-        // correct the chunk sizes before attempting to read the samples... 
-        h_head.ChunkSize = (uint32_t) fin_sz - 8;
-        h_tail.subchunk2Size = h_head.ChunkSize - 36;
+            cout << "Recalculating the size of the data samples to " << info.dataSize << " bytes...\n";
+    }
 
-        if (logging.verbose)
-            cout << "Recalculating the size of the data samples to " << h_head.ChunkSize << " bytes...\n";
+    return true;
+}
+
+//
+// De-interleave the samples of each channel.
+//
+// The loops copy with a fixed stride so that the compiler can vectorise them (with a special case
+// for the common stereo case where the stride is known at compile time).
+//
+template <class S, class F> static void deinterleave(
+    const S* interleaved, int nChannels, size_t nFrames, vector<Samples>& channels, size_t offset, F toSample
+)
+{
+    if (nChannels == 2) {
+        Sample* left = channels[0].data() + offset;
+        Sample* right = channels[1].data() + offset;
+        for (size_t i = 0; i < nFrames; i++) {
+            left[i] = toSample(interleaved[2 * i]);
+            right[i] = toSample(interleaved[2 * i + 1]);
+        }
+        return;
     }
+    for (int c = 0; c < nChannels; c++) {
+        Sample* channel = channels[c].data() + offset;
+        const S* src = interleaved + c;
+        for (size_t i = 0; i < nFrames; i++)
+            channel[i] = toSample(src[i * nChannels]);
+    }
+}
 
-    // Warn if there is more than one channel with 16-bit samples and a sample frequency of 44.1 kHz
-    if (!(h_head.numChannels == 1)) {
+// Scale a floating-point sample [-1, 1] into a 16-bit sample (branch-free rounding so that it can be vectorised)
+static inline Sample floatToSample(float s)
+{
+    float v = s * 32768.0f;
+    v = (v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v));
+    return (Sample) (v + (v >= 0 ? 0.5f : -0.5f));
+}
 
-        cout << "*** WARNING***\n";
-        cout << "The input file is a multi-channel " << h_head.bitsPerSample << "-bit PCM Wave file.\n";
-        cout << "The last channel is assumed to contain the samples of interest. If this is not the case\n";
-        cout << "then please modify the file to have only one channel and try again!\n\n";
+//
+// Convert and de-interleave one block of samples into the channels (starting at sample 'offset').
+//
+// 8-bit samples are scaled into 16-bit samples whereas only the 16 most significant bits of
+// 24 and 32-bit samples are kept.
+//
+void PcmFile::convertSamples(WaveInfo& info, const char* block, size_t nFrames, vector<Samples>& channels, size_t offset)
+{
+    int n_channels = info.numChannels;
+    if (info.audioFormat == WAVE_FORMAT_IEEE_FLOAT) {
+        if (info.bitsPerSample == 32)
+            deinterleave((const float*)block, n_channels, nFrames, channels, offset, [](float s) { return floatToSample(s); });
+        else
+            deinterleave((const double*)block, n_channels, nFrames, channels, offset, [](double s) { return floatToSample((float) s); });
+        return;
+    }
 
+    switch (info.bitsPerSample) {
+    case 8:
+        deinterleave((const ByteSample*)block, n_channels, nFrames, channels, offset, [](ByteSample s) { return (Sample) (((int)s - 128) * 256); });
+        break;
+    case 16:
+        deinterleave((const Sample*)block, n_channels, nFrames, channels, offset, [](Sample s) { return s; });
+        break;
+    case 24:
+        deinterleave((const Sample24*)block, n_channels, nFrames, channels, offset, [](Sample24 s) { return (Sample) (s.b[1] | (s.b[2] << 8)); });
+        break;
+    default: // 32
+        deinterleave((const int32_t*)block, n_channels, nFrames, channels, offset, [](int32_t s) { return (Sample) (s >> 16); });
+        break;
     }
+}
 
-    // samples/channel: NumSamples * NumChannels * BitsPerSample / 8
-    int samples_per_channel = h_tail.subchunk2Size / (h_head.numChannels * h_head.bitsPerSample / 8);
-    int sample_byte_size = h_head.bitsPerSample / 8;
-    int total_n_samples = h_tail.subchunk2Size / sample_byte_size;
-    int n_sample_bytes = h_tail.subchunk2Size;
+//
+// Read the samples of each channel from a RIFF, RF64 or Wave64 file
+// (with 8, 16, 24 or 32-bit PCM samples or 32 or 64-bit float samples)
+//
+bool PcmFile::readChannels(string fileName, vector<Samples>& channels, int& sampleFreq, Logging logging)
+{
+
+    ifstream fin(fileName, ios::in | ios::binary | ios::ate);
+
+    if (!fin) {
+        cout << "couldn't open file " << fileName << "\n";
+        return false;
+    }
+
+    uint64_t fin_sz = (uint64_t) fin.tellg();
+
+    WaveInfo info;
+    if (!readWaveInfo(fin, fin_sz, info, logging)) {
+        fin.close();
+        return false;
+    }
+
+    int n_channels = info.numChannels;
+    int sample_byte_size = info.bitsPerSample / 8;
+    size_t frame_size = (size_t) n_channels * sample_byte_size;
+    size_t samples_per_channel = info.dataSize / frame_size;
     if (logging.verbose) {
-        cout << "Input file is a valid one channel " << h_head.bitsPerSample << "-bit PCM Wave file : \n";
-        cout << "format: " << h_head.audioFormat << " (1 <=> PCM)\n";
-        cout << "#channels: " << h_head.numChannels << " (1)\n";
-        cout << "sample rate: " << h_head.sampleRate << " (44 100) \n";
-        cout << "sample size: " << h_head.bitsPerSample << " (16)\n";
-        cout << "#bytes: " << n_sample_bytes << "\n";
+        cout << "Input file is a valid " << n_channels << " channel " << info.bitsPerSample << "-bit " <<
+            (info.audioFormat == WAVE_FORMAT_PCM ? "PCM" : "float") << " " << info.container << " Wave file : \n";
+        cout << "format: " << info.audioFormat << " (1 <=> PCM, 3 <=> float)\n";
+        cout << "#channels: " << info.numChannels << "\n";
+        cout << "sample rate: " << info.sampleRate << " (44 100) \n";
+        cout << "sample size: " << info.bitsPerSample << " (16)\n";
+        cout << "#bytes: " << info.dataSize << "\n";
         cout << "#samples/channel: " << samples_per_channel << "\n";
     }
 
-    sampleFreq = h_head.sampleRate;
+    sampleFreq = info.sampleRate;
 
-    // Collect all samples into a vector 'samples'
-    int n_samples = 0;
-    samplesP = new Samples(samples_per_channel);
-    if (h_head.numChannels == 1) {
-        n_samples = samples_per_channel;
-        if (sample_byte_size == 2) {
-            // Read 16-bit samples
-            Sample* samples_p = &(samplesP->front());
-            fin.read((char*)samples_p, (streamsize) n_sample_bytes);           
-        }
-        else { // sample_byte_size == 1
-            // Read 8-bit samples
-            ByteSamples byte_samples(samples_per_channel);
-            ByteSample* byte_samples_p = &byte_samples.front();
-            fin.read((char*)byte_samples_p, (streamsize)n_sample_bytes);
-            // Copy 8-bit samples into 16-bit sample vector
-            for (int i = 0; i < samples_per_channel; i++)
-                (*samplesP)[i] = (Sample) (((int)byte_samples[i] - 128) * 256); // scale from 8-bit unsigned to 16-bit signed sample}
-        }
+    // Collect the samples of each channel into a vector of its own
+    channels.assign(n_channels, Samples(samples_per_channel));
+    fin.seekg(info.dataOffset);
+    if (n_channels == 1 && info.audioFormat == WAVE_FORMAT_PCM && sample_byte_size == 2) {
+        // Read 16-bit samples directly
+        fin.read((char*)channels[0].data(), (streamsize) samples_per_channel * 2);
     }
-    else { // several channels - assume the last one shall be used and skip all the other channels       
-        if (sample_byte_size == 2) {
-            Samples channel_samples(total_n_samples);
-            Sample* channel_sample_p = &channel_samples.front();
-            fin.read((char*)channel_sample_p, (streamsize)n_sample_bytes);
-            SampleIter channel_sample_iter = channel_samples.begin();
-            while (channel_sample_iter < channel_samples.end()) {
-                // Skip samples for first channels
-                if (channel_sample_iter < channel_samples.end() - (h_head.numChannels - 1))
-                    channel_sample_iter += h_head.numChannels - 1;
-                else
-                    break;
-                // Get sample for last channel
-                (*samplesP)[n_samples++] = *channel_sample_iter++;
-            }
-        }
-        else { // sample_byte_size == 1
-            ByteSamples channel_samples(total_n_samples);
-            ByteSample* channel_sample_p = &channel_samples.front();
-            fin.read((char*)channel_sample_p, (streamsize) n_sample_bytes);
-            ByteSampleIter channel_sample_iter = channel_samples.begin();
-            while (channel_sample_iter < channel_samples.end()) {
-                // Skip samples for first channels
-                if (channel_sample_iter < channel_samples.end() - (h_head.numChannels - 1))
-                    channel_sample_iter += h_head.numChannels - 1;
-                else
-                    break;
-                // Get sample for last channel
-                (*samplesP)[n_samples++] = (Sample) (((int) *channel_sample_iter++ - 128)*256); // scale to 16-bit sample value
-            }
+    else {
+        // Read and convert the samples block by block (so that the samples are never all held in the file's format)
+        const size_t block_frames = 65536;
+        vector<uint64_t> block((block_frames * frame_size + 7) / 8); // 8-byte aligned for the largest sample type
+        for (size_t offset = 0; offset < samples_per_channel; offset += block_frames) {
+            size_t n_frames = (samples_per_channel - offset < block_frames ? samples_per_channel - offset : block_frames);
+            fin.read((char*)block.data(), (streamsize) (n_frames * frame_size));
+            convertSamples(info, (const char*)block.data(), (size_t) fin.gcount() / frame_size, channels, offset);
+            if (!fin)
+                break;
         }
     }
 
     fin.close();
 
     if (logging.verbose)
-        cout << "Read " << n_samples << "...\n";
+        cout << "Read " << samples_per_channel << " samples for each of " << n_channels << " channel(s)...\n";
+
+    return true;
+}
+
+bool PcmFile::readSamples(string fileName, Samples* &samplesP, int& sampleFreq, Logging logging)
+{
+    vector<Samples> channels;
+    if (!readChannels(fileName, channels, sampleFreq, logging))
+        return false;
+
+    // Warn if there is more than one channel
+    if (channels.size() > 1) {
+
+        cout << "*** WARNING***\n";
+        cout << "The input file is a multi-channel PCM Wave file.\n";
+        cout << "The last channel is assumed to contain the samples of interest. If this is not the case\n";
+        cout << "then please modify the file to have only one channel and try again!\n\n";
+
+    }
+
+    samplesP = new Samples(move(channels.back()));
 
     return true;
 }
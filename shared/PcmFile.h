@@ -2,6 +2,8 @@
 #define PCM_FILE_H
 
 #include <cstdint>
+#include <string>
+#include <fstream>
 #include "WaveSampleTypes.h"
 #include "Logging.h"
 
@@ -34,17 +36,48 @@ typedef struct HeaderTail_struct {
 
 } HeaderTail;
 
+// Sample formats (audioFormat) of a WAV file
+const uint16_t WAVE_FORMAT_PCM = 1;
+const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xfffe; // actual format given by the first two bytes of the sub format GUID
+
+// Format and location of the samples of a WAV file (as found when walking its chunks)
+typedef struct WaveInfo_struct {
+    string container; // "RIFF", "RF64" or "Wave64"
+    uint16_t audioFormat = WAVE_FORMAT_PCM; // WAVE_FORMAT_PCM or WAVE_FORMAT_IEEE_FLOAT
+    uint16_t numChannels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    uint64_t dataOffset = 0; // file position of the first sample
+    uint64_t dataSize = 0; // NumSamples * NumChannels * BitsPerSample/8
+} WaveInfo;
+
 class PcmFile {
 
 private:
 
     static string str4(char c[4]);
 
+    // Walk the chunks of a RIFF, RF64 or Wave64 file to get the format and location of its samples
+    static bool readWaveInfo(ifstream& fin, uint64_t fileSize, WaveInfo& info, Logging logging);
+
+    // Convert and de-interleave one block of samples into the channels (starting at sample 'offset')
+    static void convertSamples(WaveInfo& info, const char* block, size_t nFrames, vector<Samples>& channels, size_t offset);
+
 public:
 
-    // Read samples from a one channel 16-bit 44.1 kHz PCM WAW file
+    // Read samples from a one channel 16-bit 44.1 kHz PCM WAW file (only the last channel of a multi-channel file)
     static bool readSamples(string fileName, Samples* &samples, int& sampleFreq, Logging logging);
 
+    //
+    // Read the samples of each channel from a WAV file.
+    //
+    // The file can be a RIFF, RF64 or Wave64 (64-bit sizes) file with 8, 16, 24 or 32-bit PCM samples or
+    // 32 or 64-bit floating-point samples. Chunks other than 'fmt ' and 'data' are skipped. The samples
+    // are converted into 16-bit samples.
+    //
+    static bool readChannels(string fileName, vector<Samples>& channels, int& sampleFreq, Logging logging);
+
 
     // Write sample vector into a multiple channel 16-bit 44.1 kHz PCM WAW file
     static bool writeSamples(string fileName, Samples *samples[], int nChannels, int sampleFreq, Logging logging);
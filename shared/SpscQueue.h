@@ -0,0 +1,141 @@
+#pragma once
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+//
+// A bounded lock-free queue between one producer thread and one consumer thread.
+//
+// The items are kept in a ring buffer (with a power-of-two capacity) and the producer and consumer only
+// synchronise through the (acquire/release) positions of the ring buffer. Items are pushed and popped
+// in batches so that this synchronisation is amortised over many items. Neither push nor pop blocks.
+//
+// A producer (consumer) that gets nothing pushed (popped) calls waitForSpace (waitForItems). It first
+// yields a bounded no of times, which is cheap when the other thread is running on a core of its own
+// and will soon catch up. Only then does it block on a condition variable, so that it doesn't steal
+// the time from the other thread when they have to share a core. Push and pop only take the mutex
+// when the other thread is blocked.
+//
+template <class T> class SpscQueue
+{
+
+private:
+
+	vector<T> mBuffer;
+	size_t mMask;
+
+	alignas(64) atomic<size_t> mHead { 0 }; // position of the next item to pop (only written by the consumer)
+	alignas(64) atomic<size_t> mTail { 0 }; // position of the next item to push (only written by the producer)
+	alignas(64) atomic<bool> mClosed { false }; // no more items will be pushed
+	atomic<bool> mCancelled { false }; // no thread should wait any longer
+
+	// Blocking of a waiting producer or consumer
+	mutex mMutex;
+	condition_variable mCondition;
+	atomic<int> mNBlocked { 0 }; // no of threads blocked (or about to block) on mCondition
+
+	// No of times to yield before a waiting producer (consumer) blocks
+	static constexpr int mMaxSpins = 64;
+
+	// Wait until ready() is true (or the queue is cancelled) - first yielding and then blocking
+	template <class Pred> void wait(Pred ready)
+	{
+		for (int i = 0; i < mMaxSpins; i++) {
+			if (ready() || mCancelled.load(memory_order_acquire))
+				return;
+			this_thread::yield();
+		}
+
+		unique_lock<mutex> lock(mMutex);
+		mNBlocked.fetch_add(1);
+		// Pairs with the fence in wakeUp - either ready() will be true below or the other thread sees mNBlocked > 0
+		atomic_thread_fence(memory_order_seq_cst);
+		mCondition.wait(lock, [&] { return ready() || mCancelled.load(memory_order_acquire); });
+		mNBlocked.fetch_sub(1);
+	}
+
+	// Wake up a blocked producer (consumer) after items have been pushed (popped)
+	void wakeUp()
+	{
+		atomic_thread_fence(memory_order_seq_cst);
+		if (mNBlocked.load(memory_order_relaxed) > 0) {
+			lock_guard<mutex> lock(mMutex);
+			mCondition.notify_all();
+		}
+	}
+
+public:
+
+	// Create a queue with room for at least minCapacity items
+	SpscQueue(size_t minCapacity)
+	{
+		size_t capacity = 1;
+		while (capacity < minCapacity)
+			capacity *= 2;
+		mBuffer.resize(capacity);
+		mMask = capacity - 1;
+	}
+
+	// Push up to n items (returns the no of items pushed - 0 if the queue is full)
+	size_t push(const T* items, size_t n)
+	{
+		size_t tail = mTail.load(memory_order_relaxed);
+		size_t head = mHead.load(memory_order_acquire);
+		size_t free_items = mBuffer.size() - (tail - head);
+		size_t n_push = (n < free_items ? n : free_items);
+		for (size_t i = 0; i < n_push; i++)
+			mBuffer[(tail + i) & mMask] = items[i];
+		mTail.store(tail + n_push, memory_order_release);
+		if (n_push > 0)
+			wakeUp();
+		return n_push;
+	}
+
+	// Pop up to n items (returns the no of items popped - 0 if the queue is empty)
+	size_t pop(T* items, size_t n)
+	{
+		size_t head = mHead.load(memory_order_relaxed);
+		size_t tail = mTail.load(memory_order_acquire);
+		size_t n_available = tail - head;
+		size_t n_pop = (n < n_available ? n : n_available);
+		for (size_t i = 0; i < n_pop; i++)
+			items[i] = mBuffer[(head + i) & mMask];
+		mHead.store(head + n_pop, memory_order_release);
+		if (n_pop > 0)
+			wakeUp();
+		return n_pop;
+	}
+
+	// Wait until there is room for at least one item (or the queue is cancelled) - called by the producer
+	void waitForSpace()
+	{
+		wait([this] { return mTail.load(memory_order_relaxed) - mHead.load(memory_order_acquire) < mBuffer.size(); });
+	}
+
+	// Wait until there is at least one item to pop or the queue is closed (or cancelled) - called by the consumer
+	void waitForItems()
+	{
+		wait([this] { return mTail.load(memory_order_acquire) != mHead.load(memory_order_relaxed) || closed(); });
+	}
+
+	// Tell the consumer that no more items will be pushed (called by the producer)
+	void close() { mClosed.store(true, memory_order_release); wakeUp(); }
+
+	// Stop all waiting (e.g., when the consumer no longer wants any items)
+	void cancel() { mCancelled.store(true, memory_order_release); wakeUp(); }
+
+	// Check whether the producer has pushed its last item (called by the consumer before it pops the remaining items)
+	bool closed() { return mClosed.load(memory_order_acquire); }
+
+};
+
+#endif
@@ -180,7 +180,7 @@ bool TAPCodec::decodeMultipleFiles(string& tapFileName, vector<TapeFile> &tapFil
     // Read one program from the TAP file
     TapeFile TAP_file(mTargetMachine);
     while (decodeSingleFile(fin, file_size, TAP_file)) {
-        tapFiles.push_back(TAP_file);
+        tapFiles.push_back(move(TAP_file));
     }
 
     fin.close();
@@ -191,6 +191,96 @@ bool TAPCodec::decodeMultipleFiles(string& tapFileName, vector<TapeFile> &tapFil
     return true;
 }
 
+bool TAPCodec::indexFile(string& tapFileName, vector<TAPEntry>& index)
+{
+    ifstream fin(tapFileName, ios::in | ios::binary | ios::ate);
+
+    if (!fin) {
+        printf("Failed to open file '%s'!\n", tapFileName.c_str());
+        return false;
+    }
+
+    // Get file size
+    streamoff file_size = fin.tellg();
+
+    //
+    // Step from TAP header to TAP header. The no of data bytes that follow a header are the ones
+    // decodeSingleFile would read for the program, i.e., all complete blocks present in the file.
+    //
+    streamoff pos = 0;
+    while (pos != file_size) {
+
+        if (pos >= file_size - (streamoff) sizeof(ATMHdr)) {
+            cout << "Invalid TAP header detected!\n";
+            break;
+        }
+
+        // Read TAP header
+        Byte hdr[sizeof(ATMHdr)];
+        fin.seekg(pos);
+        if (!Utility::readBytes(fin, hdr, sizeof(ATMHdr)))
+            break;
+        string program_name;
+        for (int i = 0; i < 16 && hdr[i] != 0x0; program_name = program_name + (char)hdr[i++]);
+        unsigned file_load_adr = hdr[17] * 256 + hdr[16];
+        unsigned exec_adr = hdr[19] * 256 + hdr[18];
+        unsigned file_sz = hdr[21] * 256 + hdr[20];
+
+        TAPEntry entry;
+        entry.header = FileHeader(program_name, file_load_adr, exec_adr, file_sz, mTargetMachine);
+        entry.offset = pos;
+
+        // Skip the blocks
+        pos += sizeof(ATMHdr);
+        unsigned expected_block_sz = (file_sz >= 256 ? 256 : file_sz);
+        unsigned read_bytes = 0;
+        while (pos <= file_size - expected_block_sz && read_bytes < file_sz) {
+            entry.nBlocks++;
+            pos += expected_block_sz;
+            read_bytes += expected_block_sz;
+            if (read_bytes < file_sz - 256)
+                expected_block_sz = 256;
+            else
+                expected_block_sz = file_sz - read_bytes;
+        }
+
+        index.push_back(entry);
+    }
+
+    fin.close();
+
+    return true;
+}
+
+bool TAPCodec::decodeEntry(string& tapFileName, TAPEntry& entry, TapeFile& tapeFile)
+{
+    ifstream fin(tapFileName, ios::in | ios::binary | ios::ate);
+
+    if (!fin) {
+        printf("Failed to open file '%s'!\n", tapFileName.c_str());
+        return false;
+    }
+
+    // Get file size
+    streamsize file_size = fin.tellg();
+
+    // Read the program starting at its TAP header
+    fin.seekg(entry.offset);
+    bool success = decodeSingleFile(fin, file_size, tapeFile);
+
+    fin.close();
+
+    return success;
+}
+
+void TAPCodec::logEntry(TAPEntry& entry)
+{
+    // Log it as a Tape File with the indexed header and (empty) blocks
+    TapeFile tape_file(entry.header);
+    tape_file.blocks.assign(entry.nBlocks, FileBlock(entry.header.targetMachine));
+    tape_file.logFileHdr();
+}
+
 bool TAPCodec::decodeSingleFile(ifstream &fin, streamsize file_size, TapeFile &tapeFile)
 {
 
@@ -6,6 +6,7 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <ios>
 #include "CommonTypes.h"
 #include "FileBlock.h"
 #include "Logging.h"
@@ -30,6 +31,16 @@ typedef struct ATMHdr_struct {
 	Byte lenHigh; // Length in bytes of the data section (normally data is as BASIC program)
 } ATMHdr;
 
+//
+// One program of a (multi-program) TAP file as indexed from its TAP header
+//
+class TAPEntry {
+public:
+	FileHeader header;
+	streamoff offset = 0; // position of the program's TAP header in the TAP file
+	int nBlocks = 0; // no of blocks of the program's data that are present in the TAP file
+};
+
 class TAPCodec
 {
 
@@ -83,6 +94,25 @@ public:
 
 	bool decodeMultipleFiles(string& tapFileName, vector<TapeFile> &atomFiles);
 
+	/*
+	 * Index all programs of a TAP file.
+	 *
+	 * Only the TAP headers are read (the program data is skipped) so that also a TAP file with a large
+	 * collection of programs is indexed quickly. The program data is then read per program when needed
+	 * with decodeEntry.
+	 */
+	bool indexFile(string& tapFileName, vector<TAPEntry>& index);
+
+	/*
+	 * Decode one indexed program of a TAP file as TAP File structure
+	 */
+	bool decodeEntry(string& tapFileName, TAPEntry& entry, TapeFile& tapeFile);
+
+	/*
+	 * Output a catalogue line for an indexed program
+	 */
+	void logEntry(TAPEntry& entry);
+
 private:
 
 	TargetMachine mTargetMachine = ACORN_ATOM;
@@ -0,0 +1,267 @@
+#include "TapeFileMerger.h"
+#include <map>
+#include <iomanip>
+
+TapeFileMerger::TapeFileMerger(Logging logging) : mDebugInfo(logging)
+{
+
+}
+
+//
+// Merge the Tape Files of the captures (in the order of the input files) into one set of Tape Files.
+//
+bool TapeFileMerger::merge(
+	vector<vector<TapeFile>>& captures, vector<string>& captureNames, vector<TapeFile>& mergedFiles, ostream& logFile
+)
+{
+	if (captures.size() == 0)
+		return false;
+
+	vector<AlignedFile> aligned_files;
+	alignFiles(captures, aligned_files);
+
+	logFile << "\nMerging " << dec << captures.size() << " captures:\n";
+	for (int c = 0; c < captures.size(); c++)
+		logFile << "Capture " << c + 1 << " = '" << captureNames[c] << "' (" << captures[c].size() << " files)\n";
+
+	for (int i = 0; i < aligned_files.size(); i++) {
+		TapeFile merged_file;
+		mergeFile(aligned_files[i], merged_file, logFile);
+		mergedFiles.push_back(move(merged_file));
+	}
+
+	logFile << "\n" << dec << mergedFiles.size() << " files merged: " << nValidBlocks << " valid blocks, " <<
+		nVotedBlocks << " voted blocks and " << nCorruptedBlocks << " corrupted blocks\n";
+
+	return true;
+}
+
+//
+// Align the files of the captures.
+//
+// The files are kept in tape order: a file only found in a later capture is put directly after
+// the file that preceded it in that capture.
+//
+void TapeFileMerger::alignFiles(vector<vector<TapeFile>>& captures, vector<AlignedFile>& alignedFiles)
+{
+	for (int c = 0; c < captures.size(); c++) {
+		map<pair<string, uint32_t>, int> n_occurrences;
+		int prev_file = -1;
+		for (int f = 0; f < captures[c].size(); f++) {
+			TapeFile& tape_file = captures[c][f];
+			int occurrence = n_occurrences[{ tape_file.header.name, tape_file.header.loadAdr }]++;
+			int aligned_file = -1;
+			for (int i = 0; i < alignedFiles.size() && aligned_file < 0; i++) {
+				AlignedFile& a = alignedFiles[i];
+				if (a.name == tape_file.header.name && a.loadAdr == tape_file.header.loadAdr && a.occurrence == occurrence)
+					aligned_file = i;
+			}
+			if (aligned_file < 0) {
+				aligned_file = prev_file + 1;
+				AlignedFile a = { tape_file.header.name, tape_file.header.loadAdr, occurrence, {} };
+				alignedFiles.insert(alignedFiles.begin() + aligned_file, a);
+			}
+			alignedFiles[aligned_file].copies.push_back({ c, &tape_file });
+			prev_file = aligned_file;
+		}
+	}
+}
+
+//
+// Merge the copies of one file.
+//
+// The header of the merged file is taken from the first complete and uncorrupted copy (or the copy with
+// the most blocks if there is no such copy) whereas each block is merged from the copies of it.
+//
+void TapeFileMerger::mergeFile(AlignedFile& alignedFile, TapeFile& mergedFile, ostream& logFile)
+{
+	// Select the copy to take the file header from
+	TapeFile* base_file = alignedFile.copies[0].file;
+	for (int i = 0; i < alignedFile.copies.size(); i++) {
+		TapeFile* f = alignedFile.copies[i].file;
+		if (f->complete && !f->corrupted) {
+			base_file = f;
+			break;
+		}
+		if (f->blocks.size() > base_file->blocks.size())
+			base_file = f;
+	}
+	mergedFile.header = base_file->header;
+	mergedFile.validTiming = base_file->validTiming;
+	mergedFile.baudRate = base_file->baudRate;
+	mergedFile.tapeStartTime = base_file->tapeStartTime;
+	mergedFile.tapeEndTime = base_file->tapeEndTime;
+
+	logFile << "\nFile '" << alignedFile.name << "' found in capture(s)" << dec;
+	for (int i = 0; i < alignedFile.copies.size(); i++)
+		logFile << (i == 0 ? " " : ", ") << alignedFile.copies[i].capture + 1;
+	logFile << ":\n";
+
+	// Collect the copies of each block (ordered by block no)
+	map<int, vector<BlockCopy>> block_copies;
+	for (int i = 0; i < alignedFile.copies.size(); i++) {
+		TapeFile* f = alignedFile.copies[i].file;
+		for (int b = 0; b < f->blocks.size(); b++)
+			block_copies[f->blocks[b].no].push_back({ alignedFile.copies[i].capture, &f->blocks[b] });
+	}
+
+	// Get the range of block nos given by any valid first and last blocks
+	int first_block_no = -1, last_block_no = -1;
+	for (auto& entry : block_copies) {
+		for (int i = 0; i < entry.second.size(); i++) {
+			FileBlock* block = entry.second[i].block;
+			if (!block->corrupted && block->firstBlock() && first_block_no < 0)
+				first_block_no = block->no;
+			if (!block->corrupted && block->lastBlock())
+				last_block_no = block->no;
+		}
+	}
+
+	// Merge each block
+	for (auto& entry : block_copies) {
+		vector<BlockCopy>& copies = entry.second;
+
+		int valid_copy = -1;
+		for (int i = 0; i < copies.size() && valid_copy < 0; i++) {
+			if (!copies[i].block->corrupted)
+				valid_copy = i;
+		}
+
+		uint32_t load_adr = (valid_copy >= 0 ? copies[valid_copy].block->loadAdr : voteLoadAdr(copies));
+		logFile << "  Block #" << dec << entry.first << " (0x" << hex << setfill('0') << setw(4) << load_adr <<
+			setfill(' ') << dec << "): ";
+
+		// A corrupted block outside the valid first and last blocks can only be a block with a corrupted header
+		bool outside_file = (first_block_no >= 0 && entry.first < first_block_no) ||
+			(last_block_no >= 0 && entry.first > last_block_no);
+
+		if (valid_copy < 0 && outside_file) {
+			logFile << "*** skipped as outside of the file's valid first and last blocks\n";
+		}
+		else if (valid_copy >= 0) {
+			// Any corrupted copies (even with a header that disagrees with the valid copy) are dropped
+			logFile << "capture " << copies[valid_copy].capture + 1 << "\n";
+			mergedFile.blocks.push_back(move(*copies[valid_copy].block));
+			nValidBlocks++;
+		}
+		else if (copies.size() == 1) {
+			logFile << "*** capture " << copies[0].capture + 1 << " (corrupted)\n";
+			mergedFile.blocks.push_back(move(*copies[0].block));
+			nCorruptedBlocks++;
+		}
+		else {
+			FileBlock voted_block(mergedFile.header.targetMachine);
+			int n_differing_bytes = voteBlock(copies, voted_block);
+			logFile << "*** voted from captures";
+			for (int i = 0; i < copies.size(); i++)
+				logFile << (i == 0 ? " " : ", ") << copies[i].capture + 1;
+			logFile << " (" << n_differing_bytes << " of " << voted_block.data.size() << " bytes differed)\n";
+			mergedFile.blocks.push_back(move(voted_block));
+			nVotedBlocks++;
+		}
+	}
+
+	// Determine the merged file's status from its blocks
+	vector<FileBlock>& blocks = mergedFile.blocks;
+	mergedFile.complete = blocks.size() > 0 && blocks.front().firstBlock() && blocks.back().lastBlock();
+	mergedFile.corrupted = false;
+	mergedFile.header.size = 0;
+	mergedFile.header.locked = false;
+	for (int b = 0; b < blocks.size(); b++) {
+		if (b > 0 && blocks[b].no != blocks[b - 1].no + 1)
+			mergedFile.complete = false;
+		mergedFile.corrupted = mergedFile.corrupted || blocks[b].corrupted;
+		mergedFile.header.size += blocks[b].size;
+		mergedFile.header.locked = mergedFile.header.locked || blocks[b].locked;
+	}
+	if (blocks.size() > 0) {
+		mergedFile.firstBlock = blocks.front().no;
+		mergedFile.lastBlock = blocks.back().no;
+	}
+
+	if (!mergedFile.complete || mergedFile.corrupted)
+		logFile << "*";
+	else
+		logFile << " ";
+	mergedFile.logFileHdr(&logFile);
+
+	if (mDebugInfo.verbose) {
+		cout << "Merged file '" << mergedFile.header.name << "' from " << alignedFile.copies.size() << " capture(s)" <<
+			(mergedFile.complete && !mergedFile.corrupted ? "" : " - still incomplete or corrupted") << "\n";
+	}
+}
+
+//
+// Vote the load address of a block from its copies (a tie is resolved in favour of the first copy)
+//
+uint32_t TapeFileMerger::voteLoadAdr(vector<BlockCopy>& copies)
+{
+	map<uint32_t, int> votes;
+	for (int i = 0; i < copies.size(); i++)
+		votes[copies[i].block->loadAdr]++;
+	uint32_t load_adr = copies[0].block->loadAdr;
+	for (int i = 0; i < copies.size(); i++) {
+		if (votes[copies[i].block->loadAdr] > votes[load_adr])
+			load_adr = copies[i].block->loadAdr;
+	}
+	return load_adr;
+}
+
+//
+// Vote a block byte by byte from its copies.
+//
+// The copies' headers can be corrupted too, so the load address is first voted from all copies.
+// Only copies with the voted load address and
+// with the block's size (as given by the block header) then take part in the vote of the data. The
+// header (and timing) of the voted block is taken from the first of these copies and a byte that is
+// tied between several values is also taken from the first copy with one of them.
+//
+int TapeFileMerger::voteBlock(vector<BlockCopy>& copies, FileBlock& block)
+{
+	uint32_t load_adr = voteLoadAdr(copies);
+
+	vector<FileBlock*> voters;
+	FileBlock* first_copy = NULL;
+	for (int i = 0; i < copies.size(); i++) {
+		FileBlock* copy = copies[i].block;
+		if (copy->loadAdr != load_adr)
+			continue;
+		if (first_copy == NULL)
+			first_copy = copy;
+		if (copy->data.size() == copy->size)
+			voters.push_back(copy);
+	}
+	if (voters.size() == 0)
+		voters.push_back(first_copy);
+
+	block = move(*voters[0]);
+	block.corrupted = true;
+	voters[0] = &block;
+
+	int n_differing_bytes = 0;
+	for (int pos = 0; pos < block.data.size(); pos++) {
+		Byte best_byte = block.data[pos];
+		int best_votes = 0;
+		bool differing = false;
+		for (int i = 0; i < voters.size(); i++) {
+			if (pos >= voters[i]->data.size())
+				continue;
+			Byte candidate = voters[i]->data[pos];
+			differing = differing || candidate != block.data[pos];
+			int votes = 0;
+			for (int j = 0; j < voters.size(); j++) {
+				if (pos < voters[j]->data.size() && voters[j]->data[pos] == candidate)
+					votes++;
+			}
+			if (votes > best_votes) {
+				best_votes = votes;
+				best_byte = candidate;
+			}
+		}
+		if (differing)
+			n_differing_bytes++;
+		block.data[pos] = best_byte;
+	}
+
+	return n_differing_bytes;
+}
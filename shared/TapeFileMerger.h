@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef TAPE_FILE_MERGER_H
+#define TAPE_FILE_MERGER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "FileBlock.h"
+#include "Logging.h"
+
+using namespace std;
+
+//
+// Merges the Tape Files decoded from several captures (recordings) of the same tape.
+//
+// The files of the captures are aligned by their name and load address (and by the order in which
+// files with the same name and load address appear on the tape) and the blocks of a file by their block no.
+// Each block of a merged file is then taken from the first capture with a valid (complete and CRC-correct)
+// copy of it - any corrupted copies of it are dropped even if their headers disagree with the valid copy.
+// If no capture has a valid copy, the block is instead voted from all copies of it: first the load address
+// and then byte by byte the data (of the copies with the voted load address and the expected size). A voted
+// block is still marked as corrupted as its CRC cannot be checked.
+//
+class TapeFileMerger
+{
+
+public:
+
+	int nValidBlocks = 0; // no of merged blocks taken from a valid copy
+	int nVotedBlocks = 0; // no of merged blocks voted from several (invalid) copies
+	int nCorruptedBlocks = 0; // no of merged blocks with only one (invalid) copy
+
+	TapeFileMerger(Logging logging);
+
+	//
+	// Merge the Tape Files of the captures (in the order of the input files) into one set of Tape Files.
+	//
+	// The blocks are moved from the captures' Tape Files. Which capture(s) each block was taken from is
+	// written to logFile.
+	//
+	bool merge(vector<vector<TapeFile>>& captures, vector<string>& captureNames, vector<TapeFile>& mergedFiles, ostream& logFile);
+
+private:
+
+	// A copy of a Tape File or block (in one of the captures)
+	class FileCopy {
+	public:
+		int capture;
+		TapeFile* file;
+	};
+	class BlockCopy {
+	public:
+		int capture;
+		FileBlock* block;
+	};
+
+	// A Tape File and all copies of it
+	class AlignedFile {
+	public:
+		string name;
+		uint32_t loadAdr;
+		int occurrence; // no of earlier files on the tape with the same name and load address
+		vector<FileCopy> copies;
+	};
+
+	Logging mDebugInfo;
+
+	// Align the files of the captures
+	void alignFiles(vector<vector<TapeFile>>& captures, vector<AlignedFile>& alignedFiles);
+
+	// Merge the copies of one file
+	void mergeFile(AlignedFile& alignedFile, TapeFile& mergedFile, ostream& logFile);
+
+	// Vote the load address of a block from its copies
+	uint32_t voteLoadAdr(vector<BlockCopy>& copies);
+
+	// Vote a block byte by byte from its copies (returns the no of bytes the copies disagreed on)
+	int voteBlock(vector<BlockCopy>& copies, FileBlock& block);
+
+};
+
+#endif
@@ -24,6 +24,21 @@ bool TapeReader::readBytes(Bytes &data, int n)
 	return readBytes(data, n, read_bytes);
 }
 
+// Read up to n byte frames in one go
+bool TapeReader::readFrames(int n, ByteFrames& frames)
+{
+	for (int i = 0; i < n; i++) {
+		Byte b;
+		if (!readByte(b)) {
+			if (mDebugInfo.tracing)
+				cout << "Failed to read byte #" << i << " out of " << n << " bytes at " << Utility::encodeTime(getTime()) << "\n";
+			return false;
+		}
+		frames.add(b, 100);
+	}
+	return true;
+}
+
 // Read min nMin, and up to nMax bytes, and until a terminator is encountered
 bool TapeReader::readString(string &s, int nMin, int nMax, Byte terminator, int &n)
 {
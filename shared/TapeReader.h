@@ -1,6 +1,7 @@
 #ifndef TAPE_READER_H
 #define TAPE_READER_H
 
+#include <vector>
 #include "CommonTypes.h"
 #include "FileBlock.h"
 #include "Logging.h"
@@ -14,6 +15,33 @@ enum AfterCarrierType { GAP_FOLLOWS = 0x1, HEADER_FOLLOWS = 0x2, DATA_FOLLOWS =
 		)\
 )
 
+//
+// Byte frames (start bit + data bits + stop bit) read in bulk from a tape reader.
+//
+// Apart from the bytes, the confidence in each byte's decoding is recorded. It ranges from 0 (the byte
+// could just as well have been decoded differently) to 100 (no doubt). Bytes with a confidence below
+// lowConfidence are listed as error positions.
+//
+class ByteFrames {
+
+public:
+
+	static const int lowConfidence = 50;
+
+	Bytes bytes;
+	vector<Byte> confidence; // per byte confidence [0,100]
+	vector<int> errorPositions; // indices of the bytes with low confidence
+
+	void clear() { bytes.clear(); confidence.clear(); errorPositions.clear(); }
+
+	void add(Byte byte, int byteConfidence) {
+		if (byteConfidence < lowConfidence)
+			errorPositions.push_back((int) bytes.size());
+		bytes.push_back(byte);
+		confidence.push_back((Byte) byteConfidence);
+	}
+};
+
 class TapeReader {
 
 protected:
@@ -33,6 +61,10 @@ public:
 	bool readBytes(Bytes &data, int n);
 	bool readBytes(Bytes& data, int n, int& read_bytes);
 
+	// Read up to n byte frames in one go (appended to frames). Returns false if less than n bytes could be read.
+	// The default implementation reads one byte at a time and with full confidence.
+	virtual bool readFrames(int n, ByteFrames& frames);
+
 	// Read min nMin bytes, up to nMax, and until a terminator is encountered
 	bool readString(string &bs, int nMin, int nMax, Byte terminator, int &n);
 
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cmath>
+
+#include "TransitionFinder.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+TransitionFinder::TransitionFinder(int sampleFreq, double freqThreshold, Logging logging) : mDebugInfo(logging)
+{
+	// Same limit as used by the LevelDecoder
+	mNLevelSamplesMax = (int) round((1 + freqThreshold) * sampleFreq / (F1_FREQ * 2));
+}
+
+size_t TransitionFinder::nextSignChange(const Sample* samples, size_t from, size_t end)
+{
+	size_t i = from;
+
+	// Two samples have different signs if the sign bit of their XOR is set.
+	// OR-ing the XORs of a whole block (a loop the compiler vectorises) tells whether
+	// there is any sign change within the block.
+	while (i + mBlockSize <= end) {
+		int16_t acc = 0;
+		for (int j = 0; j < mBlockSize; j++)
+			acc |= (int16_t)(samples[i + j] ^ samples[i + j - 1]);
+		if (acc < 0)
+			break;
+		i += mBlockSize;
+	}
+
+	for (; i < end; i++) {
+		if ((int16_t)(samples[i] ^ samples[i - 1]) < 0)
+			return i;
+	}
+
+	return end;
+}
+
+void TransitionFinder::scanChunk(const Sample* samples, size_t start, size_t end, HalfCycles& halfCycles)
+{
+	// A level lasts at most mNLevelSamplesMax + 2 samples before one 'no carrier' sample is inserted
+	const size_t max_level_samples = mNLevelSamplesMax + 2;
+
+	// Roughly one 1/2 cycle per F2 1/2 cycle (i.e., per mNLevelSamplesMax/2 samples)
+	halfCycles.reserve(halfCycles.size() + (end - start) / max(1, mNLevelSamplesMax / 2) + 1);
+
+	size_t pos = start;
+	while (pos < end) {
+		size_t next = nextSignChange(samples, pos + 1, end);
+		size_t n = next - pos;
+		while (n > 0) {
+			size_t n_level = min(n, max_level_samples);
+			halfCycles.push_back((uint32_t) n_level);
+			n -= n_level;
+			if (n > 0) {
+				halfCycles.push_back(1); // 'no carrier' sample
+				n--;
+			}
+		}
+		pos = next;
+	}
+}
+
+bool TransitionFinder::findHalfCycles(Samples& samples, HalfCycles& halfCycles, int nThreads)
+{
+	size_t n_samples = samples.size();
+	const Sample* s = samples.data();
+
+	halfCycles.clear();
+	if (n_samples == 0)
+		return false;
+
+	if (nThreads <= 0)
+		nThreads = WorkerPool::defaultThreads();
+	size_t n_chunks = min((size_t) nThreads, max((size_t) 1, n_samples / mMinChunkSize));
+
+	// Chunk boundaries - moved forward to the next sign change so that no run of samples
+	// with the same sign is split between two chunks
+	vector<size_t> boundaries = { 0 };
+	for (size_t c = 1; c < n_chunks; c++) {
+		size_t b = max(boundaries.back() + 1, c * n_samples / n_chunks);
+		if (b >= n_samples)
+			break;
+		b = nextSignChange(s, b, n_samples);
+		if (b >= n_samples)
+			break;
+		boundaries.push_back(b);
+	}
+	boundaries.push_back(n_samples);
+	n_chunks = boundaries.size() - 1;
+
+	if (n_chunks == 1)
+		scanChunk(s, 0, n_samples, halfCycles);
+	else {
+		vector<HalfCycles> chunk_half_cycles(n_chunks);
+		{
+			WorkerPool pool((int) n_chunks);
+			for (size_t c = 0; c < n_chunks; c++) {
+				pool.submit([this, s, &boundaries, &chunk_half_cycles, c] {
+					scanChunk(s, boundaries[c], boundaries[c + 1], chunk_half_cycles[c]);
+				});
+			}
+			pool.wait();
+		}
+		size_t n_half_cycles = 0;
+		for (size_t c = 0; c < n_chunks; c++)
+			n_half_cycles += chunk_half_cycles[c].size();
+		halfCycles.reserve(n_half_cycles);
+		for (size_t c = 0; c < n_chunks; c++)
+			halfCycles.insert(halfCycles.end(), chunk_half_cycles[c].begin(), chunk_half_cycles[c].end());
+	}
+
+	// The last 1/2 cycle is never ended by a transition and is therefore not complete
+	halfCycles.pop_back();
+
+	if (mDebugInfo.verbose)
+		cout << dec << halfCycles.size() << " 1/2 cycles found in " << n_samples << " samples using " << n_chunks << " chunks\n";
+
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef TRANSITION_FINDER_H
+#define TRANSITION_FINDER_H
+
+#include <vector>
+#include <cstdint>
+#include "WaveSampleTypes.h"
+#include "Logging.h"
+
+using namespace std;
+
+//
+// Bulk extraction of 1/2 cycle durations (pulse lengths) from a sample buffer.
+//
+// Produces exactly the same 1/2 cycles as a LevelDecoder with a zero level threshold
+// feeding a WavCycleDecoder (i.e., as calling advanceHalfCycle() until the end of the samples)
+// but without the per-sample level/cycle state machines.
+//
+// With a zero level threshold the level only depends on the sign of the sample and on how long
+// it has stayed the same. A level that has stayed the same for more than the max no of samples
+// of an F1 1/2 cycle becomes 'no carrier' for one sample and then restarts. A run of samples with the same
+// sign is therefore split into 1/2 cycles independently of the samples before and after it.
+// This makes it possible to:
+//
+//	- find the sign changes block-wise (a block without any sign change is skipped with one test)
+//	- split the samples into chunks that start at sign changes and scan them in parallel, the
+//	  concatenation of the chunks' 1/2 cycles being identical to a sequential scan
+//
+class TransitionFinder
+{
+
+public:
+
+	typedef vector<uint32_t> HalfCycles;
+
+private:
+
+	Logging mDebugInfo;
+
+	int mNLevelSamplesMax; // Max no of samples of a level before it is considered to be 'no carrier' (as for the LevelDecoder)
+
+	// Minimum no of samples for a chunk to be worth scanning in a separate thread
+	const size_t mMinChunkSize = 1 << 20;
+
+	// No of samples tested at once for a sign change
+	static const int mBlockSize = 32;
+
+	// Find the first sample in [from,end) that has a different sign than the sample preceeding it (from must be > 0)
+	static size_t nextSignChange(const Sample* samples, size_t from, size_t end);
+
+	// Get the 1/2 cycles of the samples in [start,end) - start must be the start of a run of samples with the same sign
+	void scanChunk(const Sample* samples, size_t start, size_t end, HalfCycles& halfCycles);
+
+public:
+
+	TransitionFinder(int sampleFreq, double freqThreshold, Logging logging);
+
+	// Get all complete 1/2 cycles of the samples using nThreads threads (nThreads <= 0 <=> all cores)
+	bool findHalfCycles(Samples& samples, HalfCycles& halfCycles, int nThreads);
+
+};
+
+#endif
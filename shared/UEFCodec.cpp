@@ -34,6 +34,16 @@ double UEFCodec::getBaseFreq()
     return mBaseFrequency;
 }
 
+int UEFCodec::getBaudRate()
+{
+    return mBaudRate;
+}
+
+TargetMachine UEFCodec::getTargetMachine()
+{
+    return mTargetMachine;
+}
+
 bool UEFCodec::decodeFloat(Byte encoded_val[4], double& decoded_val)
 {
 
@@ -455,6 +465,7 @@ bool UEFCodec::openTapeFile(string& filePath)
     }
 
     mFirstFile = true;
+    firstBlock = true;
 
     return true;
 }
@@ -641,10 +652,15 @@ bool UEFCodec::readUefFile(string& uefFileName)
     }
 
 
-    // Read all data
-    char c;
-    while (fin.read(&c, 1))
-        mUefData.push_back(c);
+    // Read all data (in blocks rather than byte by byte)
+    const int block_sz = 65536;
+    size_t n_read = 0;
+    do {
+        mUefData.resize(n_read + block_sz);
+        fin.read((char*)&mUefData[n_read], block_sz);
+        n_read += (size_t) fin.gcount();
+    } while (fin.gcount() == block_sz);
+    mUefData.resize(n_read);
 
     // Close file
     fin.close();
@@ -660,6 +676,29 @@ bool UEFCodec::readUefFile(string& uefFileName)
 
 }
 
+bool UEFCodec::endOfChunks(size_t pos)
+{
+    return pos + sizeof(ChunkHdr) > mUefData.size();
+}
+
+bool UEFCodec::getChunk(size_t& pos, uint16_t& chunkId, uint32_t& chunkSz, const Byte*& chunkData)
+{
+    if (endOfChunks(pos))
+        return false;
+
+    const Byte* p = mUefData.data() + pos;
+    chunkId = p[0] + p[1] * 256;
+    chunkSz = p[2] + (p[3] << 8) + (p[4] << 16) + (p[5] << 24);
+    if (chunkSz > mUefData.size() - pos - sizeof(ChunkHdr)) {
+        *mFout << "UEF chunk " << hex << chunkId << " of size " << dec << chunkSz << " exceeds the end of the UEF data\n";
+        return false;
+    }
+    chunkData = p + sizeof(ChunkHdr);
+    pos += sizeof(ChunkHdr) + chunkSz;
+
+    return true;
+}
+
 bool UEFCodec::readBytes(Byte* dst, int n)
 {
     int i;
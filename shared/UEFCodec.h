@@ -89,10 +89,8 @@ public:
 
 class UEFCodec
 {
-	
-
-private:
 
+public:
 
 	//
 	// UEF header and chunk types
@@ -138,6 +136,8 @@ private:
 	(x== CARRIER_TONE_WITH_DUMMY_BYTE?"CARRIER_TONE_WITH_DUMMY_BYTE":"???")\
 		)))))))))))
 
+private:
+
 	// UEF Header
 	typedef struct UefHdr_struct {
 		char uefTag[10] = "UEF File!"; // null-terminated by compiler!
@@ -279,8 +279,6 @@ private:
 	// Methods used when reading UEF File
 	//
 
-	static bool decodeFloat(Byte encoded_val[4], double& decoded_val);
-
 	bool readBytes(Byte* dst, int n);
 
 	bool detectCarrier(double& waitingTime, double& duration1, double& duration2, bool skipData, bool acceptDummy);
@@ -389,6 +387,19 @@ public:
 
 	double getBaseFreq();
 
+	int getBaudRate();
+
+	TargetMachine getTargetMachine();
+
+	static bool decodeFloat(Byte encoded_val[4], double& decoded_val);
+
+	// Read-only access to the chunks of the UEF data read by readUefFile (without processing them):
+	// get the chunk at position pos and advance pos to the next chunk (false for a truncated chunk)
+	bool getChunk(size_t& pos, uint16_t& chunkId, uint32_t& chunkSz, const Byte*& chunkData);
+
+	// Check whether there are no more chunks from position pos of the UEF data
+	bool endOfChunks(size_t pos);
+
 	bool readFromDataChunk(int n, Bytes& data);
 	bool detectGap(double& duration1);
 	bool detectCarrierWithDummyByte(double& waitingTime, double& duration1, double& duration2);
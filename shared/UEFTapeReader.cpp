@@ -29,6 +29,19 @@ bool UEFTapeReader::readByte(Byte& byte)
 	return true;
 }
 
+// Read up to n byte frames in one go (from the data chunks)
+bool UEFTapeReader::readFrames(int n, ByteFrames& frames)
+{
+	// UEF data is exact - there is no doubt about the value of a byte
+	Bytes data;
+	bool success = mUEFCodec.readFromDataChunk(n, data);
+	for (int i = 0; i < data.size(); i++)
+		frames.add(data[i], 100);
+	if (!success && mDebugInfo.tracing)
+		cout << "Failed to read byte #" << data.size() << " out of " << n << " bytes at " << Utility::encodeTime(getTime()) << "\n";
+
+	return success;
+}
 
 // Wait for at least minCycles of carrier
 bool UEFTapeReader::waitForCarrier(int minCycles, double& waitingTime, int& cycles, AfterCarrierType afterCarrierType)
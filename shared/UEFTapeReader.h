@@ -6,7 +6,7 @@
 #include "FileBlock.h"
 #include "UEFCodec.h"
 
-class UEFTapeReader : public TapeReader {
+class UEFTapeReader final : public TapeReader {
 
 protected:
 
@@ -27,6 +27,9 @@ public:
 	// Read a byte if possible
 	bool readByte(Byte& byte);
 
+	// Read up to n byte frames in one go (from the data chunks)
+	bool readFrames(int n, ByteFrames& frames);
+
 	// Wait for at least minCycles of carrier
 	bool waitForCarrier(int minCycles, double& waitingTime, int& cycles, AfterCarrierType afterCarrierType);
 
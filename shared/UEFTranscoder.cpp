@@ -0,0 +1,414 @@
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <math.h>
+
+#include "UEFTranscoder.h"
+#include "CSWCodec.h"
+#include "WavEncoder.h"
+#include "WorkerPool.h"
+#include "Utility.h"
+
+using namespace std;
+using namespace std::filesystem;
+
+UEFTranscoder::UEFTranscoder(
+	int sampleFreq, bool useOriginalTiming, TapeProperties tapeTiming, Logging logging, TargetMachine targetMachine
+) : mSampleFreq(sampleFreq), mUseOriginalTiming(useOriginalTiming), mTapeTiming(tapeTiming), mDebugInfo(logging),
+	mTargetMachine(targetMachine)
+{
+}
+
+bool UEFTranscoder::transcode(string srcFile, string dstFile, OutputFormat outputFormat)
+{
+	UEFCodec uef_codec = UEFCodec(mDebugInfo, mTargetMachine);
+
+	// Read (and decompress) the UEF file
+	if (!uef_codec.readUefFile(srcFile)) {
+		cout << "Failed to read UEF File '" << srcFile << "'\n";
+		return false;
+	}
+
+	if (outputFormat == CSW_OUTPUT) {
+		CSWCodec CSW_codec = CSWCodec(mUseOriginalTiming, mSampleFreq, mTapeTiming, mDebugInfo, mTargetMachine);
+		if (!transcodeChunks(uef_codec, CSW_codec))
+			cout << "Failed to transcode all of UEF file '" << srcFile << "' - writing what could be transcoded\n";
+		if (!CSW_codec.writeSamples(dstFile)) {
+			cout << "Failed to write UEF data to CSW file '" << dstFile << "'\n";
+			return false;
+		}
+	}
+	else {
+		WavEncoder WAV_encoder = WavEncoder(mUseOriginalTiming, mSampleFreq, mTapeTiming, mDebugInfo, mTargetMachine);
+		if (!transcodeChunks(uef_codec, WAV_encoder))
+			cout << "Failed to transcode all of UEF file '" << srcFile << "' - writing what could be transcoded\n";
+		if (!WAV_encoder.writeSamples(dstFile)) {
+			cout << "Failed to write UEF data to WAV file '" << dstFile << "'\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool UEFTranscoder::transcode(vector<string>& srcFiles, string dstDir, OutputFormat outputFormat, int nThreads)
+{
+	string ext = (outputFormat == CSW_OUTPUT ? "csw" : "wav");
+
+	if (!exists(dstDir) && !create_directories(dstDir)) {
+		cout << "Failed to create output directory '" << dstDir << "'\n";
+		return false;
+	}
+
+	// One result per file so that the workers never write to shared state
+	vector<char> success(srcFiles.size(), false);
+
+	{
+		WorkerPool pool(nThreads);
+		for (int i = 0; i < srcFiles.size(); i++) {
+			pool.submit([this, &srcFiles, &success, &dstDir, &ext, outputFormat, i] {
+				path dst_file = path(dstDir) / path(srcFiles[i]).stem();
+				dst_file += "." + ext;
+				success[i] = transcode(srcFiles[i], dst_file.string(), outputFormat);
+			});
+		}
+		pool.wait();
+	}
+
+	int n_failed = 0;
+	for (int i = 0; i < srcFiles.size(); i++) {
+		if (!success[i]) {
+			cout << "Failed to transcode '" << srcFiles[i] << "'\n";
+			n_failed++;
+		}
+	}
+	cout << dec << srcFiles.size() - n_failed << " of " << srcFiles.size() << " UEF files transcoded into '" << dstDir << "'\n";
+
+	return (n_failed == 0);
+}
+
+vector<string> UEFTranscoder::findUEFFiles(string dirPath)
+{
+	vector<string> files;
+
+	for (auto const& dir_entry : directory_iterator(dirPath)) {
+		if (!dir_entry.is_regular_file())
+			continue;
+		string ext = dir_entry.path().extension().string();
+		transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		if (ext == ".uef")
+			files.push_back(dir_entry.path().string());
+	}
+
+	// Directory iteration order is unspecified so sort to get a deterministic order
+	sort(files.begin(), files.end());
+
+	return files;
+}
+
+template <class Encoder> bool UEFTranscoder::transcodeChunks(UEFCodec& uefCodec, Encoder& encoder)
+{
+	TargetMachine target_machine = uefCodec.getTargetMachine();
+	double base_freq = uefCodec.getBaseFreq();
+	int baud_rate = uefCodec.getBaudRate();
+	double tape_time = 0; // only used for logging
+
+	size_t pos = 0;
+	while (!uefCodec.endOfChunks(pos)) {
+
+		uint16_t chunk_id;
+		uint32_t chunk_sz;
+		const Byte* chunk;
+		if (!uefCodec.getChunk(pos, chunk_id, chunk_sz, chunk))
+			return false;
+
+		if (mDebugInfo.verbose)
+			cout << "\n" << Utility::encodeTime(tape_time) << ":\n";
+
+		switch (chunk_id) {
+
+		case UEFCodec::TARGET_CHUNK: // Target machine
+		{
+			if (chunk_sz != 1) {
+				cout << "Size of target machine chunk 0005 has an incorrect chunk size " << chunk_sz << " (should have been 1)\n";
+				return false;
+			}
+			target_machine = (TargetMachine)chunk[0];
+			if (mDebugInfo.verbose)
+				cout << "Target machine chunk 0005 of size " << chunk_sz << " and specifying target " << _TARGET_MACHINE(target_machine) << ".\n";
+			break;
+		}
+
+		case UEFCodec::IMPLICIT_DATA_BLOCK_CHUNK: // Implicit Data Block Chunk 0100; default start & stop bits
+		{
+			DataEncoding encoding = (target_machine == ACORN_ATOM ? atomDefaultDataEncoding : bbmDefaultDataEncoding);
+			if (mDebugInfo.verbose) {
+				cout << "Implicit Data Block chunk 0100 of size " << chunk_sz << ":";
+				Utility::logData(&cout, 0x0, (Byte*) chunk, (int) chunk_sz);
+			}
+			if (!encoder.writeBytes(chunk, chunk_sz, encoding))
+				return false;
+			tape_time += dataDuration(chunk_sz, encoding, baud_rate);
+			break;
+		}
+
+		case UEFCodec::EXPLICIT_TAPE_DATA_BLOCK_CHUNK: // Explicit Tape Data Block Chunk 0102
+		{
+			if (mDebugInfo.verbose) {
+				cout << "Explicit Tape Data Block chunk 0102 of size " << chunk_sz << ":";
+				Utility::logData(&cout, 0x0, (Byte*) chunk, (int) chunk_sz);
+			}
+			if (!writeExplicitDataBits(encoder, chunk, chunk_sz))
+				return false;
+			tape_time += (double) chunk_sz * 8 / baud_rate;
+			break;
+		}
+
+		case UEFCodec::DEFINED_TAPE_FORMAT_DATA_BLOCK_CHUNK: // Defined Tape Format Data Block chunk 0104
+		{
+			if (chunk_sz < 3) {
+				cout << "Size of Defined Tape Format Data Block chunk 0104 has an incorrect chunk size " << chunk_sz << " (should have been at least 3)\n";
+				return false;
+			}
+			int n_stop_bits = (chunk[2] >= 0x80 ? chunk[2] - 256 : chunk[2]);
+			DataEncoding encoding;
+			encoding.bitsPerPacket = chunk[0];
+			encoding.parity = (chunk[1] == 'N' ? Parity::NO_PAR : (chunk[1] == 'O' ? Parity::ODD : Parity::EVEN));
+			encoding.nStopBits = abs(n_stop_bits);
+			encoding.extraShortWave = (chunk[2] >= 0x80);
+			if (mDebugInfo.verbose) {
+				cout << "Defined Tape Format Data Block chunk 0104 of size " << chunk_sz << " and with encoding " <<
+					dec << (int) chunk[0] << chunk[1] << n_stop_bits << ":";
+				Utility::logData(&cout, 0x0, (Byte*) chunk + 3, (int) chunk_sz - 3);
+			}
+			if (!encoder.writeBytes(chunk + 3, chunk_sz - 3, encoding))
+				return false;
+			tape_time += dataDuration(chunk_sz - 3, encoding, baud_rate);
+			break;
+		}
+
+		case UEFCodec::CARRIER_TONE_CHUNK: // Carrier Tone Chunk 0110: duration = value / (base frequency * 2)
+		{
+			if (chunk_sz != 2) {
+				cout << "Size of Carrier tone chunk 0110 has an incorrect chunk size  " << chunk_sz << " (should have been 2)\n";
+				return false;
+			}
+			double tone_duration = double(chunk[0] + (chunk[1] << 8)) / (base_freq * 2);
+			if (mDebugInfo.verbose)
+				cout << "Carrier tone chunk 0110 of size " << chunk_sz << " and specifying a duration of " << tone_duration << " s.\n";
+			if (!encoder.writeTone(tone_duration))
+				return false;
+			tape_time += tone_duration;
+			break;
+		}
+
+		case UEFCodec::CARRIER_TONE_WITH_DUMMY_BYTE: // Carrier Chunk with dummy byte 0111: durations in carrier tone cycles
+		{
+			if (chunk_sz != 4) {
+				cout << "Size of Carrier tone with dummy byte chunk 0111 has an incorrect chunk size " << chunk_sz << " (should have been 4)\n";
+				return false;
+			}
+			int first_cycles = chunk[0] + (chunk[1] << 8);
+			int following_cycles = chunk[2] + (chunk[3] << 8);
+			double first_duration = first_cycles / (2 * base_freq);
+			double following_duration = (double)following_cycles / (2 * base_freq);
+			if (mDebugInfo.verbose)
+				cout << "Carrier tone chunk with dummy byte 0111 of size " << chunk_sz << " and specifying " << first_cycles <<
+				" cycles of carrier followed by a dummy byte 0xaa, and ending with " << following_duration << "s of carrier.\n";
+			if (
+				!encoder.writeTone(first_duration) ||
+				!encoder.writeByte(0xaa, bbmDefaultDataEncoding) ||
+				!encoder.writeTone(following_duration)
+				)
+				return false;
+			tape_time += first_duration + dataDuration(1, bbmDefaultDataEncoding, baud_rate) + following_duration;
+			break;
+		}
+
+		case UEFCodec::INTEGER_GAP_CHUNK: // Integer Gap Chunk 0112: gap = n/(2*base frequency) s
+		{
+			if (chunk_sz != 2) {
+				cout << "Size of Integer gap chunk 0112 has an incorrect chunk size  " << chunk_sz << " (should have been 2)\n";
+				return false;
+			}
+			double gap = double(chunk[0] + (chunk[1] << 8)) / (base_freq * 2);
+			if (mDebugInfo.verbose)
+				cout << "Integer gap chunk 0112 of size " << chunk_sz << " and specifying a duration of " << gap << " s.\n";
+			if (!encoder.writeGap(gap))
+				return false;
+			tape_time += gap;
+			break;
+		}
+
+		case UEFCodec::FP_GAP_CHUNK: // Floating-point gap
+		{
+			if (chunk_sz != 4) {
+				cout << "Size of Floating-point gap chunk 0116 has an incorrect chunk size " << chunk_sz << " (should have been 4)\n";
+				return false;
+			}
+			Byte encoded_gap[4] = { chunk[0], chunk[1], chunk[2], chunk[3] };
+			double gap;
+			if (!UEFCodec::decodeFloat(encoded_gap, gap)) {
+				cout << "Failed to decode IEEE 754 gap\n";
+				return false;
+			}
+			if (mDebugInfo.verbose)
+				cout << "Floating-point gap chunk 0116 of size " << chunk_sz << " and specifying a gap of " << gap << " s.\n";
+			if (!encoder.writeGap(gap))
+				return false;
+			tape_time += gap;
+			break;
+		}
+
+		case UEFCodec::BASE_FREQ_CHUNK: // Base frequency
+		{
+			if (chunk_sz != 4) {
+				cout << "Size of Base frequency chunk 0113 has an incorrect chunk size " << chunk_sz << " (should have been 4)\n";
+				return false;
+			}
+			Byte encoded_freq[4] = { chunk[0], chunk[1], chunk[2], chunk[3] };
+			if (!UEFCodec::decodeFloat(encoded_freq, base_freq)) {
+				cout << "Failed to decode IEEE 754 base frequency\n";
+				return false;
+			}
+			if (mDebugInfo.verbose)
+				cout << "Base frequency chunk 0113 of size " << chunk_sz << " and specifying a frequency of " << base_freq << ".Hz\n";
+			if (!encoder.setBaseFreq(base_freq))
+				return false;
+			break;
+		}
+
+		case UEFCodec::SECURITY_CHUNK: // Security cycles
+		{
+			if (mDebugInfo.verbose && chunk_sz >= 5) {
+				cout << "Security cycles chunk 0114 of size " << chunk_sz << " specifying " << (chunk[0] + (chunk[1] << 8) + (chunk[2] << 16));
+				cout << " with format " << chunk[3] << chunk[4] << " and cycle bytes:";
+				Utility::logData(&cout, 0x0, (Byte*) chunk + 5, (int) chunk_sz - 5);
+			}
+			if (!writeSecurityCycles(encoder, chunk, chunk_sz))
+				return false;
+			tape_time += (chunk[0] + (chunk[1] << 8) + (chunk[2] << 16)) / base_freq;
+			break;
+		}
+
+		case UEFCodec::PHASE_CHUNK: // Phase Shift Change Chunk 0115: phase shift = value
+		{
+			if (chunk_sz != 2) {
+				cout << "Size of Phase Shift change chunk 0115 has an incorrect chunk size " << chunk_sz << " (should have been 2)\n";
+				return false;
+			}
+			int phase = chunk[0] + (chunk[1] << 8);
+			if (mDebugInfo.verbose)
+				cout << "Phase change chunk 0115 of size " << chunk_sz << " and specifying a 1/2 cycle of " << phase << " degrees.\n";
+			if (!encoder.setPhase(phase))
+				return false;
+			break;
+		}
+
+		case UEFCodec::DATA_ENCODING_FORMAT_CHANGE_CHUNK: // Data Encoding Format Chunk 0117: baudrate = value
+		{
+			if (chunk_sz != 2) {
+				cout << "Size of Data Encoding Format chunk 0117 has an incorrect chunk size " << chunk_sz << " (should have been 2)\n";
+				return false;
+			}
+			baud_rate = chunk[0] + (chunk[1] << 8);
+			if (mDebugInfo.verbose)
+				cout << "Data Encoding Format chunk 0117 of size " << chunk_sz << " and baudrate of " << baud_rate << ".\n";
+			if (!encoder.setBaudRate(baud_rate))
+				return false;
+			break;
+		}
+
+		case UEFCodec::ORIGIN_CHUNK: // Origin Chunk 0000 - nothing to write
+		{
+			if (mDebugInfo.verbose)
+				cout << "Origin chunk 000 of size " << chunk_sz << " and text '" << string((const char*) chunk, chunk_sz) << "'.\n";
+			break;
+		}
+
+		default: // Unsupported chunks - nothing to write
+		{
+			if (mDebugInfo.verbose) {
+				cout << "Unsupported chunk " << chunk_id << " of size " << chunk_sz << " and with data:\n";
+				Utility::logData(&cout, 0x0, (Byte*) chunk, (int) chunk_sz);
+			}
+			break;
+		}
+		}
+	}
+
+	return true;
+}
+
+// Duration [s] of n bytes written with a data encoding at a baudrate (only used for logging)
+double UEFTranscoder::dataDuration(uint32_t nBytes, const DataEncoding& encoding, int baudRate)
+{
+	int bits_per_byte = 1 + encoding.bitsPerPacket + (encoding.parity == Parity::NO_PAR ? 0 : 1) + encoding.nStopBits;
+	return (double) nBytes * bits_per_byte / (baudRate > 0 ? baudRate : 1200);
+}
+
+//
+// The first byte of an explicit data block chunk 0102 specifies the no of unused bits
+// so that the block contains (chunk size * 8 - first byte) bits. The bits are stored
+// least significant bit first and each bit is encoded as a data bit (one or two cycles
+// of F1/F2 depending on the baudrate).
+//
+template <class Encoder> bool UEFTranscoder::writeExplicitDataBits(Encoder& encoder, const Byte* chunk, uint32_t chunkSz)
+{
+	if (chunkSz < 1) {
+		cout << "Size of Explicit Tape Data Block chunk 0102 has an incorrect chunk size " << chunkSz << " (should have been at least 1)\n";
+		return false;
+	}
+
+	uint64_t n_bits = (uint64_t) chunkSz * 8 - chunk[0];
+	uint64_t max_bits = (uint64_t)(chunkSz - 1) * 8;
+	if (n_bits > max_bits)
+		n_bits = max_bits;
+
+	const Byte* bits = chunk + 1;
+	for (uint64_t i = 0; i < n_bits; i++) {
+		if (!encoder.writeDataBit((bits[i / 8] >> (i % 8)) & 0x1))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// A security cycles chunk 0114 specifies a 24-bit no of cycles followed by the first and last
+// pulse info ('P' or 'W') and the cycles themselves encoded as one bit per cycle (most significant
+// bit first). A '1' bit is a cycle of F2 and a '0' bit a cycle of F1. If the first (last) pulse info
+// is 'P', the first (last) cycle is replaced by a single high (low) pulse.
+//
+template <class Encoder> bool UEFTranscoder::writeSecurityCycles(Encoder& encoder, const Byte* chunk, uint32_t chunkSz)
+{
+	if (chunkSz < 5) {
+		cout << "Size of Security cycles chunk 0114 has an incorrect chunk size " << chunkSz << " (should have been at least 5)\n";
+		return false;
+	}
+
+	uint32_t n_cycles = chunk[0] + (chunk[1] << 8) + (chunk[2] << 16);
+	Byte first_pulse = chunk[3];
+	Byte last_pulse = chunk[4];
+	const Byte* cycles = chunk + 5;
+
+	if ((uint64_t) n_cycles > (uint64_t)(chunkSz - 5) * 8) {
+		cout << "Security cycles chunk 0114 specifies " << n_cycles << " cycles but only has room for " << (chunkSz - 5) * 8 << "\n";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < n_cycles; i++) {
+		bool high_freq = ((cycles[i / 8] >> (7 - i % 8)) & 0x1) == 1;
+		bool ok;
+		if (i == 0 && first_pulse == 'P')
+			ok = encoder.writeSinglePulse(high_freq, Level::HighLevel);
+		else if (i == n_cycles - 1 && last_pulse == 'P')
+			ok = encoder.writeSinglePulse(high_freq, Level::LowLevel);
+		else
+			ok = encoder.writeCycle(high_freq, 1);
+		if (!ok)
+			return false;
+	}
+
+	return true;
+}
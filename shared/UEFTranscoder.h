@@ -0,0 +1,75 @@
+#pragma once
+#ifndef UEF_TRANSCODER_H
+#define UEF_TRANSCODER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "CommonTypes.h"
+#include "UEFCodec.h"
+#include "TapeProperties.h"
+#include "FileBlock.h"
+#include "Logging.h"
+
+using namespace std;
+
+//
+// Direct transcoding of UEF files into CSW or WAV files.
+//
+// Rather than iterating over UEFCodec::processChunk (which copies the data of each chunk
+// into a ChunkInfo), the chunks are parsed in place in the decompressed UEF data and
+// each supported chunk type is mapped directly onto pulses/samples in the encoder:
+//
+//	0100/0104	data block (bytes written in one go with the chunk's data encoding)
+//	0102		explicit tape data block (written bit by bit)
+//	0110/0111	carrier (with dummy byte for 0111)
+//	0112/0116	integer/floating-point gap
+//	0113		base frequency
+//	0114		security cycles
+//	0115/0117	phase shift and baudrate
+//
+// A set of UEF files can also be transcoded in parallel with one file per worker thread.
+//
+class UEFTranscoder
+{
+
+public:
+
+	enum OutputFormat { CSW_OUTPUT, WAV_OUTPUT };
+
+private:
+
+	int mSampleFreq = 44100;
+	bool mUseOriginalTiming = false;
+	TapeProperties mTapeTiming;
+	Logging mDebugInfo;
+	TargetMachine mTargetMachine = UNKNOWN_TARGET;
+
+	// Transcode all chunks of a UEF file already read by the UEF codec
+	template <class Encoder> bool transcodeChunks(UEFCodec& uefCodec, Encoder& encoder);
+
+	// Duration of data bytes (only used for logging)
+	static double dataDuration(uint32_t nBytes, const DataEncoding& encoding, int baudRate);
+
+	// Write a UEF chunk 0114 security cycles sequence
+	template <class Encoder> bool writeSecurityCycles(Encoder& encoder, const Byte* chunk, uint32_t chunkSz);
+
+	// Write a UEF chunk 0102 explicit tape data block
+	template <class Encoder> bool writeExplicitDataBits(Encoder& encoder, const Byte* chunk, uint32_t chunkSz);
+
+public:
+
+	UEFTranscoder(int sampleFreq, bool useOriginalTiming, TapeProperties tapeTiming, Logging logging, TargetMachine targetMachine);
+
+	// Transcode one UEF file into a CSW or WAV file
+	bool transcode(string srcFile, string dstFile, OutputFormat outputFormat);
+
+	// Transcode a set of UEF files into a directory using nThreads workers (nThreads <= 0 <=> all cores)
+	bool transcode(vector<string>& srcFiles, string dstDir, OutputFormat outputFormat, int nThreads);
+
+	// Get all UEF files (*.uef) in a directory
+	static vector<string> findUEFFiles(string dirPath);
+
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <cmath>
 #include <cstdint>
 #include <string>
+#include <cstring>
 
 /*
 * Create a valid DOS/Linux/MacOs filename from a disc or tape program name.
@@ -334,14 +335,18 @@ void Utility::logData(int address, Byte* data, int sz)
 }
 void Utility::logData(ostream * fout, int address, Byte* data, int sz)
 {
+    char line[hexDumpLineMaxLen + 1];
+    uint32_t a = address;
+
+    for (int i = 0; i < sz; i += 16) {
+        int line_sz = (sz - i < 16 ? sz - i : 16);
+        line[0] = '\n';
+        int line_len = 1 + hexDumpLine(line + 1, a, data + i, line_sz);
+        fout->write(line, line_len);
+        a += line_sz;
+    }
 
-    vector<Byte> bytes;
-    for (int i = 0; i < sz; i++)
-        bytes.push_back(*(data+i));
-    BytesIter bi = bytes.begin();
-
-    Utility::logData(fout, address, bi, sz);
-
+    *fout << "\n";
 }
 void Utility::logData(int address, BytesIter& data_iter, int data_sz) {
 
@@ -349,37 +354,37 @@ void Utility::logData(int address, BytesIter& data_iter, int data_sz) {
 }
 void Utility::logData(ostream *fout, int address, BytesIter &data_iter, int data_sz) {
 
-    BytesIter di = data_iter;
-    BytesIter di_16 = data_iter;
-    int a = address;
-    bool new_line = true;
-    int line_sz;
-
-    for (int i = 0; i < data_sz; i++) {
-        if (new_line) {   
-            new_line = false;
-            line_sz = (i > data_sz - 16 ? data_sz - i : 16);
-            *fout << "\n" << hex << setw(4) << setfill('0') << (int) a << " ";
-        }
-        *fout << hex << setw(2) << setfill('0') << (int) *di++ << " ";
-
-        if (i % 16 == line_sz - 1) {
-            new_line = true;
-            for (int k = 0; k < 16 - line_sz; k++)
-                *fout << "   ";
-            *fout << " ";
-            for (int j = i; j < i + line_sz; j++) {
-                if (*di_16 >= 0x20 && *di_16 <= 0x7e)
-                    *fout << (char)*di_16;
-                else
-                    *fout << ".";
-                di_16++;
-            }
-            a += line_sz;
-            di_16 = di;
-        }
+    logData(fout, address, data_sz > 0 ? &*data_iter : NULL, data_sz);
+}
 
+int Utility::hexDumpLine(char* line, uint32_t address, const Byte* data, int n)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    // Address with at least four digits
+    int len = 0;
+    int n_adr_digits = 4;
+    while (n_adr_digits < 8 && (address >> (4 * n_adr_digits)) != 0)
+        n_adr_digits++;
+    for (int d = n_adr_digits - 1; d >= 0; d--)
+        line[len++] = hex_digits[(address >> (4 * d)) & 0xf];
+    line[len++] = ' ';
+
+    // Byte values
+    for (int i = 0; i < n; i++) {
+        line[len++] = hex_digits[data[i] >> 4];
+        line[len++] = hex_digits[data[i] & 0xf];
+        line[len++] = ' ';
     }
 
-    *fout << "\n";
+    // Padding (for a short line) so that the ASCII column is aligned with the one of full lines
+    int n_padding = 1 + (16 - n) * 3;
+    memset(line + len, ' ', n_padding);
+    len += n_padding;
+
+    // Bytes as ASCII
+    for (int i = 0; i < n; i++)
+        line[len++] = (data[i] >= 0x20 && data[i] <= 0x7e ? (char) data[i] : '.');
+
+    return len;
 }
\ No newline at end of file
@@ -42,6 +42,11 @@ public:
     static void logData(ostream *fout, int address, BytesIter& data_iter, int data_sz);
     static void logData(ostream *fout, int address, Byte* data, int sz);
 
+    // Format one hex dump line '<address> <up to 16 byte values> <ASCII>' (without any newline) and return its length.
+    // The line buffer must have room for at least hexDumpLineMaxLen chars.
+    static const int hexDumpLineMaxLen = 8 + 1 + 16 * 3 + 1 + 16;
+    static int hexDumpLine(char* line, uint32_t address, const Byte* data, int n);
+
     static double decodeTime(string time);
     static string encodeTime(double time);
 
@@ -17,6 +17,7 @@ WavCycleDecoder::WavCycleDecoder(
 
 	
 	mHalfCycle = { Frequency::NoCarrierFrequency, Level::NoCarrierLevel, 0, 0 };
+	mHalfCycle.transitionPos = mLevelDecoder.getSampleNo();
 
 }
 
@@ -53,187 +54,53 @@ bool WavCycleDecoder::regretCheckpoint()
 	return true;
 }
 
-//
-// Find a window with [minthresholdCycles, maxThresholdCycles] 1/2 cycles and starting with an
-// 1/2 cycle of frequency type f.
-//
-bool WavCycleDecoder::detectWindow(Frequency f, int nSamples, int minThresholdCycles, int maxThresholdCycles, int & nHalfCycles)
-{
-
-	mHalfCycle.freq = Frequency::UndefinedFrequency;
-
-	nHalfCycles = 0;
-	int n = 0;
-	vector<int> half_cycle_durations;
-
-	for (; n < nSamples && !mLevelDecoder.endOfSamples(); n++) {
-
-		// Get next sample
-		bool transition;
-		if (!getNextSample(transition)) // can fail for too long level duration or end of of samples
-			return false;
-
-		// Check for a new 1/2 cycle
-		if (transition) {
-			half_cycle_durations.push_back(mHalfCycle.duration);
-			nHalfCycles++;		
-		}
-
-		// Check for a completed rolling window
-		if (n >= nSamples - 1) {
-			// Rolling window is completely filled
-			if (nHalfCycles <= minThresholdCycles || nHalfCycles >= maxThresholdCycles) {
-				// Rolling window is complete but the 1/2 cycles are not the expected
-				// => trim window from left until the next 1/2 cycle of frequency f is found
-				//    and adjust #samples in window and the 1/2 cycle count accordingly
-				bool stop = false;
-				while (!stop && half_cycle_durations.size() > 0) {
-					int d = half_cycle_durations.front();
-					half_cycle_durations.erase(half_cycle_durations.begin());
-					nHalfCycles--;
-					if (n > d) n -= d; else n = 0;
-					if (half_cycle_durations.size() > 0) {
-						d = half_cycle_durations.front();
-						if (strictValidHalfCycleRange(f, d))
-							stop = true;
-					}
-				}
-			}
-		}
-	}
-
-	return true;
-}
-
-
-// Advance n samples and record the encountered no of 1/2 cycles
-int WavCycleDecoder::countHalfCycles(
-	int nSamples, int& nHalfCycles, int& minHalfCycleDuration, int& maxHalfCycleDuration,
-	Frequency& dominatingFreq
-)
-{
-
-	nHalfCycles = 0;
-	maxHalfCycleDuration = -1;
-	minHalfCycleDuration = 99999;
-	dominatingFreq = Frequency::UndefinedFrequency;
-	int f1_cnt = 0;
-	int f2_cnt = 0;
-	bool first_half_cycle = true;
-	const int min_first_half_cycle_samples = this->mCT.mMinNSamplesF2HalfCycle / 2;
-
-	for (int n = 0; n < nSamples && !mLevelDecoder.endOfSamples(); n++) {
-
-		bool transition;
-		if (!getNextSample(transition)) // can fail for too long level duration or end of of samples
-			return false;
-
-		// Check for a new 1/2 cycle
-		if (transition) {
-
-			// Only evaluate 1/2 cycles that stretches at least min_first_half_cycle_samples into the sample window
-			if (!first_half_cycle || (first_half_cycle && n > min_first_half_cycle_samples)) {
-
-				// Check for min & max
-				if (mHalfCycle.duration > maxHalfCycleDuration)
-					maxHalfCycleDuration = mHalfCycle.duration;
-				if (mHalfCycle.duration < minHalfCycleDuration)
-					minHalfCycleDuration = mHalfCycle.duration;
-
-				// Check for dominating frequency
-				if (lastHalfCycleFrequency() == Frequency::F1)
-					f1_cnt++;
-				else if (lastHalfCycleFrequency() == Frequency::F2)
-					f2_cnt++;
-				if (f1_cnt > f2_cnt)
-					dominatingFreq = Frequency::F1;
-				else if (f2_cnt > f1_cnt)
-					dominatingFreq = Frequency::F2;
-				else
-					dominatingFreq = Frequency::UndefinedFrequency;
-			}
-
-			first_half_cycle = false;
+// Collect as many samples as possible of the same level (High or Low)
+bool WavCycleDecoder::advanceHalfCycle() {
 
-			// Count no of transitions
-			nHalfCycles++;
+	bool transition = false;
 
+	if (!mLevelDecoder.pipelined()) {
+		for (; !transition && !mLevelDecoder.endOfSamples(); ) {
+			if (!getNextSample(transition)) // can fail for too long level duration or end of of samples
+				return false;
 		}
+		return transition;
 	}
 
-	return true;
-}
-
-// Consume as many 1/2 cycles of frequency f as possible
-int WavCycleDecoder::consumeHalfCycles(Frequency f, int &nHalfCycles)
-{
-
-	nHalfCycles = 0;
-	bool stop = false;
-
-	for (;!stop;) {
-
-		if (!advanceHalfCycle())
+	// The level changes are known in advance when pipelined - jump straight to the next one
+	for (; !transition && !mLevelDecoder.endOfSamples(); ) {
+		mHalfCycle.nSamples += mLevelDecoder.skipToLevelChange();
+		if (mLevelDecoder.endOfSamples())
+			break;
+		if (!getNextSample(transition))
 			return false;
-
-		// Is it of the expected duration?
-		if (strictValidHalfCycleRange(f, mHalfCycle.duration)) {
-			nHalfCycles++;
-		}
-		else {
-			stop = true;
-		}
-		
 	}
 
-
-	return true;
+	return transition;
 }
 
-// Stop at first occurrence of n 1/2 cycles of frequency f
-int WavCycleDecoder::stopOnHalfCycles(Frequency f, int nHalfCycles, double &waitingTime)
+// Skip silence and noise up to shortly before the next possible carrier
+bool WavCycleDecoder::skipToCarrier()
 {
+	if (!mLevelDecoder.skipToCarrier())
+		return false;
 
-	double t_start = getTime();
-	double t_end;
-	int n = 0;
-
-	for (; n < nHalfCycles;) {
-
-		t_end = getTime();	
-
-		if (!advanceHalfCycle())
-			return false;
-
-		// Is it of the expected duration?\n
-;		if (mHalfCycle.freq == f) {
-			n++;
-			if (n == 1) { 
-				waitingTime = t_end - t_start;
-			}
-
-		}
-		else
-			n = 0;
-	}
+	mHalfCycle.freq = Frequency::NoCarrierFrequency;
+	mHalfCycle.level = Level::NoCarrierLevel;
+	mHalfCycle.nSamples = 0;
+	mHalfCycle.transitionPos = mLevelDecoder.getSampleNo();
 
 	return true;
 }
 
-// Collect as many samples as possible of the same level (High or Low)
-bool WavCycleDecoder::advanceHalfCycle() {
-
-	bool transition = false;
-
-	for (; !transition && !mLevelDecoder.endOfSamples(); ) {
-		if (!getNextSample(transition)) // can fail for too long level duration or end of of samples
-			return false;
-	}
-
-	return transition;
-}
-
+//
 // Get next sample and update 1/2 cycle info based on it
+//
+// The duration of a 1/2 cycle is measured both as the no of samples of the same level and as the
+// distance between the transitions' (interpolated) threshold crossings. The latter is used to classify the
+// 1/2 cycle as it doesn't jitter with the sample grid (which matters at lower sample rates where an
+// F1/F2 1/2 cycle is only a few samples long).
+//
 bool WavCycleDecoder::getNextSample(bool& transition)
 {
 	Level level, level_p;
@@ -249,7 +116,9 @@ bool WavCycleDecoder::getNextSample(bool& transition)
 
 	// Update 1/2 cycle info for a transition
 	if (level != level_p && sample_no > 0) {
-		updateHalfCycleFreq(mHalfCycle.nSamples, level_p);
+		double transition_pos = mLevelDecoder.getTransitionPos(sample_no);
+		updateHalfCycleFreq(mHalfCycle.nSamples, level_p, transition_pos - mHalfCycle.transitionPos);
+		mHalfCycle.transitionPos = transition_pos;
 		mHalfCycle.nSamples = 1; // Also count the sample that just was read above
 		transition = true;
 	}
@@ -8,7 +8,7 @@
 #include "LevelDecoder.h"
 
 
-class WavCycleDecoder : public CycleDecoder
+class WavCycleDecoder final : public CycleDecoder
 {
 
 private:
@@ -18,6 +18,8 @@ private:
 	// Get next sample and update 1/2 cycle info for a transition
 	bool getNextSample(bool& transition);
 
+	// End of samples reached?
+	bool endOfSamples() { return mLevelDecoder.endOfSamples(); }
 
 public:
 
@@ -25,25 +27,12 @@ public:
 		int sampleFreq, LevelDecoder& levelDecoder, double freqThreshold, Logging logging
 	);
 
-	// Advance n samples and record the encountered no of 1/2 cycles
-	int countHalfCycles(
-		int nSamples, int& nHalfCycles, int& minHalfCycleDuration, int& maxHalfCycleDuration,
-		Frequency& dominatingFreq
-	);
-
-	// Find a window with [minthresholdCycles, maxThresholdCycles] 1/2 cycles and starting with an
-	// 1/2 cycle of frequency type f.
-	bool detectWindow(Frequency f, int nSamples, int minThresholdCycles, int maxThresholdCycles, int& nHalfCycles);
-
-	// Consume as many 1/2 cycles of frequency f as possible
-	int consumeHalfCycles(Frequency f, int &nHalfCycles);
-
-	// Stop at first occurrence of n 1/2 cycles of frequency f
-	int stopOnHalfCycles(Frequency f, int nHalfCycles, double &waitingTime);
-
 	// Get the next 1/2 cycle (F1, F2 or unknown)
 	bool advanceHalfCycle();
 
+	// Skip silence and noise up to shortly before the next possible carrier (returns false if nothing was skipped)
+	bool skipToCarrier();
+
 
 	// Get tape time
 	double getTime();
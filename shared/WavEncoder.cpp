@@ -553,14 +553,26 @@ bool WavEncoder::writeByte(Byte byte, DataEncoding encoding)
     if (!writeStopBit(encoding))
         return false;
 
-    FileBlock block = FileBlock(mTargetMachine);
-    block.updateCRC(mCRC, byte);
+    FileBlock::updateCRC(mTargetMachine, mCRC, byte);
 
     return true;
 
 }
 
 
+bool WavEncoder::writeBytes(const Byte* bytes, size_t n, DataEncoding encoding)
+{
+    // Reserve space for the samples of all bytes up front
+    mSamples.reserve(mSamples.size() + (size_t) ceil(n * mBitTiming.F2CyclesPerByte * mBitTiming.F2Samples));
+
+    for (size_t i = 0; i < n; i++) {
+        if (!writeByte(bytes[i], encoding))
+            return false;
+    }
+
+    return true;
+}
+
 bool WavEncoder::writeDataBit(int bit)
 {
     int n_cycles;
@@ -700,6 +712,31 @@ bool WavEncoder::writeCycle(bool highFreq, unsigned n)
     return true;
 }
 
+//
+// Write a single 1/2 cycle of either F1 or F2.
+//
+// A high level pulse is the first half and a low level pulse the second half of a cycle
+// as written by writeCycle (i.e., with the same phase and amplitude).
+//
+bool WavEncoder::writeSinglePulse(bool highFreq, Level level)
+{
+    const double PI = 3.14159265358979323846;
+    int n_samples = (int) round((highFreq ? mBitTiming.F2Samples : mBitTiming.F1Samples) / 2);
+    if (n_samples == 0)
+        return false;
+
+    double half_cycle = ((mPhase + 180) % 360) * PI / 180;
+    if (level == Level::LowLevel)
+        half_cycle += PI;
+
+    double rad_step = PI / n_samples;
+    for (int s = 0; s < n_samples; s++) {
+        Sample y = (Sample) round(sin(s * rad_step + half_cycle) * mMaxSampleAmplitude);
+        mSamples.push_back(y);
+    }
+    return true;
+}
+
 bool WavEncoder::setBaseFreq(double baseFreq)
 {
     mTapeTiming.baseFreq = baseFreq;
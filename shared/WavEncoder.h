@@ -51,10 +51,12 @@ public:
 	WavEncoder(bool useOriginalTiming, int sampleFreq, TapeProperties tapeTiming, Logging logging, TargetMachine targetMachine);
 
 	bool writeByte(Byte byte, DataEncoding encoding);
+	bool writeBytes(const Byte* bytes, size_t n, DataEncoding encoding);
 	bool writeDataBit(int bit);
 	bool writeStartBit();
 	bool writeStopBit(DataEncoding encoding);
 	bool writeCycle(bool high, unsigned n);
+	bool writeSinglePulse(bool highFreq, Level level);
 	static bool writeHalfCycle(Samples& samples, Level &halfCycleLevel, int nSamples);
 	static bool writePulse(Samples& samples, Level &halfCycleLevel, int nSamples);
 	bool writeTone(double duration);
@@ -1,13 +1,17 @@
 
 #include "WavTapeReader.h"
+#include "WavCycleDecoder.h"
+#include "CSWCycleDecoder.h"
+#include "GoertzelCycleDecoder.h"
 #include "Logging.h"
 #include "Utility.h"
 #include "TapeProperties.h"
 #include <cmath>
 #include <cstdint>
+#include <algorithm>
 
-WavTapeReader::WavTapeReader(
-	CycleDecoder& cycleDecoder, double baseFreq, TapeProperties tapeTiming, TargetMachine targetMachine, Logging logging
+template <class CD> WavTapeReaderT<CD>::WavTapeReaderT(
+	CD& cycleDecoder, double baseFreq, TapeProperties tapeTiming, TargetMachine targetMachine, Logging logging
 ) : TapeReader(targetMachine, logging), mCycleDecoder(cycleDecoder),
 	mBitTiming(cycleDecoder.getSampleFreq(), baseFreq, tapeTiming.baudRate, targetMachine),
 	mTapeTiming(tapeTiming)
@@ -19,15 +23,146 @@ WavTapeReader::WavTapeReader(
 /*
  * Read a byte with bits in little endian order
 */
-bool WavTapeReader::readByte(Byte& byte)
+template <class CD> bool WavTapeReaderT<CD>::readByte(Byte& byte)
 {
 	return readByte(byte, true);
 }
 
+//
+// Read up to n byte frames in one go (with the confidence in each byte).
+//
+// The frames are first decoded from the runs of 1/2 cycles (see readFrame) with only one checkpoint for
+// all of them. If any frame can't be decoded that way with confidence, all frames are instead decoded
+// bit by bit from the no of 1/2 cycles within each bit's duration (as readByte does).
+//
+template <class CD> bool WavTapeReaderT<CD>::readFrames(int n, ByteFrames& frames)
+{
+	size_t n_prev_bytes = frames.bytes.size();
+	frames.bytes.reserve(n_prev_bytes + n);
+	frames.confidence.reserve(n_prev_bytes + n);
+
+	checkpoint();
+	int i = 0;
+	for (; i < n; i++) {
+		Byte b;
+		int confidence;
+		if (!readFrame(b, confidence) || confidence < ByteFrames::lowConfidence)
+			break;
+		frames.add(b, confidence);
+	}
+	if (i == n) {
+		regretCheckpoint();
+		return true;
+	}
+
+	if (mDebugInfo.tracing)
+		DEBUG_PRINT(getTime(), DBG, "Byte frame #%d couldn't be decoded from its 1/2 cycle runs - decoding all %d frames bit by bit\n", i, n);
+	rollback();
+	frames.bytes.resize(n_prev_bytes);
+	frames.confidence.resize(n_prev_bytes);
+
+	for (i = 0; i < n; i++) {
+		Byte b;
+		int confidence;
+		if (!readByte(b, true, confidence)) {
+			if (mDebugInfo.tracing)
+				cout << "Failed to read byte #" << i << " out of " << n << " bytes at " << Utility::encodeTime(getTime()) << "\n";
+			return false;
+		}
+		frames.add(b, confidence);
+	}
+	return true;
+}
+
+//
+// Read a byte by classifying the runs of 1/2 cycles of the same frequency as data bits.
+//
+// After the start bit, each run of F1 (F2) 1/2 cycles is split into '0' ('1') bits of the BitTiming's
+// F1 (F2) cycles per bit. A run that doesn't end on a bit boundary leaves a partial bit that is counted
+// as a bit if it is longer than half a bit. The confidence is 100 for a byte with only whole bits and
+// falls to 0 for a partial bit of exactly half a bit (or an 1/2 cycle of undefined frequency).
+//
+template <class CD> bool WavTapeReaderT<CD>::readFrame(Byte& byte, int& confidence)
+{
+	if (!getStartBit(true))
+		return false;
+
+	const int bit_half_cycles[2] = { mBitTiming.lowDataBitCycles * 2, mBitTiming.highDataBitCycles * 2 };
+
+	byte = 0;
+	confidence = 100;
+	int bit_no = 0;
+	Bit run_bit = LowBit;
+	int run_half_cycles = 0; // 1/2 cycles of the current run not yet counted as a bit
+	while (bit_no < 8) {
+		if (!mCycleDecoder.advanceHalfCycle())
+			return false;
+		Frequency f = mCycleDecoder.lastHalfCycleFrequency();
+		if (f != Frequency::F1 && f != Frequency::F2) {
+			confidence = 0;
+			return true;
+		}
+		Bit bit = (f == Frequency::F1 ? LowBit : HighBit);
+
+		// End of a run that didn't end on a bit boundary?
+		if (bit != run_bit && run_half_cycles > 0) {
+			int n = bit_half_cycles[run_bit];
+			confidence = min(confidence, 100 * abs(2 * run_half_cycles - n) / n);
+			if (2 * run_half_cycles > n)
+				byte |= run_bit << bit_no++;
+			run_half_cycles = 0;
+			if (bit_no == 8)
+				break;
+		}
+
+		run_bit = bit;
+		if (++run_half_cycles == bit_half_cycles[run_bit]) {
+			byte |= run_bit << bit_no++;
+			run_half_cycles = 0;
+		}
+	}
+
+	DEBUG_PRINT(getTime(), DBG, "Got byte %.2x from 1/2 cycle runs\n", byte);
+
+	return true;
+}
+
+// Read n bytes if possible
+template <class CD> bool WavTapeReaderT<CD>::readBytes(Bytes& data, int n, int& read_bytes)
+{
+	data.reserve(data.size() + n);
+	for (read_bytes = 0; read_bytes < n; read_bytes++) {
+		Byte b;
+		if (!readByte(b, true)) {
+			if (mDebugInfo.tracing)
+				cout << "Failed to read byte #" << read_bytes << " out of " << n << " bytes at " << Utility::encodeTime(getTime()) << "\n";
+			return false;
+		}
+		data.push_back(b);
+	}
+	return true;
+}
+
+// Read n bytes if possible
+template <class CD> bool WavTapeReaderT<CD>::readBytes(Bytes& data, int n)
+{
+	int read_bytes;
+	return readBytes(data, n, read_bytes);
+}
+
 /*
  * Read a byte with bits in little endian order
 */
-bool WavTapeReader::readByte(Byte& byte, bool restartAllowed)
+template <class CD> bool WavTapeReaderT<CD>::readByte(Byte& byte, bool restartAllowed)
+{
+	int confidence;
+	return readByte(byte, restartAllowed, confidence);
+}
+
+/*
+ * Read a byte with bits in little endian order and with the confidence of its least certain bit
+*/
+template <class CD> bool WavTapeReaderT<CD>::readByte(Byte& byte, bool restartAllowed, int& confidence)
 {
 	// Detect start bit
 	if (!getStartBit(restartAllowed)) {
@@ -39,16 +174,19 @@ bool WavTapeReader::readByte(Byte& byte, bool restartAllowed)
 
 	// Get data bits
 	byte = 0;
+	confidence = 100;
 	uint16_t f = 1;
 	for (int i = 0; i < 8; i++) {
 		Bit bit;
-		if (!getDataBit(bit)) {
+		int bit_confidence;
+		if (!getDataBit(bit, bit_confidence)) {
 			if (mDebugInfo.tracing)
 				DEBUG_PRINT(getTime(), ERR, "Failed to read data bit b%d\n", i);
 			return false;
 		}
 		byte = byte + bit * f;
 		f = f * 2;
+		confidence = min(confidence, bit_confidence);
 	}
 
 	// No need to detect stop bit as the search for a start bit in the next
@@ -63,7 +201,7 @@ bool WavTapeReader::readByte(Byte& byte, bool restartAllowed)
 }
 
 // Consume a carrier of min duration and record its duration (no waiting for carrier)
-bool WavTapeReader::consumeCarrier(double minDuration, int& detectedCycles)
+template <class CD> bool WavTapeReaderT<CD>::consumeCarrier(double minDuration, int& detectedCycles)
 {
 	double waiting_time;
 	int detected_half_cycles = 2;
@@ -85,7 +223,7 @@ bool WavTapeReader::consumeCarrier(double minDuration, int& detectedCycles)
 }
 
 // Wait for at least minCycles of carrier
-bool WavTapeReader::waitForCarrier(
+template <class CD> bool WavTapeReaderT<CD>::waitForCarrier(
 	int minCycles, double& waitingTime, int& cycles, AfterCarrierType afterCarrierType
 )
 {
@@ -96,7 +234,7 @@ bool WavTapeReader::waitForCarrier(
 }
 
 
-bool WavTapeReader::waitForCarrierWithDummyByte(
+template <class CD> bool WavTapeReaderT<CD>::waitForCarrierWithDummyByte(
 	int minCycles, double& waitingTime, int& preludeCycles, int& postludecycles, Byte& foundDummyByte, 
 	AfterCarrierType afterCarrierType, bool detectDummyByte
 )
@@ -115,7 +253,7 @@ bool WavTapeReader::waitForCarrierWithDummyByte(
 	double t_dummy_byte_start = -1;
 	double t_dummy_byte = -1;
 	preludeCycles = -1;
-	uint32_t half_cycle_duration_acc = 0;
+	double half_cycle_duration_acc = 0;
 	double t_wait_start = getTime();
 	string s;
 	bool detected_dummy_byte = false;
@@ -151,6 +289,10 @@ bool WavTapeReader::waitForCarrierWithDummyByte(
 			encountered_carrier_half_cycles = 0;
 		}
 
+		// Jump straight over silence and noise as long as no carrier has been detected
+		if (carrier_half_cycle_count == 0 && mCycleDecoder.skipToCarrier() && mDebugInfo.tracing)
+			DEBUG_PRINT(getTime(), DBG, "Skipped silence/noise up to a possible carrier%s\n", "");
+
 		// Get next 1/2 cycle
 		double t12_start = getTime();
 		checkpoint();
@@ -166,7 +308,7 @@ bool WavTapeReader::waitForCarrierWithDummyByte(
 		// Increase carrier count for F2 cycle and decrease it for F1/undefined type of 1/2 cycles
 		if (mCycleDecoder.lastHalfCycleFrequency() == Frequency::F2) {
 			carrier_half_cycle_count++;
-			int hc_d = mCycleDecoder.getHalfCycle().duration;
+			double hc_d = mCycleDecoder.getHalfCycle().exactDuration;
 			if (mCycleDecoder.strictValidHalfCycleRange(Frequency::F2, hc_d)) {
 				half_cycle_duration_acc += hc_d;
 				encountered_carrier_half_cycles++;
@@ -270,25 +412,25 @@ bool WavTapeReader::waitForCarrierWithDummyByte(
 }
 
 // Get tape time
-double WavTapeReader::getTime()
+template <class CD> double WavTapeReaderT<CD>::getTime()
 {
 	return mCycleDecoder.getTime();
 }
 
 // Save the current file position
-bool WavTapeReader::checkpoint()
+template <class CD> bool WavTapeReaderT<CD>::checkpoint()
 {
 	return mCycleDecoder.checkpoint();
 }
 
 // Roll back to a previously saved file position
-bool WavTapeReader::rollback()
+template <class CD> bool WavTapeReaderT<CD>::rollback()
 {
 	return mCycleDecoder.rollback();
 }
 
 // Remove checkpoint (without rolling back)
-bool WavTapeReader::regretCheckpoint()
+template <class CD> bool WavTapeReaderT<CD>::regretCheckpoint()
 {
 	return mCycleDecoder.regretCheckpoint();
 }
@@ -296,7 +438,7 @@ bool WavTapeReader::regretCheckpoint()
 //
 // Detect a start bit by looking for exactly mStartBitCycles low tone cycles
 //
-bool WavTapeReader::getStartBit()
+template <class CD> bool WavTapeReaderT<CD>::getStartBit()
 {
 	return getStartBit(true);
 }
@@ -307,12 +449,18 @@ bool WavTapeReader::getStartBit()
 // If restart is NOT allowed, then the first read 1/2 cycle is expected to be an F1 1/2 cycle (possibly also
 // including a previously read F1 1/2 cycle).
 //
-bool WavTapeReader::getStartBit(bool restartAllowed)
+template <class CD> bool WavTapeReaderT<CD>::getStartBit(bool restartAllowed)
 {
 
 	mDataSamples = 0.0;
 	mBitNo = 0;
 
+	// Follow any change of the carrier frequency tracked by the cycle decoder (wow & flutter)
+	double base_freq = mCycleDecoder.carrierFreq() / 2;
+	if (base_freq != mBitTiming.baseFreq) {
+		BitTiming updated_bit_timing(mCycleDecoder.getSampleFreq(), base_freq, mTapeTiming.baudRate, mTargetMachine);
+		mBitTiming = updated_bit_timing;
+	}
 	
 	int n_remaining_start_bit_half_cycles = mBitTiming.startBitCycles * 2;
 
@@ -374,7 +522,11 @@ bool WavTapeReader::getStartBit(bool restartAllowed)
 // F1 +	4n x F2 +	F1			low first F2 => 180 degrees, high = 0 degrees		'1'						[4n-1,4n+1]
 // F12 +	4n-1 x F2 +	F12		low first F2 => 90 degrees, high => 270 degrees		'1'						4n//
 //
-bool WavTapeReader::getDataBit(Bit& bit)
+// The confidence in the bit's value is given by the two indicators it is based on: the no of 1/2 cycles
+// (below or above the '0'/'1' threshold) and the dominating frequency (F1 or F2). It is 100 if both point at
+// the bit's value, 50 if only one of them does (with the other being undecided) and 0 otherwise.
+//
+template <class CD> bool WavTapeReaderT<CD>::getDataBit(Bit& bit, int& confidence)
 {
 	int n_half_cycles;
 	int n_bit_samples = (int) (round(mDataSamples + mBitTiming.dataBitSamples) - round(mDataSamples));
@@ -404,6 +556,13 @@ bool WavTapeReader::getDataBit(Bit& bit)
 	else {
 		bit = HighBit;
 	}
+	int threshold = mBitTiming.dataBitHalfCycleBitThreshold;
+	Bit count_bit = (n_half_cycles < threshold ? LowBit : (n_half_cycles > threshold ? HighBit : UndefinedBit));
+	Bit freq_bit = (dominating_freq == Frequency::F1 ? LowBit : (dominating_freq == Frequency::F2 ? HighBit : UndefinedBit));
+	if ((count_bit != UndefinedBit && count_bit != bit) || (freq_bit != UndefinedBit && freq_bit != bit))
+		confidence = 0;
+	else
+		confidence = (count_bit == bit ? 50 : 0) + (freq_bit == bit ? 50 : 0);
 
 	if (mDebugInfo.verbose)
 		DEBUG_PRINT(getTime(), DBG,
@@ -414,7 +573,7 @@ bool WavTapeReader::getDataBit(Bit& bit)
 
 }
 
-bool WavTapeReader::getStopBit()
+template <class CD> bool WavTapeReaderT<CD>::getStopBit()
 {
 	// Get one cycle of high tone to make sure we're into stop bit before
 	// searching for a start bit for the next byte
@@ -432,13 +591,21 @@ bool WavTapeReader::getStopBit()
 }
 
 // Get phase shift
-int WavTapeReader::getPhaseShift()
+template <class CD> int WavTapeReaderT<CD>::getPhaseShift()
 {
 	return mCycleDecoder.getPhaseShift();
 }
 
 // Return carrier frequency [Hz]
-double WavTapeReader::carrierFreq()
+template <class CD> double WavTapeReaderT<CD>::carrierFreq()
 {
 	return mCycleDecoder.carrierFreq();
-}
\ No newline at end of file
+}
+
+// Polymorphic tape reader (any cycle decoder)
+template class WavTapeReaderT<CycleDecoder>;
+
+// Tape readers with the cycle decoder resolved at compile time
+template class WavTapeReaderT<WavCycleDecoder>;
+template class WavTapeReaderT<GoertzelCycleDecoder>;
+template class WavTapeReaderT<CSWCycleDecoder>;
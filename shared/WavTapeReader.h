@@ -9,14 +9,22 @@
 #include "Logging.h"
 
 
-class WavTapeReader: public TapeReader {
+//
+// Tape reader decoding bytes from the 1/2 cycles of a cycle decoder.
+//
+// The type of cycle decoder is a template parameter. With the (abstract) CycleDecoder
+// (i.e., WavTapeReader) all calls to the cycle decoder are virtual. With a concrete (final)
+// cycle decoder type, e.g. WavTapeReaderT<WavCycleDecoder>, the calls are resolved at compile time.
+// The supported instantiations are made in WavTapeReader.cpp.
+//
+template <class CD> class WavTapeReaderT final: public TapeReader {
 
 private:
 
 	double mDataSamples = 0.0;
 	int mBitNo = 0;
 
-	CycleDecoder& mCycleDecoder;
+	CD& mCycleDecoder;
 
 	BitTiming mBitTiming;
 
@@ -28,19 +36,23 @@ private:
 	bool getStartBit();
 	bool getStartBit(bool restartAllowed);
 
-	// Get a data bit
-	bool getDataBit(Bit& bit);
+	// Get a data bit (and the confidence [0,100] in its value)
+	bool getDataBit(Bit& bit, int& confidence);
 
 	// Get a stop bit
 	bool getStopBit();
 
 	// Read a byte if possible
 	bool readByte(Byte& byte, bool restartAllowed);
+	bool readByte(Byte& byte, bool restartAllowed, int& confidence);
+
+	// Read a byte by classifying the runs of 1/2 cycles of the same frequency as data bits
+	bool readFrame(Byte& byte, int& confidence);
 
 public:
 
-	WavTapeReader(
-		CycleDecoder& cycleDecoder, double baseFreq, TapeProperties tapeTiming, TargetMachine targetMachine, Logging logging
+	WavTapeReaderT(
+		CD& cycleDecoder, double baseFreq, TapeProperties tapeTiming, TargetMachine targetMachine, Logging logging
 	);
 
 
@@ -80,6 +92,16 @@ public:
 
 	// Return carrier frequency [Hz]
 	double carrierFreq();
+
+	// Read n bytes if possible (hides TapeReader::readBytes so that readByte isn't called virtually)
+	bool readBytes(Bytes& data, int n);
+	bool readBytes(Bytes& data, int n, int& read_bytes);
+
+	// Read up to n byte frames in one go (with the confidence in each byte)
+	bool readFrames(int n, ByteFrames& frames);
 };
 
+// Tape reader for any type of cycle decoder
+typedef WavTapeReaderT<CycleDecoder> WavTapeReader;
+
 #endif
\ No newline at end of file
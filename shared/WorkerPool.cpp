@@ -0,0 +1,106 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <iostream>
+#include <exception>
+
+using namespace std;
+
+WorkerPool::WorkerPool(int nThreads)
+{
+    if (nThreads <= 0)
+        nThreads = defaultThreads();
+
+    for (int i = 0; i < nThreads; i++)
+        mWorkers.push_back(thread(&WorkerPool::work, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        unique_lock<mutex> lock(mMutex);
+        mStop = true;
+    }
+    mJobAvailable.notify_all();
+
+    for (int i = 0; i < mWorkers.size(); i++)
+        mWorkers[i].join();
+}
+
+int WorkerPool::defaultThreads()
+{
+    int n = (int) thread::hardware_concurrency();
+    return (n > 0 ? n : 1);
+}
+
+void WorkerPool::submit(Job job)
+{
+    {
+        unique_lock<mutex> lock(mMutex);
+        mJobs.push(job);
+    }
+    mJobAvailable.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    unique_lock<mutex> lock(mMutex);
+    mJobsDone.wait(lock, [this] { return mJobs.empty() && mBusyWorkers == 0; });
+}
+
+// Worker thread loop - execute jobs until the pool is stopped and there are no more jobs
+void WorkerPool::work()
+{
+    for (;;) {
+        Job job;
+        {
+            unique_lock<mutex> lock(mMutex);
+            mJobAvailable.wait(lock, [this] { return mStop || !mJobs.empty(); });
+            if (mJobs.empty())
+                return; // stopped and nothing left to do
+            job = mJobs.front();
+            mJobs.pop();
+            mBusyWorkers++;
+        }
+
+        // An exception must neither terminate the process nor leave the worker counted as busy:
+        // report it and treat it as a failed job (whose result is then never set)
+        try {
+            job();
+        }
+        catch (const exception& e) {
+            unique_lock<mutex> lock(mMutex);
+            cout << "Job failed: " << e.what() << "\n";
+        }
+        catch (...) {
+            unique_lock<mutex> lock(mMutex);
+            cout << "Job failed with an unknown exception\n";
+        }
+
+        {
+            unique_lock<mutex> lock(mMutex);
+            mBusyWorkers--;
+            if (mJobs.empty() && mBusyWorkers == 0)
+                mJobsDone.notify_all();
+        }
+    }
+}
+
+MemoryBudget::MemoryBudget(size_t maxBytes) : mMaxBytes(maxBytes)
+{
+}
+
+void MemoryBudget::acquire(size_t nBytes)
+{
+    unique_lock<mutex> lock(mMutex);
+    mReleased.wait(lock, [this, nBytes] { return mBytesInUse == 0 || mBytesInUse + nBytes <= mMaxBytes; });
+    mBytesInUse += nBytes;
+}
+
+void MemoryBudget::release(size_t nBytes)
+{
+    {
+        unique_lock<mutex> lock(mMutex);
+        mBytesInUse -= min(nBytes, mBytesInUse);
+    }
+    mReleased.notify_all();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+//
+// A fixed-size pool of worker threads executing queued jobs.
+//
+// Used by the batch modes of the utilities to process many input files within
+// one process. Jobs must not share codec instances - each job is expected to
+// create its own encoders/decoders. An exception thrown by a job is caught and
+// reported by the worker so the job is treated as failed (its result is left unset).
+//
+class WorkerPool {
+
+public:
+
+	typedef function<void()> Job;
+
+private:
+
+	vector<thread> mWorkers;
+	queue<Job> mJobs;
+
+	mutex mMutex;
+	condition_variable mJobAvailable;
+	condition_variable mJobsDone;
+
+	int mBusyWorkers = 0;
+	bool mStop = false;
+
+	void work();
+
+public:
+
+	// Create a pool of nThreads workers (nThreads <= 0 <=> one worker per hardware thread)
+	WorkerPool(int nThreads);
+
+	// Complete all queued jobs and then stop the workers
+	~WorkerPool();
+
+	// Queue a job for execution by the first available worker
+	void submit(Job job);
+
+	// Wait until all queued jobs have been completed
+	void wait();
+
+	// No of workers in the pool
+	int size() { return (int) mWorkers.size(); }
+
+	// Default no of workers (i.e., the no of hardware threads)
+	static int defaultThreads();
+
+};
+
+//
+// A memory budget shared by the jobs of a worker pool.
+//
+// A job acquires its (estimated) memory need before it starts and releases it when done.
+// If the budget would be exceeded, the job waits until enough memory has been released.
+// A job is always allowed to start when no other job holds any memory (even if it alone
+// exceeds the budget) so that it never waits forever.
+//
+class MemoryBudget {
+
+private:
+
+	size_t mMaxBytes;
+	size_t mBytesInUse = 0;
+
+	mutex mMutex;
+	condition_variable mReleased;
+
+public:
+
+	MemoryBudget(size_t maxBytes);
+
+	// Wait until nBytes can be taken from the budget and then take them
+	void acquire(size_t nBytes);
+
+	// Return nBytes to the budget
+	void release(size_t nBytes);
+
+};
+
+//
+// Memory taken from a memory budget for as long as the reservation exists
+// (so that it is returned also when a job ends with an exception).
+//
+class MemoryReservation {
+
+private:
+
+	MemoryBudget& mBudget;
+	size_t mBytes;
+
+public:
+
+	MemoryReservation(MemoryBudget& budget, size_t nBytes) : mBudget(budget), mBytes(nBytes) { mBudget.acquire(mBytes); }
+
+	~MemoryReservation() { mBudget.release(mBytes); }
+
+	MemoryReservation(const MemoryReservation&) = delete;
+	MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+};
+
+#endif
@@ -14,14 +14,17 @@ bool ArgParser::failed()
 
 void ArgParser::printUsage(const char *name)
 {
-	cout << "Generates a CSW file from a UEF file.\n\n"; 
-	cout << "Usage:\t" << name << " <UEF file> [-pot] [-f <sample freq>] [-v] [-bbm] [-o <output file]\n";
+	cout << "Generates a CSW file from a UEF file (or CSW files from a directory of UEF files).\n\n"; 
+	cout << "Usage:\t" << name << " <UEF file | UEF dir> [-pot] [-f <sample freq>] [-v] [-bbm] [-j <threads>] [-o <output file | output dir>]\n";
 	cout << "<UEF file>:\n\tUEF file to decode\n\n";
+	cout << "<UEF dir>:\n\tDirectory with UEF files (*.uef) to decode - one CSW file per UEF file is created in the output directory\n\n";
+	cout << "-j <threads>:\n\tNo of UEF files to decode in parallel when decoding a directory - default is one per hardware thread\n\n";
 	cout << "-pot:\n\tPreserve original tape timing when generating the CSW file - default is " << mPreserveOriginalTiming << "\n\n";
 	cout << "-f <sample freq>:\n\tSample frequency to use - default is " << mSampleFreq << "\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
 	cout << "If no output file is specified, the output file name will default to the\n";
-	cout << "input file name (excluding extension) suffixed with '.csw'.\n\n";
+	cout << "input file name (excluding extension) suffixed with '.csw'. If no output\n";
+	cout << "directory is specified, the CSW files will be written to the UEF directory.\n\n";
 	cout << "-bbm:\nScan for BBC Micro (default is Acorn Atom)\n\n";
 	cout << "\n";
 }
@@ -35,7 +38,12 @@ ArgParser::ArgParser(int argc, const char* argv[])
 	}
 
 	srcFileName = argv[1];
-	dstFileName = Utility::crDefaultOutFileName(srcFileName, "csw");
+	if (filesystem::is_directory(srcFileName)) {
+		mBatchMode = true;
+		dstFileName = srcFileName;
+	}
+	else
+		dstFileName = Utility::crDefaultOutFileName(srcFileName, "csw");
 
 
 	int ac = 2;
@@ -77,6 +85,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 				ac++;
 			}
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				mThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-v") == 0) {
 			logging.verbose = true;
 		}
@@ -19,6 +19,8 @@ public:
 	string srcFileName;
 	bool mPreserveOriginalTiming = false;
 	int mSampleFreq = 44100;
+	bool mBatchMode = false; // Source is a directory of UEF files and destination a directory
+	int mThreads = 0; // No of worker threads in batch mode (0 <=> one per hardware thread)
 
 	Logging logging;
 	TargetMachine targetMachine = UNKNOWN_TARGET;
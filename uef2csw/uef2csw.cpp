@@ -10,8 +10,7 @@
 
 #include "../shared/CommonTypes.h"
 #include "ArgParser.h"
-#include "../shared/UEFCodec.h"
-#include "../shared/CSWCodec.h"
+#include "../shared/UEFTranscoder.h"
 
 
 using namespace std;
@@ -34,67 +33,25 @@ int main(int argc, const char* argv[])
     if (arg_parser.failed())
         return -1;
 
-    UEFCodec UEF_codec = UEFCodec(arg_parser.logging, arg_parser.targetMachine);
-
-    CSWCodec CSW_codec = CSWCodec(arg_parser.mPreserveOriginalTiming, arg_parser.mSampleFreq, arg_parser.tapeTiming,
+    UEFTranscoder transcoder = UEFTranscoder(arg_parser.mSampleFreq, arg_parser.mPreserveOriginalTiming, arg_parser.tapeTiming,
         arg_parser.logging, arg_parser.targetMachine);
 
-    // Read UEF file chunks
-    if (!UEF_codec.readUefFile(arg_parser.srcFileName)) {
-        cout << "Failed to read UEF File\n";
-        return -1;
-    }
-
-    // Iterate over read UEF file chunks aand write them to CSW file
-    ChunkInfo chunk_info;
-    while (UEF_codec.processChunk(chunk_info)) {
-        switch (chunk_info.chunkInfoType) {
-        case ChunkInfoType::CARRIER_DUMMY:
-            if (!CSW_codec.writeTone(chunk_info.data1_fp))
-                return false;
-            if (!CSW_codec.writeByte(0xaa, bbmDefaultDataEncoding))
-                return false;
-            if (!CSW_codec.writeTone((double)chunk_info.data2_i / (2 * UEF_codec.getBaseFreq())))
-                return false;
-            break;
-        case ChunkInfoType::CARRIER:
-            if (!CSW_codec.writeTone(chunk_info.data1_fp))
-                return false;
-            break;
-        case ChunkInfoType::DATA:
-            for (int i = 0; i < chunk_info.data.size(); i++) {
-               if (!CSW_codec.writeByte(chunk_info.data[i], chunk_info.dataEncoding))
-                    return false;
-            }
-            break;
-        case ChunkInfoType::GAP:
-            if (!CSW_codec.writeGap(chunk_info.data1_fp))
-                return false;
-            break;
-        case ChunkInfoType::BASE_FREQ:
-            if (!CSW_codec.setBaseFreq(chunk_info.data1_fp))
-                return false;
-            break;
-        case ChunkInfoType::BAUDRATE:
-            if (!CSW_codec.setBaudRate(chunk_info.data2_i))
-                return false;
-            break;
-        case ChunkInfoType::PHASE:
-            if (!CSW_codec.setPhase(chunk_info.data2_i))
-                return false;
-            break;
-        default:
-            break;
+    if (arg_parser.mBatchMode) {
+        // Transcode all UEF files in the directory - one file per worker thread
+        vector<string> uef_files = UEFTranscoder::findUEFFiles(arg_parser.srcFileName);
+        if (uef_files.size() == 0) {
+            cout << "No UEF files found in directory '" << arg_parser.srcFileName << "'\n";
+            return -1;
         }
+        if (!transcoder.transcode(uef_files, arg_parser.dstFileName, UEFTranscoder::CSW_OUTPUT, arg_parser.mThreads))
+            return -1;
+        return 0;
     }
 
-    if (!CSW_codec.writeSamples(arg_parser.dstFileName)) {
-        cout << "Failed to write read UEF data to WAV file\n";
+    if (!transcoder.transcode(arg_parser.srcFileName, arg_parser.dstFileName, UEFTranscoder::CSW_OUTPUT)) {
+        cout << "Failed to transcode UEF file into CSW file\n";
         return -1;
     }
 
     return 0;
 }
-
-
-
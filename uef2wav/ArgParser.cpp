@@ -14,14 +14,19 @@ bool ArgParser::failed()
 
 void ArgParser::printUsage(const char* name)
 {
-	cout << "Generates a 16-bit PCM audio WAV file from a UEF file.\n\n"; 
-	cout << "Usage:\t" << name << " <UEF file> [-o <output file] [-b <b>] [-lt <d>] [-slt <d>]\n";
+	cout << "Generates a 16-bit PCM audio WAV file from a UEF file (or WAV files from a directory of UEF files).\n\n"; 
+	cout << "Usage:\t" << name << " <UEF file | UEF dir> [-o <output file | output dir>] [-b <b>] [-lt <d>] [-slt <d>]\n";
 	cout <<	"\t[-ml <d>] [-fg <d>] [-sg <d>] [-lg <d>] [-ps <phase_shift>] [-v]\n";
-	cout << "\t[-pot] [-f <sample freq>] [-bbm] [-atm]\n\n";
+	cout << "\t[-pot] [-f <sample freq>] [-bbm] [-atm] [-j <threads>]\n\n";
 	cout << "<UEF file>:\n\tUEF file to decode\n";
 	cout << "\n";
+	cout << "<UEF dir>:\n\tDirectory with UEF files (*.uef) to decode - one WAV file per UEF file is created in the output directory\n";
+	cout << "\n";
 	cout << "If no output file is specified, the output file name will default to the\n";
-	cout << "input file name (excluding extension) suffixed with '.wav'.\n";
+	cout << "input file name (excluding extension) suffixed with '.wav'. If no output\n";
+	cout << "directory is specified, the WAV files will be written to the UEF directory.\n";
+	cout << "\n";
+	cout << "-j <threads>:\n\tNo of UEF files to decode in parallel when decoding a directory\n\t- default is one per hardware thread\n\n";
 	cout << "\n";
 	cout << "-lt <d>:\n\tThe duration of the first block's lead tone\n\t- default is " << tapeTiming.nomBlockTiming.firstBlockLeadToneDuration << " s\n\n";
 	cout << "-slt <d>:\n\tThe duration of the subsequent block's lead tone\n\t- default is " << tapeTiming.nomBlockTiming.otherBlockLeadToneDuration << " s\n\n";
@@ -49,7 +54,12 @@ ArgParser::ArgParser(int argc, const char* argv[])
 
 	srcFileName = argv[1];
 
-	dstFileName = Utility::crDefaultOutFileName(srcFileName, "wav");
+	if (filesystem::is_directory(srcFileName)) {
+		mBatchMode = true;
+		dstFileName = srcFileName;
+	}
+	else
+		dstFileName = Utility::crDefaultOutFileName(srcFileName, "wav");
 
 	int ac = 2;
 	// First search for option '-bbm' to select target machine and the
@@ -92,6 +102,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 		else if (strcmp(argv[ac], "-pot") == 0) {
 			mPreserveOriginalTiming = true;
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				mThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-v") == 0) {
 			logging.verbose = true;
 		}
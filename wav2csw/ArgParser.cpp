@@ -18,12 +18,13 @@ void ArgParser::printUsage(const char* name)
 	cout << "Made in a machine-independent way and without any filtering applied.\n";
 	cout << "If the audio file is of poor quality you should run FilterTape on it first\n";
 	cout << "before attempting to convert it to CSW format...\n\n";
-	cout << "Usage:\t" << name << " <WAV file> [-o <output file] [-v]\n";
+	cout << "Usage:\t" << name << " <WAV file> [-o <output file] [-j <threads>] [-v]\n";
 	cout << "<WAV file>:\nWAV file to decode\n";
 	cout << "\n";
 	cout << "If no output file is specified, the output file name will default to the\n";
 	cout << "input file name (excluding extension) suffixed with '.csw'.\n";
 	cout << "\n";
+	cout << "-j <threads>:\n\tNo of threads used to scan the WAV file - default is one per hardware thread\n\n";
 	cout << "-v:\n\tVerbose output\n\n";
 	cout << "\n";
 }
@@ -38,7 +39,7 @@ ArgParser::ArgParser(int argc, const char* argv[])
 
 	srcFileName = argv[1];
 
-	dstFileName = Utility::crDefaultOutFileName(srcFileName, "wav");
+	dstFileName = Utility::crDefaultOutFileName(srcFileName, "csw");
 
 	int ac = 2;
 	while (ac < argc) {
@@ -46,6 +47,15 @@ ArgParser::ArgParser(int argc, const char* argv[])
 			dstFileName = argv[ac + 1];
 			ac++;
 		}
+		else if (strcmp(argv[ac], "-j") == 0 && ac + 1 < argc) {
+			long n = strtol(argv[ac + 1], NULL, 10);
+			if (n < 0)
+				cout << "-j without a valid no of threads\n";
+			else {
+				mThreads = (int) n;
+				ac++;
+			}
+		}
 		else if (strcmp(argv[ac], "-v") == 0) {
 			logging.verbose = true;
 		}
@@ -22,6 +22,7 @@ public:
 	string srcFileName;
 	TapeProperties tapeTiming;
 	int mSampleFreq = 44100;
+	int mThreads = 0; // No of threads to scan the samples with (0 <=> one per hardware thread)
 	Logging logging;
 
 
@@ -8,9 +8,7 @@
 
 #include <math.h>
 
-#include "../shared/LevelDecoder.h"
-#include "../shared/WavCycleDecoder.h"
-#include "../shared/CSWCycleDecoder.h"
+#include "../shared/TransitionFinder.h"
 #include "../shared/CommonTypes.h"
 #include "ArgParser.h"
 #include "../shared/WavEncoder.h"
@@ -48,17 +46,13 @@ int main(int argc, const char* argv[])
         return -1;
     }
 
-    // Create Level Decoder used to filter wave form into a well-defined level stream
-    LevelDecoder level_decoder(arg_parser.mSampleFreq, *samples_p, 0.0, 0.1, 0.0, arg_parser.logging);
- 
-    // Create Cycle Decoder used to produce a cycle stream from the level stream
-    WavCycleDecoder cycle_decoder(arg_parser.mSampleFreq, level_decoder, 0.1, arg_parser.logging);
-    
-    // Write samples to buffer
-    while (cycle_decoder.advanceHalfCycle()) {
-        HalfCycleInfo half_cycle_info = cycle_decoder.getHalfCycle();
-        CSW_codec.writeHalfCycle(half_cycle_info.duration);
-    }
+    // Find all 1/2 cycles (with the same level and frequency thresholds as a LevelDecoder and WavCycleDecoder would use)
+    TransitionFinder transition_finder(arg_parser.mSampleFreq, 0.1, arg_parser.logging);
+    TransitionFinder::HalfCycles half_cycles;
+    (void) transition_finder.findHalfCycles(*samples_p, half_cycles, arg_parser.mThreads);
+
+    // Write 1/2 cycles to buffer
+    CSW_codec.writeHalfCycles(half_cycles);
 
     // Write samples to file
     if (!CSW_codec.writeSamples(arg_parser.dstFileName)) {